@@ -35,12 +35,51 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef _CLZ_H
 #define _CLZ_H
 
 #define CLZ_VERSION 2
 
+/**
+ * @brief Storage class of the functions of @ref strbuf.h, @ref dynarray.h and @ref logger.h
+ *
+ * By default the functions are ordinary external functions, emitted once by the translation unit that defines
+ * `CLZ_..._IMPL`. If the macro `CLZ_STATIC_INLINE` is defined (for the whole program), they are `static inline`
+ * instead and their implementation is compiled into every translation unit that includes the header, so that
+ * the compiler can inline and specialise small functions such as @ref strbuf_alloc_size at every call site.
+ * The `CLZ_..._IMPL` macros are not needed in this mode, and every translation unit gets its own copy of
+ * function-local state such as the logger returned by @ref logger_default.
+ */
+#ifdef CLZ_STATIC_INLINE
+#define CLZ_API static inline
+#else
+#define CLZ_API
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/**
+ * @brief Marks a function as frequently called, see the GCC attribute `hot`
+ */
+#define CLZ_HOT __attribute__((hot))
+/**
+ * @brief Marks a function as rarely called, see the GCC attribute `cold`
+ */
+#define CLZ_COLD __attribute__((cold))
+/**
+ * @brief Marks a function as taking a `printf` format string, see the GCC attribute `format`
+ *
+ * `f` is the position of the format string and `a` the position of the first format arg, counting from 1. The
+ * implicit `this` of a C++ member function counts as the first parameter.
+ */
+#define CLZ_PRINTF(f, a) __attribute__((format(printf, f, a)))
+#else
+#define CLZ_HOT
+#define CLZ_COLD
+#define CLZ_PRINTF(f, a)
+#endif
+
 #define CLZ_FIND_INDEX_START -1
 #define CLZ_NOT_FOUND -1
 #define CLZ_GENERAL_FAIL -2
@@ -63,4 +102,40 @@ typedef bool (*clz_predicate) (void *);
  */
 typedef void (*clz_consumer) (void *);
 
+/**
+ * @brief Definition of structure describing the heap memory held by a single container.
+ *
+ * `reserved` is the number of bytes allocated by the container, `used` the number of those bytes that hold data.
+ * The difference is capacity that is allocated but not (yet) used.
+ *
+ * @see strbuf_footprint, dynarray_footprint
+ */
+typedef struct clz_footprint {
+    /**
+     * @brief Bytes holding data
+     */
+    size_t used;
+    /**
+     * @brief Bytes allocated
+     */
+    size_t reserved;
+} clz_footprint;
+
+/**
+ * @brief Definition of structure representing a read-only view of bytes owned by someone else.
+ *
+ * A view does not own `ptr` and is only valid as long as the memory it points to. The bytes need not be
+ * null-terminated, `len` is authoritative.
+ */
+typedef struct clz_view {
+    /**
+     * @brief The first byte
+     */
+    const char *ptr;
+    /**
+     * @brief The number of bytes
+     */
+    size_t len;
+} clz_view;
+
 #endif
@@ -0,0 +1,668 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains thin C++17 wrappers around the containers of the library, so that C++ code can
+ * use them without leaking or copying buffers by hand:
+ *  - @ref clz::StrBuf owns a strbuf (see @ref strbuf.h),
+ *  - @ref clz::DynArray owns the buffer of a @ref dynarray of pointers.
+ *
+ * Both types are move-only. Moving steals the pointer and never clones the buffer; a copy has to be requested
+ * explicitly with `clone()`. Every member function is a one-line forwarder to the C API or a direct access to
+ * the buffer, so the wrappers cost nothing over calling the C functions directly. Functions that can fail return
+ * `bool` like their C counterparts, only constructors throw `std::bad_alloc`. The underlying C object can be
+ * reached with `get()` whenever a C function has no wrapper.
+ *
+ * Example:
+ *
+ * @code
+ *     clz::StrBuf s("Hello");
+ *     s.append(", World!");
+ *     std::string_view v = s;
+ *
+ *     clz::DynArray<Request *> queue;
+ *     queue.push_back(req);
+ *     for (Request *r : queue) handle(r);
+ * @endcode
+ *
+ * For dispatching on a fixed set of string keys, @ref clz::hash computes @ref strbuf_hash at compile time and
+ * @ref clz::PerfectHash builds a collision-free table of the keys at compile time, so that a lookup costs one hash,
+ * one table access and one string comparison:
+ *
+ * @code
+ *     static constexpr std::string_view commands[] = {"get", "set", "del"};
+ *     static constexpr clz::PerfectHash table(commands);
+ *
+ *     switch (table.find(word)) {
+ *         case 0: ... // get
+ *         case 1: ... // set
+ *         case 2: ... // del
+ *         default: ... // CLZ_NOT_FOUND
+ *     }
+ * @endcode
+ *
+ * Coroutines can log through @ref clz::AsyncLogger, whose `co_await log.log(...)` completes without suspending
+ * while the queue of the underlying @ref logger_async has space, and suspends until the worker releases slots
+ * otherwise:
+ *
+ * @code
+ *     clz::AsyncLogger log(logger_default(), 1024);
+ *     co_await log.logf(LOG_INFO, "accepted %d from %s", fd, peer);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementations of @ref strbuf.h, @ref dynarray.h and @ref logger.h are C and have to be compiled by a C
+ * compiler, in a separate translation unit that defines `CLZ_STRBUF_IMPL`, `CLZ_DYNARRAY_IMPL` and
+ * `CLZ_LOGGER_IMPL`. For this reason the `CLZ_STATIC_INLINE` mode is not available to C++ code. `std::span` interop
+ * and @ref clz::AsyncLogger require C++20.
+ *
+ * @file clz.hpp
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the C++ wrappers of the containers of the library
+ *
+ */
+
+#ifndef _CLZ_HPP
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+#if __has_include(<span>) && __cplusplus >= 202002L
+#include <span>
+#endif
+#if __has_include(<coroutine>) && __cplusplus >= 202002L
+#include <coroutine>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstdarg>
+#endif
+
+#include "strbuf.h"
+#include "dynarray.h"
+#include "logger.h"
+
+namespace clz {
+
+/**
+ * @brief Move-only owner of a strbuf
+ *
+ * A moved-from `StrBuf` holds no buffer: it may only be destroyed, assigned to or checked with `valid()`.
+ *
+ * @see strbuf.h
+ */
+class StrBuf {
+public:
+    /**
+     * @brief Creates an empty buffer, see @ref strbuf_new
+     */
+    StrBuf() : buf(strbuf_new()) {
+        if (buf == nullptr) throw std::bad_alloc();
+    }
+
+    /**
+     * @brief Creates a buffer holding a copy of `s`, which may contain null bytes, in binary mode
+     *
+     * @see strbuf_make_binary
+     */
+    explicit StrBuf(std::string_view s) : buf(strbuf_new_size(s.size() + 1)) {
+        if (buf == nullptr) throw std::bad_alloc();
+        if (!strbuf_append_bytes(&buf, s.data(), s.size())) {
+            // the destructor does not run for a throwing constructor
+            strbuf_free(buf);
+            throw std::bad_alloc();
+        }
+    }
+
+    /**
+     * @brief Takes ownership of an existing strbuf, which must have been returned by the C API
+     */
+    static StrBuf adopt(char *strbuf) noexcept {
+        return StrBuf(strbuf, adopt_tag{});
+    }
+
+    StrBuf(const StrBuf &) = delete;
+    StrBuf &operator=(const StrBuf &) = delete;
+
+    StrBuf(StrBuf &&other) noexcept : buf(std::exchange(other.buf, nullptr)) {}
+
+    StrBuf &operator=(StrBuf &&other) noexcept {
+        if (this != &other) {
+            if (buf != nullptr) strbuf_free(buf);
+            buf = std::exchange(other.buf, nullptr);
+        }
+        return *this;
+    }
+
+    ~StrBuf() {
+        if (buf != nullptr) strbuf_free(buf);
+    }
+
+    /**
+     * @brief Returns a deep copy, see @ref strbuf_clone
+     */
+    StrBuf clone() const {
+        char *cpy = strbuf_clone(buf, true);
+        if (cpy == nullptr) throw std::bad_alloc();
+        return adopt(cpy);
+    }
+
+    /**
+     * @brief Gives up ownership of the buffer, which has to be freed with @ref strbuf_free
+     */
+    char *release() noexcept {
+        return std::exchange(buf, nullptr);
+    }
+
+    /**
+     * @brief Returns the address of the owned pointer, for the `char **destbuf` parameters of the C API
+     */
+    char **get() noexcept { return &buf; }
+
+    bool valid() const noexcept { return buf != nullptr; }
+    const char *c_str() const noexcept { return buf; }
+    char *data() noexcept { return buf; }
+    const char *data() const noexcept { return buf; }
+    std::size_t size() const noexcept { return strbuf_length(buf); }
+    bool empty() const noexcept { return size() == 0; }
+    std::size_t capacity() const noexcept { return strbuf_alloc_size(buf); }
+    clz_footprint footprint() const noexcept { return strbuf_footprint(buf); }
+
+    char *begin() noexcept { return buf; }
+    char *end() noexcept { return buf + size(); }
+    const char *begin() const noexcept { return buf; }
+    const char *end() const noexcept { return buf + size(); }
+
+    std::string_view view() const noexcept { return std::string_view(buf, size()); }
+    operator std::string_view() const noexcept { return view(); }
+#ifdef __cpp_lib_span
+    std::span<char> span() noexcept { return std::span<char>(buf, size()); }
+    std::span<const char> span() const noexcept { return std::span<const char>(buf, size()); }
+#endif
+
+    /**
+     * @brief Grows the buffer to hold at least `minsize` bytes, see @ref strbuf_resize
+     */
+    bool reserve(std::size_t minsize) noexcept {
+        return minsize <= capacity() || strbuf_resize(&buf, minsize);
+    }
+
+    bool append(char c) noexcept { return strbuf_append_char(&buf, c); }
+
+    /**
+     * @brief Appends `s`, which may contain null bytes, see @ref strbuf_append_bytes
+     */
+    bool append(std::string_view s) noexcept { return strbuf_append_bytes(&buf, s.data(), s.size()); }
+
+    bool append(const char *s) noexcept { return strbuf_append_str(&buf, const_cast<char *>(s)); }
+    bool append(long long l) noexcept { return strbuf_append_llong(&buf, l); }
+    bool append(unsigned long long l) noexcept { return strbuf_append_ullong(&buf, l); }
+
+    StrBuf &operator+=(std::string_view s) {
+        if (!append(s)) throw std::bad_alloc();
+        return *this;
+    }
+
+private:
+    struct adopt_tag {};
+    StrBuf(char *strbuf, adopt_tag) noexcept : buf(strbuf) {}
+
+    char *buf;
+};
+
+/**
+ * @brief Move-only owner of a @ref dynarray
+ *
+ * Only `DynArray<T *>` is defined, since a @ref dynarray holds pointers. The array owns its buffer of pointers
+ * but not the objects they point to, as with `dynarray_free(d, false)`.
+ */
+template <typename T>
+class DynArray;
+
+/**
+ * @brief Move-only owner of a @ref dynarray of `T *`
+ *
+ * A moved-from `DynArray` is empty and allocates a new buffer on the next `push_back`.
+ *
+ * @see dynarray.h
+ */
+template <typename T>
+class DynArray<T *> {
+public:
+    /**
+     * @brief Iterator yielding the elements as `T *`
+     */
+    class iterator {
+    public:
+        using value_type = T *;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+        explicit iterator(void **p) noexcept : p(p) {}
+
+        T *operator*() const noexcept { return static_cast<T *>(*p); }
+        iterator &operator++() noexcept { ++p; return *this; }
+        iterator operator++(int) noexcept { return iterator(p++); }
+        bool operator==(const iterator &other) const noexcept { return p == other.p; }
+        bool operator!=(const iterator &other) const noexcept { return p != other.p; }
+
+    private:
+        void **p = nullptr;
+    };
+
+    /**
+     * @brief Creates an empty array, see @ref dynarray_init
+     */
+    DynArray() {
+        if (dynarray_init(&d) == nullptr) throw std::bad_alloc();
+    }
+
+    DynArray(const DynArray &) = delete;
+    DynArray &operator=(const DynArray &) = delete;
+
+    DynArray(DynArray &&other) noexcept : d(other.d) {
+        other.d.ptr = nullptr;
+        other.d.alloc_size = 0;
+        other.d.data_size = 0;
+    }
+
+    DynArray &operator=(DynArray &&other) noexcept {
+        if (this != &other) {
+            if (d.ptr != nullptr) dynarray_free(&d, false);
+            d = other.d;
+            other.d.ptr = nullptr;
+            other.d.alloc_size = 0;
+            other.d.data_size = 0;
+        }
+        return *this;
+    }
+
+    ~DynArray() {
+        if (d.ptr != nullptr) dynarray_free(&d, false);
+    }
+
+    /**
+     * @brief Returns a copy holding the same pointers
+     */
+    DynArray clone() const {
+        DynArray cpy;
+        for (T *obj : *this) {
+            if (!cpy.push_back(obj)) throw std::bad_alloc();
+        }
+        return cpy;
+    }
+
+    /**
+     * @brief Returns the underlying @ref dynarray, for the functions of the C API
+     */
+    dynarray *get() noexcept { return &d; }
+
+    std::size_t size() const noexcept { return dynarray_length(&d); }
+    bool empty() const noexcept { return dynarray_length(&d) == 0; }
+    std::size_t capacity() const noexcept { return dynarray_alloc_size(&d); }
+    clz_footprint footprint() const noexcept { return dynarray_footprint(const_cast<dynarray *>(&d)); }
+
+    /**
+     * @brief Returns the element at `index` without bounds checking, see @ref dynarray_at
+     */
+    T *operator[](std::size_t index) const noexcept { return static_cast<T *>(dynarray_at(&d, index)); }
+
+    /**
+     * @brief Returns the element at `index`, or `nullptr` if out of bounds, see @ref dynarray_get
+     */
+    T *at(std::size_t index) noexcept { return static_cast<T *>(dynarray_get(&d, index)); }
+
+    bool set(std::size_t index, T *obj) noexcept { return index < size() && (dynarray_set(&d, index, obj), true); }
+
+    bool push_back(T *obj) noexcept {
+        if (d.ptr == nullptr && dynarray_init(&d) == nullptr) return false;
+        std::size_t len = d.data_size;
+        dynarray_append(&d, obj);
+        return d.data_size != len;
+    }
+
+    T *pop_back() noexcept { return static_cast<T *>(dynarray_pop(&d)); }
+    void clear() noexcept { dynarray_clear(&d, false); }
+
+    iterator begin() const noexcept { return iterator(d.ptr); }
+    iterator end() const noexcept { return iterator(d.ptr + d.data_size); }
+
+#ifdef __cpp_lib_span
+    /**
+     * @brief Returns the elements as untyped pointers
+     */
+    std::span<void *> span() noexcept { return std::span<void *>(d.ptr, d.data_size); }
+    std::span<void *const> span() const noexcept { return std::span<void *const>(d.ptr, d.data_size); }
+
+    /**
+     * @brief Appends all elements of `objs`
+     */
+    bool append(std::span<T *const> objs) noexcept {
+        for (T *obj : objs) {
+            if (!push_back(obj)) return false;
+        }
+        return true;
+    }
+#endif
+
+private:
+    dynarray d;
+};
+
+/**
+ * @brief Computes @ref strbuf_hash of `s`, at compile time if `s` is a constant.
+ */
+constexpr std::uint64_t hash(std::string_view s) noexcept {
+    std::uint64_t h = CLZ_FNV_OFFSET;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= CLZ_FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+ * @brief Minimal perfect hash table of `N` string keys, built at compile time
+ *
+ * The keys are distributed over `buckets` buckets by their hash. For every bucket, the constructor searches a
+ * seed that moves all its keys into free slots of a table of `slots` entries, largest buckets first (hash and
+ * displace). A lookup hashes the key once, picks the slot through the seed of its bucket and compares the key
+ * with the single key stored there.
+ *
+ * The constructor is meant to be evaluated at compile time, i.e. the table should be `constexpr`. Duplicate keys
+ * make the constructor throw, which fails the compilation of a `constexpr` table.
+ */
+template <std::size_t N>
+class PerfectHash {
+    static constexpr std::size_t pow2(std::size_t n) noexcept {
+        std::size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    static constexpr unsigned log2(std::size_t n) noexcept {
+        unsigned l = 0;
+        while ((std::size_t(1) << l) < n) ++l;
+        return l;
+    }
+
+public:
+    /**
+     * @brief Number of entries of the table, a power of 2 keeping the load factor at or below 80%
+     */
+    static constexpr std::size_t slots = pow2(N + N / 4 + 1);
+    /**
+     * @brief Number of buckets, a power of 2 around half the number of keys
+     */
+    static constexpr std::size_t buckets = pow2(N / 2 + 1);
+
+    constexpr explicit PerfectHash(const std::string_view (&keys)[N]) {
+        std::uint64_t hashes[N] = {};
+        std::size_t bucket_size[buckets] = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            hashes[i] = hash(keys[i]);
+            ++bucket_size[hashes[i] & (buckets - 1)];
+            for (std::size_t j = 0; j < i; ++j) {
+                if (keys[i] == keys[j]) throw "clz::PerfectHash: duplicate key";
+            }
+        }
+
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            table[slot] = std::string_view();
+            index[slot] = CLZ_NOT_FOUND;
+        }
+
+        bool used[slots] = {};
+        bool done[buckets] = {};
+        for (std::size_t round = 0; round < buckets; ++round) {
+            std::size_t b = 0;
+            for (std::size_t c = 0; c < buckets; ++c) {
+                if (!done[c] && (done[b] || bucket_size[c] > bucket_size[b])) b = c;
+            }
+            done[b] = true;
+            if (bucket_size[b] == 0) continue;
+
+            for (std::uint32_t seed = 1;; ++seed) {
+                std::size_t taken[N] = {}, ntaken = 0;
+                bool fits = true;
+                for (std::size_t i = 0; i < N && fits; ++i) {
+                    if ((hashes[i] & (buckets - 1)) != b) continue;
+                    std::size_t slot = slot_of(hashes[i], seed);
+                    fits = !used[slot];
+                    for (std::size_t t = 0; t < ntaken && fits; ++t) fits = taken[t] != slot;
+                    taken[ntaken++] = slot;
+                }
+                if (!fits) continue;
+
+                seeds[b] = seed;
+                for (std::size_t i = 0; i < N; ++i) {
+                    if ((hashes[i] & (buckets - 1)) != b) continue;
+                    std::size_t slot = slot_of(hashes[i], seed);
+                    used[slot] = true;
+                    table[slot] = keys[i];
+                    index[slot] = static_cast<int>(i);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the position of `key` in the key array the table was built from, or @ref CLZ_NOT_FOUND
+     */
+    constexpr int find(std::string_view key) const noexcept {
+        std::uint64_t h = hash(key);
+        std::size_t slot = slot_of(h, seeds[h & (buckets - 1)]);
+        return table[slot] == key ? index[slot] : CLZ_NOT_FOUND;
+    }
+
+    int find(const StrBuf &key) const noexcept {
+        return find(key.view());
+    }
+
+private:
+    static constexpr std::size_t slot_of(std::uint64_t h, std::uint32_t seed) noexcept {
+        return static_cast<std::size_t>(((h ^ seed) * 0x9e3779b97f4a7c15ULL) >> (64 - log2(slots)));
+    }
+
+    std::string_view table[slots] = {};
+    int index[slots] = {};
+    std::uint32_t seeds[buckets] = {};
+};
+
+template <std::size_t N>
+PerfectHash(const std::string_view (&)[N]) -> PerfectHash<N>;
+
+#ifdef __cpp_impl_coroutine
+/**
+ * @brief Awaitable front end of a @ref logger_async for C++20 coroutines
+ *
+ * `log()` and `logf()` return an awaiter. Awaiting it queues the line right away if the queue has space and no
+ * coroutine is waiting, without suspending the coroutine. Otherwise the coroutine suspends behind the waiting ones
+ * and is resumed, in FIFO order, as soon as the worker has released enough slots for its line, so that lines are
+ * written in the order they were awaited. No heap allocation takes place: `logf()` formats the message
+ * into the awaiter, which lives in the coroutine frame, and suspended coroutines are linked through their awaiters.
+ *
+ * Suspended coroutines are resumed by the `resume` function given to the constructor, which receives the
+ * coroutine handle and `ctx`, typically to post the handle to the executor the coroutine belongs to. Without such
+ * a function they are resumed directly on the worker thread of the queue, which then stops writing until the
+ * coroutine suspends again or finishes.
+ *
+ * The object is neither copyable nor movable, since the queue refers to it. No coroutine may be waiting on it when
+ * it is destroyed.
+ */
+class AsyncLogger {
+public:
+    using resume_fn = void (*)(std::coroutine_handle<>, void *);
+
+    class Awaiter {
+    public:
+        Awaiter(const Awaiter &) = delete;
+        Awaiter &operator=(const Awaiter &) = delete;
+
+        bool await_ready() noexcept {
+            // slots released while coroutines are waiting belong to them
+            if (owner->waiting.load(std::memory_order_acquire)) return false;
+            return owner->try_log(level, std::string_view(line, len));
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            std::lock_guard<std::mutex> guard(owner->waiters_lock);
+            // the worker may have released slots since await_ready, and will not notify again for them
+            if (owner->waiters_head == nullptr && owner->try_log(level, std::string_view(line, len))) return false;
+            next = nullptr;
+            if (owner->waiters_tail != nullptr) owner->waiters_tail->next = this;
+            else owner->waiters_head = this;
+            owner->waiters_tail = this;
+            owner->waiting.store(true, std::memory_order_release);
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    protected:
+        friend class AsyncLogger;
+
+        Awaiter(AsyncLogger *owner, enum logger_severity level, const char *line, std::size_t len) noexcept
+            : owner(owner), level(level), line(line), len(len) {}
+
+        AsyncLogger *owner;
+        enum logger_severity level;
+        const char *line;
+        std::size_t len;
+        Awaiter *next = nullptr;
+        std::coroutine_handle<> handle;
+    };
+
+    class FormatAwaiter : public Awaiter {
+    public:
+        // only used to return the awaiter from logf, before it is awaited
+        FormatAwaiter(FormatAwaiter &&other) noexcept : Awaiter(other.owner, other.level, buf, other.len) {
+            std::memcpy(buf, other.buf, other.len);
+        }
+
+    protected:
+        friend class AsyncLogger;
+
+        FormatAwaiter(AsyncLogger *owner, enum logger_severity level, const char *fmt, std::va_list args) noexcept
+            : Awaiter(owner, level, buf, 0) {
+            int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+            if (n > 0) len = static_cast<std::size_t>(n) < sizeof(buf) ? static_cast<std::size_t>(n) : sizeof(buf) - 1;
+        }
+
+        char buf[CLZ_LOGGER_ASYNC_LINE];
+    };
+
+    /**
+     * @brief Starts a queue of `capacity` lines in front of `log`, see @ref logger_async_start
+     */
+    AsyncLogger(logger *log, std::size_t capacity, resume_fn resume = nullptr, void *ctx = nullptr)
+        : q(logger_async_start(log, capacity)), resume(resume), ctx(ctx) {
+        if (q == nullptr) throw std::bad_alloc();
+        logger_async_on_space(q, &AsyncLogger::on_space, this);
+    }
+
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    /**
+     * @brief Writes out the queued lines and stops the queue, see @ref logger_async_stop
+     */
+    ~AsyncLogger() {
+        logger_async_stop(q);
+    }
+
+    /**
+     * @brief Returns the underlying queue, for the functions of the C API
+     */
+    logger_async *get() noexcept { return q; }
+
+    /**
+     * @brief Queues a line without suspending, see @ref logger_async_try_logn
+     */
+    bool try_log(enum logger_severity level, std::string_view line) noexcept {
+        return logger_async_try_logn(q, level, line.data(), line.size());
+    }
+
+    /**
+     * @brief Returns an awaiter queueing `line`, which has to stay valid until the awaiter completes
+     */
+    Awaiter log(enum logger_severity level, std::string_view line) noexcept {
+        return Awaiter(this, level, line.data(), line.size());
+    }
+
+    /**
+     * @brief Returns an awaiter queueing a line formatted by `vsnprintf`
+     *
+     * The message is formatted into the awaiter right away, so the arguments need not outlive this call. The format
+     * string is checked against the arguments by the compiler, like the one of `printf`.
+     */
+    CLZ_PRINTF(3, 4) FormatAwaiter logf(enum logger_severity level, const char *fmt, ...) noexcept {
+        std::va_list args;
+        va_start(args, fmt);
+        FormatAwaiter a(this, level, fmt, args);
+        va_end(args);
+        return a;
+    }
+
+private:
+    static void on_space(void *arg) {
+        AsyncLogger *self = static_cast<AsyncLogger *>(arg);
+        for (;;) {
+            std::coroutine_handle<> h;
+            {
+                std::lock_guard<std::mutex> guard(self->waiters_lock);
+                Awaiter *w = self->waiters_head;
+                if (w == nullptr || !self->try_log(w->level, std::string_view(w->line, w->len))) return;
+                self->waiters_head = w->next;
+                if (self->waiters_head == nullptr) {
+                    self->waiters_tail = nullptr;
+                    self->waiting.store(false, std::memory_order_release);
+                }
+                h = w->handle;
+            }
+            if (self->resume != nullptr) self->resume(h, self->ctx);
+            else h.resume();
+        }
+    }
+
+    logger_async *q;
+    resume_fn resume;
+    void *ctx;
+    std::mutex waiters_lock;
+    Awaiter *waiters_head = nullptr;
+    Awaiter *waiters_tail = nullptr;
+    // whether waiters_head is set, read by await_ready without the lock
+    std::atomic<bool> waiting{false};
+};
+#endif
+
+}
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains the CRC-32C (Castagnoli) checksum, as used by iSCSI, ext4, Btrfs and many storage
+ * formats, for strbufs, views and arrays of strbufs.
+ *
+ * Checksums are incremental: the checksum of some data, given with the checksum of the data before it, is the
+ * checksum of both, starting from `0`. Two checksums computed separately, for example by two threads, can also be
+ * combined with @ref crc32c_combine without reading the data again.
+ *
+ * The implementation is chosen at runtime, the first time a checksum is computed:
+ *
+ * - on x86-64 processors with SSE4.2 and PCLMULQDQ (since 2010), the `crc32` instruction processes 8 bytes at
+ *   a time. Since each instruction depends on the result of the previous one, large inputs are split into three
+ *   lanes computed in an interleaved way, which keeps the processor busy during the latency of the instruction.
+ *   The checksums of the lanes are then shifted into place with carry-less multiplications and combined.
+ * - otherwise, a table-driven implementation processes 8 bytes at a time with 8 tables of 256 entries
+ *   ("slicing-by-8").
+ *
+ * Example:
+ *
+ * @code
+ *     uint32_t crc = strbuf_crc32c(&buf, 0);
+ *     crc = crc32c(crc, trailer, trailer_len); // the checksum of buf followed by trailer
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_CRC32C_IMPL` is defined beforehand. It requires POSIX
+ * threads and the implementation of @ref strbuf.h.
+ *
+ * @file crc32c.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for the CRC-32C checksum
+ *
+ */
+
+#ifndef _CLZ_CRC32C_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "clz.h"
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * @brief Computes the CRC-32C of bytes following the ones of a checksum.
+ *
+ * @param crc The checksum of the preceding bytes, or `0`
+ * @param data The bytes
+ * @param n The number of bytes
+ * @return The checksum of the preceding bytes followed by `data`
+ *
+ * @see crc32c_combine
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t n);
+/**
+ * @brief Combines the checksums of two consecutive pieces of data.
+ *
+ * This costs a few hundred operations, independently of the length.
+ *
+ * @param crc1 The checksum of the first piece, from `0`
+ * @param crc2 The checksum of the second piece, from `0`
+ * @param len2 The length of the second piece
+ * @return The checksum of the first piece followed by the second one
+ */
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+/**
+ * @brief Computes the CRC-32C of the contents of a strbuf.
+ *
+ * @param destbuf The buffer
+ * @param crc The checksum of the preceding data, or `0`
+ * @return The checksum of the preceding data followed by the buffer
+ */
+uint32_t strbuf_crc32c(char **destbuf, uint32_t crc);
+/**
+ * @brief Computes the CRC-32C of a view.
+ *
+ * @param v The view
+ * @param crc The checksum of the preceding data, or `0`
+ * @return The checksum of the preceding data followed by the view
+ */
+uint32_t crc32c_view(clz_view v, uint32_t crc);
+/**
+ * @brief Computes the CRC-32C of the concatenation of the strbufs of a @ref dynarray.
+ *
+ * @param d The array of strbufs
+ * @param crc The checksum of the preceding data, or `0`
+ * @return The checksum of the preceding data followed by all strbufs, in order
+ */
+uint32_t crc32c_dynarray(dynarray *d, uint32_t crc);
+
+#endif
+
+#ifdef CLZ_CRC32C_IMPL
+#undef CLZ_CRC32C_IMPL
+
+#include <string.h>
+#include <pthread.h>
+
+// the reflected polynomial
+#define _CRC32C_POLY 0x82F63B78U
+
+static uint32_t _crc32c_table[8][256];
+static pthread_once_t _crc32c_once = PTHREAD_ONCE_INIT;
+static uint32_t (*_crc32c_fn)(uint32_t, const unsigned char *, size_t);
+
+// a * b modulo the polynomial, bit 31 standing for x^0
+static uint32_t _crc32c_mul(uint32_t a, uint32_t b) {
+    uint32_t p = 0;
+    for (uint32_t m = 1U << 31; m; m >>= 1) {
+        if (a & m) {
+            p ^= b;
+            if (!(a & (m - 1))) break;
+        }
+        b = b & 1 ? (b >> 1) ^ _CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+// x^n modulo the polynomial
+static uint32_t _crc32c_xpow(uint64_t n) {
+    uint32_t r = 1U << 31, sq = 1U << 30;
+    for (; n; n >>= 1) {
+        if (n & 1) r = _crc32c_mul(r, sq);
+        sq = _crc32c_mul(sq, sq);
+    }
+    return r;
+}
+
+// the checksums are computed without their initial and final inversion, which the public functions add
+static uint32_t _crc32c_sw(uint32_t crc, const unsigned char *p, size_t n) {
+    uint32_t (*t)[256] = _crc32c_table;
+    for (; n >= 8; p += 8, n -= 8) {
+        crc ^= (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+        crc = t[7][crc & 0xFF] ^ t[6][(crc >> 8) & 0xFF] ^ t[5][(crc >> 16) & 0xFF] ^ t[4][crc >> 24]
+                ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for (; n; --n) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+// the lengths of the lanes, and the constants shifting a checksum over one and two lanes
+#define _CRC32C_LONG 8192
+#define _CRC32C_SHORT 256
+static uint64_t _crc32c_long_k[2], _crc32c_short_k[2];
+
+// crc * x^(8n) through a carry-less multiplication by k = x^(8n - 33) and a reduction by the crc32 instruction
+__attribute__((target("sse4.2,pclmul")))
+static inline uint32_t _crc32c_shift(uint32_t crc, uint64_t k) {
+    __m128i r = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int) crc), _mm_cvtsi64_si128((long long) k), 0);
+    return (uint32_t) _mm_crc32_u64(0, (uint64_t) _mm_cvtsi128_si64(r));
+}
+
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t _crc32c_hw(uint32_t crc, const unsigned char *p, size_t n) {
+    uint64_t c = crc;
+    for (; n && ((uintptr_t) p & 7); --n) c = _mm_crc32_u8((uint32_t) c, *p++);
+
+    // three lanes at a time, the second and third ones starting from 0
+    static const size_t lanes[2] = {_CRC32C_LONG, _CRC32C_SHORT};
+    const uint64_t *ks[2] = {_crc32c_long_k, _crc32c_short_k};
+    for (int l = 0; l < 2; ++l) {
+        size_t lane = lanes[l];
+        for (; n >= 3 * lane; p += 3 * lane, n -= 3 * lane) {
+            uint64_t c1 = 0, c2 = 0;
+            for (size_t i = 0; i < lane; i += 8) {
+                uint64_t v0, v1, v2;
+                memcpy(&v0, p + i, 8);
+                memcpy(&v1, p + lane + i, 8);
+                memcpy(&v2, p + 2 * lane + i, 8);
+                c = _mm_crc32_u64(c, v0);
+                c1 = _mm_crc32_u64(c1, v1);
+                c2 = _mm_crc32_u64(c2, v2);
+            }
+            c = _crc32c_shift((uint32_t) c, ks[l][1]) ^ _crc32c_shift((uint32_t) c1, ks[l][0]) ^ c2;
+        }
+    }
+
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    for (; n; --n) c = _mm_crc32_u8((uint32_t) c, *p++);
+    return (uint32_t) c;
+}
+#endif
+
+static void _crc32c_init(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = c & 1 ? (c >> 1) ^ _CRC32C_POLY : c >> 1;
+        _crc32c_table[0][i] = c;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (int i = 0; i < 256; ++i) {
+            uint32_t c = _crc32c_table[k - 1][i];
+            _crc32c_table[k][i] = (c >> 8) ^ _crc32c_table[0][c & 0xFF];
+        }
+    }
+    _crc32c_fn = _crc32c_sw;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul")) {
+        for (int i = 0; i < 2; ++i) {
+            _crc32c_long_k[i] = _crc32c_xpow(8 * (uint64_t) _CRC32C_LONG * (i + 1) - 33);
+            _crc32c_short_k[i] = _crc32c_xpow(8 * (uint64_t) _CRC32C_SHORT * (i + 1) - 33);
+        }
+        _crc32c_fn = _crc32c_hw;
+    }
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t n) {
+    pthread_once(&_crc32c_once, _crc32c_init);
+    return ~_crc32c_fn(~crc, data, n);
+}
+
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    // the inversions cancel out: only the first checksum is shifted over the second piece
+    return _crc32c_mul(_crc32c_xpow(8 * (uint64_t) len2), crc1) ^ crc2;
+}
+
+uint32_t strbuf_crc32c(char **destbuf, uint32_t crc) {
+    return crc32c(crc, *destbuf, strbuf_length(*destbuf));
+}
+
+uint32_t crc32c_view(clz_view v, uint32_t crc) {
+    return crc32c(crc, v.ptr, v.len);
+}
+
+uint32_t crc32c_dynarray(dynarray *d, uint32_t crc) {
+    for (size_t i = 0; i < dynarray_length(d); ++i) {
+        char *buf = dynarray_at(d, i);
+        crc = crc32c(crc, buf, strbuf_length(buf));
+    }
+    return crc;
+}
+
+#endif
@@ -0,0 +1,407 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a parser for CSV and other delimited records (RFC 4180). Instead of copying fields,
+ * the parser builds an index of the positions of all field separators in the input, which may be a strbuf,
+ * a memory-mapped file or any other byte array. Fields are then accessed as @ref clz_view pointing into the input,
+ * so parsing takes no allocation per field, only the growth of the index itself.
+ *
+ * The input is classified 64 bytes at a time: SSE2 comparisons produce one bit mask each for quotes, delimiters
+ * and newlines. The quoted regions follow from the quote mask by a prefix XOR (every bit becomes the parity of the
+ * quotes up to it), which also handles escaped quotes `""` since they toggle twice. Delimiters and newlines outside
+ * of quotes are then extracted from the masks with count-trailing-zeros. Without SSE2, the masks are built byte by
+ * byte, with the same results.
+ *
+ * Optionally, the input is parsed in parallel: a first pass counts the quotes of every chunk, which determines
+ * whether each chunk starts inside quotes, then all chunks are indexed concurrently and the indices concatenated.
+ *
+ * Records end with `"\n"` or `"\r\n"`; the `'\r'` is not part of the last field. A final record without newline
+ * is recognized too. Quoted fields are returned with their quotes, see @ref csv_append_field to unquote them.
+ *
+ * Example:
+ *
+ * @code
+ *     csv_index idx;
+ *     if (!csv_parse(&idx, buf, strbuf_length(buf), ',', 0)) return false;
+ *     for (size_t r = 0; r < csv_rows(&idx); ++r) {
+ *         clz_view name = csv_field(&idx, r, 1);
+ *         printf("%.*s\n", (int) name.len, name.ptr);
+ *     }
+ *     csv_free(&idx);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_CSV_IMPL` is defined beforehand. It requires POSIX threads
+ * and the implementation of @ref strbuf.h.
+ *
+ * @file csv.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for an index-based parser for CSV files
+ *
+ */
+
+#ifndef _CLZ_CSV_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_CSV_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "clz.h"
+#include "strbuf.h"
+
+/**
+ * Macro defining the minimum number of bytes parsed by each thread.
+ */
+#ifndef CLZ_CSV_PARALLEL_MIN
+#define CLZ_CSV_PARALLEL_MIN (1 << 20)
+#endif
+
+/**
+ * @brief Definition of the index of a parsed CSV input
+ *
+ * Field `k` (counting through all records) spans from `seps[k - 1] + 1` (or `0`) to `seps[k]`, the position
+ * of the delimiter or newline that ends it. Record `r` consists of the fields `rows[r]` up to `rows[r + 1]`.
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct csv_index {
+    /**
+     * @brief The input, which is not owned by the index
+     */
+    const char *data;
+    /**
+     * @brief The length of the input
+     */
+    size_t len;
+    /**
+     * @brief The positions of the field separators
+     */
+    size_t *seps;
+    /**
+     * @brief The number of fields
+     */
+    size_t nseps;
+    /**
+     * @brief The index of the first field of every record, followed by `nseps`
+     */
+    size_t *rows;
+    /**
+     * @brief The number of records
+     */
+    size_t nrows;
+} csv_index;
+
+/**
+ * @brief Builds the index of a CSV input.
+ *
+ * `data` has to stay valid and unchanged while the index is used. If `threads` is not `1`, the input is split into
+ * chunks of at least @ref CLZ_CSV_PARALLEL_MIN bytes, which are parsed by one thread each.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned, `errno` is set to `ENOMEM`
+ * and the index need not be freed.
+ *
+ * @param idx The index to initialize
+ * @param data The input
+ * @param len The length of the input
+ * @param delim The field delimiter, typically `','`, `';'` or `'\t'`
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return `true` if successful
+ *
+ * @see csv_free, csv_field
+ */
+bool csv_parse(csv_index *idx, const char *data, size_t len, char delim, size_t threads);
+/**
+ * @brief Frees the memory held by the index, but not the input.
+ *
+ * @param idx The index
+ */
+void csv_free(csv_index *idx);
+/**
+ * @brief Returns the number of fields of a record
+ *
+ * @param idx The index
+ * @param row The record, which must be less than @ref csv_rows
+ * @return The number of fields
+ */
+size_t csv_fields(csv_index *idx, size_t row);
+/**
+ * @brief Returns a field as it appears in the input, including quotes.
+ *
+ * If the record has fewer fields than `col + 1`, an empty view with a `NULL` pointer is returned.
+ *
+ * @param idx The index
+ * @param row The record, which must be less than @ref csv_rows
+ * @param col The field within the record
+ * @return The field
+ *
+ * @see csv_append_field
+ */
+clz_view csv_field(csv_index *idx, size_t row, size_t col);
+/**
+ * @brief Appends the value of a field to a strbuf, removing quotes.
+ *
+ * If the field is quoted, the surrounding quotes are removed and every escaped quote `""` is appended as a single
+ * quote. Otherwise, the field is appended as is. A missing field appends nothing.
+ *
+ * Since heap allocation may be used, failure is possible. In this case, `false` is returned and `errno` is set
+ * to `ENOMEM`.
+ *
+ * @param destbuf The destination buffer
+ * @param idx The index
+ * @param row The record, which must be less than @ref csv_rows
+ * @param col The field within the record
+ * @return `true` if successful
+ *
+ * @see csv_field
+ */
+bool csv_append_field(char **destbuf, csv_index *idx, size_t row, size_t col);
+
+/**
+ * @brief Returns the number of records of the index
+ */
+#define csv_rows(idx) ((idx)->nrows)
+
+#endif
+
+#ifdef CLZ_CSV_IMPL
+#undef CLZ_CSV_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef struct _csv_chunk {
+    const char *data;
+    size_t begin;
+    size_t end;
+    char delim;
+    // whether the chunk starts inside quotes
+    bool quoted;
+    size_t quotes;
+    size_t *seps;
+    size_t nseps;
+    size_t seps_cap;
+    // local indices into seps of the newlines
+    size_t *ends;
+    size_t nends;
+    size_t ends_cap;
+    bool failed;
+} _csv_chunk;
+
+static inline uint64_t _csv_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static inline void _csv_masks(const unsigned char *p, size_t n, char delim, uint64_t *q, uint64_t *d, uint64_t *nl) {
+#ifdef __SSE2__
+    if (n == 64) {
+        const __m128i vq = _mm_set1_epi8('"'), vd = _mm_set1_epi8(delim), vn = _mm_set1_epi8('\n');
+        uint64_t mq = 0, md = 0, mn = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (p + 16 * i));
+            mq |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, vq)) << (16 * i);
+            md |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, vd)) << (16 * i);
+            mn |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, vn)) << (16 * i);
+        }
+        *q = mq;
+        *d = md;
+        *nl = mn;
+        return;
+    }
+#endif
+    uint64_t mq = 0, md = 0, mn = 0;
+    for (size_t i = 0; i < n; ++i) {
+        mq |= (uint64_t) (p[i] == '"') << i;
+        md |= (uint64_t) (p[i] == (unsigned char) delim) << i;
+        mn |= (uint64_t) (p[i] == '\n') << i;
+    }
+    *q = mq;
+    *d = md;
+    *nl = mn;
+}
+
+static bool _csv_push(size_t **arr, size_t *n, size_t *cap, size_t v) {
+    if (*n == *cap) {
+        size_t newcap = *cap ? 2 * *cap : 256;
+        size_t *a = realloc(*arr, newcap * sizeof(size_t));
+        if (!a) return false;
+        *arr = a;
+        *cap = newcap;
+    }
+    (*arr)[(*n)++] = v;
+    return true;
+}
+
+static void *_csv_count_quotes(void *arg) {
+    _csv_chunk *c = arg;
+    const char *p = c->data + c->begin, *end = c->data + c->end;
+    while ((p = memchr(p, '"', end - p)) != NULL) {
+        ++c->quotes;
+        ++p;
+    }
+    return NULL;
+}
+
+static void *_csv_scan(void *arg) {
+    _csv_chunk *c = arg;
+    const unsigned char *p = (const unsigned char *) c->data + c->begin;
+    size_t n = c->end - c->begin;
+    // all ones while inside quotes
+    uint64_t inside = c->quoted ? ~(uint64_t) 0 : 0;
+
+    for (size_t off = 0; off < n; off += 64) {
+        uint64_t q, d, nl;
+        _csv_masks(p + off, n - off < 64 ? n - off : 64, c->delim, &q, &d, &nl);
+        uint64_t in = _csv_prefix_xor(q) ^ inside;
+        inside = (uint64_t) ((int64_t) in >> 63);
+
+        for (uint64_t s = (d | nl) & ~in; s; s &= s - 1) {
+            int bit = __builtin_ctzll(s);
+            if (((nl >> bit) & 1) && !_csv_push(&c->ends, &c->nends, &c->ends_cap, c->nseps)) goto fail;
+            if (!_csv_push(&c->seps, &c->nseps, &c->seps_cap, c->begin + off + bit)) goto fail;
+        }
+    }
+    return NULL;
+
+fail:
+    c->failed = true;
+    return NULL;
+}
+
+bool csv_parse(csv_index *idx, const char *data, size_t len, char delim, size_t threads) {
+    threads = _clz_threads(threads, len, CLZ_CSV_PARALLEL_MIN);
+
+    _csv_chunk *chunks = calloc(threads, sizeof(_csv_chunk));
+    if (!chunks) return false;
+    for (size_t i = 0; i < threads; ++i) {
+        chunks[i].data = data;
+        chunks[i].delim = delim;
+        chunks[i].begin = len / threads * i;
+        chunks[i].end = i + 1 == threads ? len : len / threads * (i + 1);
+    }
+    if (threads > 1) {
+        _clz_run(_csv_count_quotes, chunks, sizeof(_csv_chunk), threads);
+        for (size_t i = 1; i < threads; ++i) {
+            chunks[i].quoted = chunks[i - 1].quoted ^ (chunks[i - 1].quotes & 1);
+        }
+    }
+    _clz_run(_csv_scan, chunks, sizeof(_csv_chunk), threads);
+
+    size_t nseps = 1, nrows = 2;
+    bool ok = true;
+    for (size_t i = 0; i < threads; ++i) {
+        ok &= !chunks[i].failed;
+        nseps += chunks[i].nseps;
+        nrows += chunks[i].nends;
+    }
+    idx->data = data;
+    idx->len = len;
+    idx->seps = ok ? malloc(nseps * sizeof(size_t)) : NULL;
+    idx->rows = ok ? malloc(nrows * sizeof(size_t)) : NULL;
+    idx->nseps = idx->nrows = 0;
+
+    ok = idx->seps && idx->rows;
+    for (size_t i = 0; ok && i < threads; ++i) {
+        _csv_chunk *c = chunks + i;
+        for (size_t j = 0; j < c->nends; ++j) idx->rows[++idx->nrows] = idx->nseps + c->ends[j] + 1;
+        if (c->nseps) memcpy(idx->seps + idx->nseps, c->seps, c->nseps * sizeof(size_t));
+        idx->nseps += c->nseps;
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        free(chunks[i].seps);
+        free(chunks[i].ends);
+    }
+    free(chunks);
+    if (!ok) {
+        csv_free(idx);
+        errno = ENOMEM;
+        return false;
+    }
+
+    // a final record without newline, or inside unclosed quotes
+    idx->rows[0] = 0;
+    if (len && !(idx->nrows && idx->rows[idx->nrows] == idx->nseps && idx->seps[idx->nseps - 1] == len - 1)) {
+        idx->seps[idx->nseps++] = len;
+        idx->rows[++idx->nrows] = idx->nseps;
+    }
+    return true;
+}
+
+void csv_free(csv_index *idx) {
+    free(idx->seps);
+    free(idx->rows);
+    idx->seps = idx->rows = NULL;
+    idx->nseps = idx->nrows = 0;
+}
+
+size_t csv_fields(csv_index *idx, size_t row) {
+    return idx->rows[row + 1] - idx->rows[row];
+}
+
+clz_view csv_field(csv_index *idx, size_t row, size_t col) {
+    clz_view v = {NULL, 0};
+    size_t k = idx->rows[row] + col;
+    if (k >= idx->rows[row + 1]) return v;
+
+    size_t start = k ? idx->seps[k - 1] + 1 : 0, end = idx->seps[k];
+    // the last field of a record ending with "\r\n"
+    if (k + 1 == idx->rows[row + 1] && end > start && idx->data[end - 1] == '\r') --end;
+    v.ptr = idx->data + start;
+    v.len = end - start;
+    return v;
+}
+
+bool csv_append_field(char **destbuf, csv_index *idx, size_t row, size_t col) {
+    clz_view v = csv_field(idx, row, col);
+    if (!v.ptr) return true;
+    if (v.len < 2 || v.ptr[0] != '"') return strbuf_append_strn(destbuf, (char *) v.ptr, v.len);
+
+    const char *p = v.ptr + 1, *end = v.ptr + v.len - (v.ptr[v.len - 1] == '"');
+    while (p < end) {
+        const char *q = memchr(p, '"', end - p);
+        if (!q) q = end;
+        if (!strbuf_append_strn(destbuf, (char *) p, q - p)) return false;
+        if (q == end) break;
+        // an escaped quote
+        if (!strbuf_append_char(destbuf, '"')) return false;
+        p = q + 2;
+    }
+    return true;
+}
+
+#endif
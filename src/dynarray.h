@@ -29,6 +29,8 @@
  *
  * The implementation can be included if the macro `CLZ_DYNARRAY_IMPL` is defined beforehand. Some functionalities
  * are implemented as macros for performance reasons.
+ * If the macro `CLZ_STATIC_INLINE` is defined, the implementation is always included and the functions are
+ * `static inline`, see @ref CLZ_API.
  */
 
 #ifndef _CLZ_DYNARRAY_H
@@ -42,6 +44,13 @@
 #include <stdbool.h>
 
 #include "clz.h"
+#include "stats.h"
+#include "footprint.h"
+#include "usdt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /**
  * @brief Definition of structure representing a dynamic array.
@@ -126,7 +135,7 @@ typedef struct dynarray {
  *
  * @see dynarray_new, @see dynarray_free
  */
-void *dynarray_init(dynarray *d);
+CLZ_API void *dynarray_init(dynarray *d);
 /**
  * @brief Allocates a new `dynarray` struct object on the heap and returns its pointer.
  *
@@ -141,7 +150,7 @@ void *dynarray_init(dynarray *d);
  *
  * @see dynarray_init, @see dynarray_free
  */
-dynarray *dynarray_new();
+CLZ_API dynarray *dynarray_new();
 /**
  * @brief Frees the internal allocations of the dynarray
  *
@@ -178,7 +187,7 @@ dynarray *dynarray_new();
  * @param d The @ref dynarray to free.
  * @param deep Whether or not to invoke `free()` on the elements of the array
  */
-void dynarray_free(dynarray *d, bool deep);
+CLZ_API void dynarray_free(dynarray *d, bool deep);
 
 /**
  * @brief Append element after the end of the array
@@ -199,7 +208,7 @@ void dynarray_free(dynarray *d, bool deep);
  *
  * @see dynarray_alloc_size
  */
-void *dynarray_append(dynarray *d, void *obj);
+CLZ_API CLZ_HOT void *dynarray_append(dynarray *d, void *obj);
 /**
  * @brief Set element by index
  *
@@ -219,7 +228,7 @@ void *dynarray_append(dynarray *d, void *obj);
  *
  * @see dynarray_append, dynarray_get, dynarray_length
  */
-void *dynarray_set(dynarray *d, size_t index, void *obj);
+CLZ_API CLZ_HOT void *dynarray_set(dynarray *d, size_t index, void *obj);
 /**
  * @brief Get element by index
  *
@@ -243,7 +252,7 @@ void *dynarray_set(dynarray *d, size_t index, void *obj);
  *
  * @see dynarray_append, dynarray_at, dynarray_length
  */
-void *dynarray_get(dynarray *d, size_t index);
+CLZ_API CLZ_HOT void *dynarray_get(dynarray *d, size_t index);
 
 /**
  * @brief Removes the first occurrence of the pointer within the array
@@ -261,7 +270,7 @@ void *dynarray_get(dynarray *d, size_t index);
  *
  * @see dynarray_remove_all, @ref dynarray_remove_index
  */
-bool dynarray_remove_first(dynarray *d, void *obj);
+CLZ_API bool dynarray_remove_first(dynarray *d, void *obj);
 /**
  * @brief Removes all occurrences of the pointer within the array
  *
@@ -278,7 +287,7 @@ bool dynarray_remove_first(dynarray *d, void *obj);
  *
  * @see dynarray_remove_first, @ref dynarray_remove_index
  */
-bool dynarray_remove_all(dynarray *d, void *obj);
+CLZ_API bool dynarray_remove_all(dynarray *d, void *obj);
 /**
  * @brief Removes an element pointer within the array by index
  *
@@ -295,7 +304,7 @@ bool dynarray_remove_all(dynarray *d, void *obj);
  *
  * @see dynarray_remove_first, @ref dynarray_remove_all, @ref dynarray_pop
  */
-bool dynarray_remove_index(dynarray *d, size_t index);
+CLZ_API bool dynarray_remove_index(dynarray *d, size_t index);
 
 /**
  * @brief Clears the array contents
@@ -318,7 +327,7 @@ bool dynarray_remove_index(dynarray *d, size_t index);
  *
  * @ref dynarray_free, dynarray_remove_all
  */
-void dynarray_clear(dynarray *d, bool tofree);
+CLZ_API void dynarray_clear(dynarray *d, bool tofree);
 
 /**
  * @brief Return position of first occurrence of the pointer in the array.
@@ -332,7 +341,7 @@ void dynarray_clear(dynarray *d, bool tofree);
  *
  * @see dynarray_find_next, dynarray_find_reset
  */
-int dynarray_find_first(dynarray *d, void *obj);
+CLZ_API int dynarray_find_first(dynarray *d, void *obj);
 /**
  * @brief Return position of next occurrence of the pointer in the array.
  *
@@ -368,7 +377,7 @@ int dynarray_find_first(dynarray *d, void *obj);
  *
  * @see dynarray_find_first, dynarray_find_reset
  */
-int dynarray_find_next(dynarray *d, void *obj);
+CLZ_API int dynarray_find_next(dynarray *d, void *obj);
 
 /**
  * @brief Iterate through the array and performs a predefined operation on each pointer-element
@@ -381,7 +390,7 @@ int dynarray_find_next(dynarray *d, void *obj);
  *
  * @see clz_consumer, dynarray_foreach_if, dynarray_foreach_if_else
  */
-void dynarray_foreach(dynarray *d, clz_consumer c);
+CLZ_API void dynarray_foreach(dynarray *d, clz_consumer c);
 /**
  * @brief Iteratex through the array and performs a predefined operation on each pointer-element if a certain condition
  * applies
@@ -396,7 +405,7 @@ void dynarray_foreach(dynarray *d, clz_consumer c);
  *
  * @see clz_consumer, clz_predicate, dynarray_foreach, dynarray_foreach_if_else
  */
-void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c);
+CLZ_API void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c);
 /**
  * @brief Iteratex through the array and performs an "if"-operation on each pointer-element if a certain condition
  * applies, and an "else"-operation otherwise
@@ -412,7 +421,7 @@ void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c);
  *
  * @see clz_consumer, clz_predicate, dynarray_foreach, dynarray_foreach_if
  */
-void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, clz_consumer elsec);
+CLZ_API void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, clz_consumer elsec);
 
 /**
  * @brief Removes the last element pointer within the array and returns it
@@ -430,7 +439,19 @@ void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, cl
  *
  * @see dynarray_get, dynarray_at, dynarray_remove_first, @ref dynarray_remove_index
  */
-void *dynarray_pop(dynarray *d);
+CLZ_API void *dynarray_pop(dynarray *d);
+/**
+ * @brief Returns the heap memory held by the array
+ *
+ * Only the buffer of element pointers is taken into account: neither the @ref dynarray struct itself (which may
+ * not live on the heap) nor the objects the elements point to.
+ *
+ * @param d The @ref dynarray
+ * @return The footprint of the array
+ *
+ * @see dynarray_length, dynarray_alloc_size, clz_footprint
+ */
+CLZ_API clz_footprint dynarray_footprint(dynarray *d);
 
 #define CLZ_DYNARRAY_ALLOC 8
 
@@ -440,23 +461,33 @@ void *dynarray_pop(dynarray *d);
 #define dynarray_at(d, index) (*((d)->ptr + (index)))
 #define dynarray_valid_index(d, index) (dynarray_length(d) > (index))
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
-#ifdef CLZ_DYNARRAY_IMPL
+#if (defined(CLZ_DYNARRAY_IMPL) || defined(CLZ_STATIC_INLINE)) && !defined(_CLZ_DYNARRAY_IMPL_DONE)
 #undef CLZ_DYNARRAY_IMPL
+#define _CLZ_DYNARRAY_IMPL_DONE
 
-void *dynarray_init(dynarray *d) {
+CLZ_API void *dynarray_init(dynarray *d) {
+    CLZ_STATS_CALL(dynarray_init);
     d->alloc_size = CLZ_DYNARRAY_ALLOC;
     d->data_size = 0;
     d->ptr = (void **) calloc(CLZ_DYNARRAY_ALLOC, sizeof(void *));
     if (d->ptr == NULL) return NULL;
+    CLZ_STATS_ALLOC(dynarray_init, CLZ_DYNARRAY_ALLOC * sizeof(void *));
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 1, CLZ_DYNARRAY_ALLOC * sizeof(void *), 0);
     d->find_index = CLZ_FIND_INDEX_START;
     return (void *) d->ptr;
 }
 
-dynarray *dynarray_new() {
+CLZ_API dynarray *dynarray_new() {
+    CLZ_STATS_CALL(dynarray_new);
     dynarray *d = malloc(sizeof(dynarray));
     if (d == NULL) return NULL;
+    CLZ_STATS_ALLOC(dynarray_new, sizeof(dynarray));
     if( dynarray_init(d)) {
         return d;
     }
@@ -464,40 +495,57 @@ dynarray *dynarray_new() {
     return NULL;
 }
 
-void dynarray_free(dynarray *d, bool deep) {
+CLZ_API void dynarray_free(dynarray *d, bool deep) {
+    CLZ_STATS_CALL(dynarray_free);
     if (deep) {
         for (int i = 0; i < d->data_size; ++i) {
             free(dynarray_get(d, i));
         }
     }
 
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, -1, -(int64_t) (d->alloc_size * sizeof(void *)),
+                      -(int64_t) (d->data_size * sizeof(void *)));
     free(d->ptr);
 }
 
-void *dynarray_append(dynarray *d, void *obj) {
+CLZ_API void *dynarray_append(dynarray *d, void *obj) {
+    CLZ_STATS_CALL(dynarray_append);
     if (d->alloc_size == d->data_size) {
+        CLZ_STATS_RESIZE_BEGIN(dynarray_append);
+        CLZ_USDT_TIMER(t0);
         void ** new_ptr = (void**) reallocarray(d->ptr, d->alloc_size * 2, sizeof(void *));
         if (new_ptr == NULL) return NULL;
+        CLZ_STATS_ALLOC(dynarray_append, d->alloc_size * 2 * sizeof(void *));
+        CLZ_STATS_COPY(dynarray_append, d->data_size * sizeof(void *));
         d->alloc_size *= 2;
         d->ptr = new_ptr;
+        CLZ_STATS_RESIZE_END(dynarray_append);
+        CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, d->alloc_size / 2 * sizeof(void *), 0);
+        CLZ_PROBE3(dynarray_grow, d->alloc_size / 2, d->alloc_size, CLZ_USDT_ELAPSED(t0));
     }
 
     *(d->ptr + d->data_size) = obj;
     d->data_size++;
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, 0, sizeof(void *));
     return obj;
 }
 
-void *dynarray_set(dynarray *d, size_t index, void *obj) {
+CLZ_API void *dynarray_set(dynarray *d, size_t index, void *obj) {
+    CLZ_STATS_CALL(dynarray_set);
     if (index >= d->data_size) return NULL;
     *(d->ptr + index) = obj;
     return obj;
 }
 
-bool dynarray_remove_first(dynarray *d, void *obj) {
+CLZ_API bool dynarray_remove_first(dynarray *d, void *obj) {
+    CLZ_STATS_CALL(dynarray_remove_first);
+    CLZ_USDT_TIMER(t0);
     void **ptr_new = (void **) calloc(d->alloc_size, sizeof(void *));
     if (ptr_new == NULL) {
         return false;
     }
+    CLZ_STATS_ALLOC(dynarray_remove_first, d->alloc_size * sizeof(void *));
+    CLZ_STATS_COPY(dynarray_remove_first, d->data_size * sizeof(void *));
 
     bool done = false;
     size_t index = 0;
@@ -515,15 +563,21 @@ bool dynarray_remove_first(dynarray *d, void *obj) {
     free(d->ptr);
     d->ptr = ptr_new;
     d->data_size += done ? -1 : 0;
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, 0, done ? -(int64_t) sizeof(void *) : 0);
+    CLZ_PROBE3(dynarray_remove_realloc, d->data_size + done, d->data_size, CLZ_USDT_ELAPSED(t0));
 
     return done;
 }
 
-bool dynarray_remove_all(dynarray *d, void *obj) {
+CLZ_API bool dynarray_remove_all(dynarray *d, void *obj) {
+    CLZ_STATS_CALL(dynarray_remove_all);
+    CLZ_USDT_TIMER(t0);
     void **ptr_new = (void **) calloc(d->alloc_size, sizeof(void *));
     if (ptr_new == NULL) {
         return false;
     }
+    CLZ_STATS_ALLOC(dynarray_remove_all, d->alloc_size * sizeof(void *));
+    CLZ_STATS_COPY(dynarray_remove_all, d->data_size * sizeof(void *));
 
     size_t index = 0;
     int counter = 0;
@@ -541,16 +595,22 @@ bool dynarray_remove_all(dynarray *d, void *obj) {
     free(d->ptr);
     d->ptr = ptr_new;
     d->data_size -= counter;
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, 0, -(int64_t) (counter * sizeof(void *)));
+    CLZ_PROBE3(dynarray_remove_realloc, d->data_size + counter, d->data_size, CLZ_USDT_ELAPSED(t0));
 
     return counter > 0;
 }
 
-bool dynarray_remove_index(dynarray *d, size_t index) {
+CLZ_API bool dynarray_remove_index(dynarray *d, size_t index) {
+    CLZ_STATS_CALL(dynarray_remove_index);
+    CLZ_USDT_TIMER(t0);
     void **ptr_new = (void **) calloc(d->alloc_size, sizeof(void *));
     if (ptr_new == NULL) {
         return false;
     }
     else if (index >= d->alloc_size) return false;
+    CLZ_STATS_ALLOC(dynarray_remove_index, d->alloc_size * sizeof(void *));
+    CLZ_STATS_COPY(dynarray_remove_index, d->data_size * sizeof(void *));
 
     int j = 0;
 
@@ -566,20 +626,25 @@ bool dynarray_remove_index(dynarray *d, size_t index) {
     free(d->ptr);
     d->ptr = ptr_new;
     d->data_size += -1;
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, 0, -(int64_t) sizeof(void *));
+    CLZ_PROBE3(dynarray_remove_realloc, d->data_size + 1, d->data_size, CLZ_USDT_ELAPSED(t0));
 
     return true;
 }
 
-void dynarray_clear(dynarray *d, bool tofree) {
+CLZ_API void dynarray_clear(dynarray *d, bool tofree) {
+    CLZ_STATS_CALL(dynarray_clear);
     if (tofree) {
         for (int i = 0; i < d->data_size; ++i) {
             free(dynarray_get(d, i));
         }
     }
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_DYNARRAY, 0, 0, -(int64_t) (d->data_size * sizeof(void *)));
     d->data_size = 0;
 }
 
-void *dynarray_get(dynarray *d, size_t index) {
+CLZ_API void *dynarray_get(dynarray *d, size_t index) {
+    CLZ_STATS_CALL(dynarray_get);
     if (index >= d->data_size) {
         return NULL;
     }
@@ -587,7 +652,8 @@ void *dynarray_get(dynarray *d, size_t index) {
     return *(d->ptr + index);
 }
 
-int dynarray_find_first(dynarray *d, void *obj) {
+CLZ_API int dynarray_find_first(dynarray *d, void *obj) {
+    CLZ_STATS_CALL(dynarray_find_first);
     for (int i = 0; i < d->data_size; ++i) {
         if (*(d->ptr + i) == obj) {
             return i;
@@ -597,7 +663,8 @@ int dynarray_find_first(dynarray *d, void *obj) {
     return CLZ_NOT_FOUND;
 }
 
-int dynarray_find_next(dynarray *d, void *obj) {
+CLZ_API int dynarray_find_next(dynarray *d, void *obj) {
+    CLZ_STATS_CALL(dynarray_find_next);
     for (int i = d->find_index + 1; i < d->data_size; ++i) {
         if (*(d->ptr + i) == obj) {
             d->find_index = i;
@@ -608,13 +675,15 @@ int dynarray_find_next(dynarray *d, void *obj) {
     return CLZ_NOT_FOUND;
 }
 
-void dynarray_foreach(dynarray *d, clz_consumer c) {
+CLZ_API void dynarray_foreach(dynarray *d, clz_consumer c) {
+    CLZ_STATS_CALL(dynarray_foreach);
     for (int i = 0; i < d->data_size; ++i) {
         c(*(d->ptr + i));
     }
 }
 
-void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c) {
+CLZ_API void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c) {
+    CLZ_STATS_CALL(dynarray_foreach_if);
     for (int i = 0; i < d->data_size; ++i) {
         if (p(*(d->ptr + i))) {
             c(*(d->ptr + i));
@@ -622,7 +691,8 @@ void dynarray_foreach_if(dynarray *d, clz_predicate p, clz_consumer c) {
     }
 }
 
-void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, clz_consumer elsec) {
+CLZ_API void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, clz_consumer elsec) {
+    CLZ_STATS_CALL(dynarray_foreach_if_else);
     for (int i = 0; i < d->data_size; ++i) {
         if (p(*(d->ptr + i))) {
             ifc(*(d->ptr + i));
@@ -631,11 +701,21 @@ void dynarray_foreach_if_else(dynarray *d, clz_predicate p, clz_consumer ifc, cl
     }
 }
 
-void *dynarray_pop(dynarray *d) {
+CLZ_API void *dynarray_pop(dynarray *d) {
+    CLZ_STATS_CALL(dynarray_pop);
     if (d->data_size == 0) return NULL;
     void *obj = dynarray_get(d, dynarray_length(d) - 1);
     dynarray_remove_index(d, dynarray_length(d) - 1);
     return obj;
 }
 
+CLZ_API clz_footprint dynarray_footprint(dynarray *d) {
+    CLZ_STATS_CALL(dynarray_footprint);
+    clz_footprint fp = {
+        .used = d->data_size * sizeof(void *),
+        .reserved = d->alloc_size * sizeof(void *)
+    };
+    return fp;
+}
+
 #endif
@@ -0,0 +1,227 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains the declarations of the memory footprint registry of the library. If the macro
+ * `CLZ_FOOTPRINT_REGISTRY` is defined (typically with `-DCLZ_FOOTPRINT_REGISTRY` for the whole program), the
+ * containers of the library keep process-wide totals of
+ *  - how many containers of every type are alive,
+ *  - how many bytes they have reserved on the heap,
+ *  - how many of those bytes hold data.
+ *
+ * The difference between the last two is the capacity that is allocated but unused, which is what a metrics
+ * endpoint usually wants to watch. The footprint of a single container is available without the registry, see
+ * @ref strbuf_footprint and @ref dynarray_footprint.
+ *
+ * The totals are updated with relaxed atomic additions on every allocation, resize and length change, so they
+ * are safe to read from any thread but only exact while no container is being modified. A @ref dynarray counts
+ * its element buffer, not the struct itself, which may live on the stack. String buffers in text mode do not store
+ * their length, so their used bytes cannot be known: they are counted under their own type,
+ * @ref CLZ_FOOTPRINT_STRBUF_TEXT, with their reserved bytes only, and move to @ref CLZ_FOOTPRINT_STRBUF when they
+ * switch to binary mode, see @ref strbuf_make_binary. For every other type, the difference between the two totals
+ * is the unused capacity.
+ * If `CLZ_FOOTPRINT_REGISTRY` is not defined, the macros expand to nothing and the totals stay zero.
+ *
+ * Example:
+ *
+ * @code
+ *     char *out = strbuf_new();
+ *     clz_footprint_dump(&out, true);
+ *     // {"strbuf":{"containers":2,"reserved":544,"used":371},"dynarray":{"containers":3,"reserved":384,"used":136},
+ *     //  "strbuf_text":{"containers":10,"reserved":1088}}
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_FOOTPRINT_IMPL` is defined beforehand. It has to be
+ * included exactly once in a program that defines `CLZ_FOOTPRINT_REGISTRY`, since it holds the totals.
+ *
+ * @file footprint.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for the opt-in memory footprint registry of the library
+ *
+ */
+
+#ifndef _CLZ_FOOTPRINT_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_FOOTPRINT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Definition of enum identifying the container types known to the registry
+ *
+ * `CLZ_FOOTPRINT_STRBUF` counts the strbufs in binary mode, `CLZ_FOOTPRINT_STRBUF_TEXT` those in text mode, whose
+ * used bytes are not tracked. `CLZ_FOOTPRINT_TYPE_COUNT` is the number of container types.
+ */
+enum clz_footprint_type {
+    CLZ_FOOTPRINT_STRBUF,
+    CLZ_FOOTPRINT_DYNARRAY,
+    CLZ_FOOTPRINT_STRBUF_TEXT,
+    CLZ_FOOTPRINT_TYPE_COUNT
+};
+
+/**
+ * @brief Definition of structure holding the totals of a single container type
+ */
+typedef struct clz_footprint_totals {
+    /**
+     * @brief Number of live containers
+     */
+    int64_t containers;
+    /**
+     * @brief Heap bytes reserved by the live containers
+     */
+    int64_t reserved;
+    /**
+     * @brief Heap bytes holding data
+     */
+    int64_t used;
+} clz_footprint_totals;
+
+/**
+ * @brief Copies the current totals.
+ *
+ * @param out The destination, indexed by @ref clz_footprint_type
+ */
+void clz_footprint_snapshot(clz_footprint_totals out[CLZ_FOOTPRINT_TYPE_COUNT]);
+/**
+ * @brief Returns the name of a container type
+ *
+ * @param type The container type
+ * @return The name, or `"invalid"`
+ */
+const char *clz_footprint_name(enum clz_footprint_type type);
+/**
+ * @brief Appends the current totals to a strbuf in human-readable or JSON form.
+ *
+ * In text form, a header line is followed by one line per container type, including the wasted bytes.
+ * In JSON form, a single object maps every container type to an object holding its totals. The used and wasted
+ * bytes of @ref CLZ_FOOTPRINT_STRBUF_TEXT are unknown, they are shown as `-` in text form and left out of the JSON.
+ *
+ * This function requires the implementation of @ref strbuf.h. Since heap allocation is used, failure is possible,
+ * in which case `false` is returned and the buffer may hold a partial dump.
+ *
+ * @param destbuf The destination buffer
+ * @param json Whether to emit JSON instead of text
+ * @return `true` if successful
+ */
+bool clz_footprint_dump(char **destbuf, bool json);
+
+/**
+ * @brief The totals. Use the API above instead of accessing this directly.
+ */
+extern clz_footprint_totals _clz_footprint_registry[CLZ_FOOTPRINT_TYPE_COUNT];
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef CLZ_FOOTPRINT_REGISTRY
+
+/**
+ * @brief Adds the given deltas to the totals of the container type `type`
+ */
+#define CLZ_FOOTPRINT_ADD(type, containers_, reserved_, used_) \
+    (__atomic_fetch_add(&_clz_footprint_registry[type].containers, (int64_t) (containers_), __ATOMIC_RELAXED), \
+     __atomic_fetch_add(&_clz_footprint_registry[type].reserved, (int64_t) (reserved_), __ATOMIC_RELAXED), \
+     __atomic_fetch_add(&_clz_footprint_registry[type].used, (int64_t) (used_), __ATOMIC_RELAXED))
+
+#else
+
+#define CLZ_FOOTPRINT_ADD(type, containers_, reserved_, used_) ((void) 0)
+
+#endif
+
+#endif
+
+#ifdef CLZ_FOOTPRINT_IMPL
+#undef CLZ_FOOTPRINT_IMPL
+
+#include <stdio.h>
+
+// the implementation of strbuf.h depends on both headers
+#include "stats.h"
+#include "strbuf.h"
+
+clz_footprint_totals _clz_footprint_registry[CLZ_FOOTPRINT_TYPE_COUNT];
+
+static const char *_clz_footprint_names[] = {"strbuf", "dynarray", "strbuf_text"};
+
+void clz_footprint_snapshot(clz_footprint_totals out[CLZ_FOOTPRINT_TYPE_COUNT]) {
+    for (size_t i = 0; i < CLZ_FOOTPRINT_TYPE_COUNT; ++i) {
+        out[i].containers = __atomic_load_n(&_clz_footprint_registry[i].containers, __ATOMIC_RELAXED);
+        out[i].reserved = __atomic_load_n(&_clz_footprint_registry[i].reserved, __ATOMIC_RELAXED);
+        out[i].used = __atomic_load_n(&_clz_footprint_registry[i].used, __ATOMIC_RELAXED);
+    }
+}
+
+const char *clz_footprint_name(enum clz_footprint_type type) {
+    if ((size_t) type >= CLZ_FOOTPRINT_TYPE_COUNT) return "invalid";
+    return _clz_footprint_names[type];
+}
+
+bool clz_footprint_dump(char **destbuf, bool json) {
+    clz_footprint_totals totals[CLZ_FOOTPRINT_TYPE_COUNT];
+    clz_footprint_snapshot(totals);
+    char line[256];
+    bool ok = true;
+
+    if (json) ok &= strbuf_append_char(destbuf, '{');
+    else {
+        snprintf(line, sizeof(line), "%-12s %12s %16s %16s %16s\n", "type", "containers", "reserved", "used", "wasted");
+        ok &= strbuf_append_str(destbuf, line);
+    }
+
+    for (size_t i = 0; i < CLZ_FOOTPRINT_TYPE_COUNT; ++i) {
+        clz_footprint_totals *t = totals + i;
+        if (json && i == CLZ_FOOTPRINT_STRBUF_TEXT) {
+            snprintf(line, sizeof(line), "%s\"%s\":{\"containers\":%lld,\"reserved\":%lld}",
+                     i ? "," : "", _clz_footprint_names[i], (long long) t->containers, (long long) t->reserved);
+        } else if (json) {
+            snprintf(line, sizeof(line), "%s\"%s\":{\"containers\":%lld,\"reserved\":%lld,\"used\":%lld}",
+                     i ? "," : "", _clz_footprint_names[i],
+                     (long long) t->containers, (long long) t->reserved, (long long) t->used);
+        } else if (i == CLZ_FOOTPRINT_STRBUF_TEXT) {
+            snprintf(line, sizeof(line), "%-12s %12lld %16lld %16s %16s\n", _clz_footprint_names[i],
+                     (long long) t->containers, (long long) t->reserved, "-", "-");
+        } else {
+            snprintf(line, sizeof(line), "%-12s %12lld %16lld %16lld %16lld\n", _clz_footprint_names[i],
+                     (long long) t->containers, (long long) t->reserved, (long long) t->used,
+                     (long long) (t->reserved - t->used));
+        }
+        ok &= strbuf_append_str(destbuf, line);
+    }
+
+    if (json) ok &= strbuf_append_char(destbuf, '}');
+    return ok;
+}
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a matcher for wildcard patterns, compiled once and then matched against any number of
+ * strings. The following syntax is supported:
+ *
+ * - `*` matches any sequence of bytes, including the empty one
+ * - `?` matches any single byte
+ * - `[abc]`, `[a-z]` match one byte of the set, `[!abc]` or `[^abc]` one byte outside of it
+ * - `\` matches the next character literally, or itself at the end of the pattern
+ *
+ * A `[` without a matching `]` is taken literally. Matching is done on bytes, so `?` matches a single byte of
+ * a multibyte UTF-8 character.
+ *
+ * Matching never backtracks: the stars split the pattern into segments of fixed length. The first and the last
+ * segment are anchored to the start and the end of the string, the others are searched from left to right, each
+ * one at its leftmost position after the previous one, which is the placement leaving the most room to the rest.
+ * Each byte of the string is therefore examined by at most one search per segment. Segments made of literal bytes
+ * only are searched with @ref strbuf_memmem, which compares the first and last byte of the segment at 16 positions
+ * at a time.
+ *
+ * Example:
+ *
+ * @code
+ *     glob_pattern g;
+ *     if (!glob_compile(&g, "user:*:session-??")) return false;
+ *     if (glob_match(&g, key, strbuf_length(key))) ...
+ *     glob_filter(&g, &keys, &matching);
+ *     glob_free(&g);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_GLOB_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h and @ref dynarray.h.
+ *
+ * @file glob.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a compiled wildcard matcher
+ *
+ */
+
+#ifndef _CLZ_GLOB_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_GLOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * @brief Definition of a compiled pattern
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct glob_pattern {
+    /**
+     * @brief The segments of the pattern between stars
+     */
+    struct _glob_seg *segs;
+    /**
+     * @brief The number of segments, which is one more than the number of stars
+     */
+    size_t nsegs;
+    /**
+     * @brief The bytes of all segments
+     */
+    unsigned char *bytes;
+    /**
+     * @brief The byte sets of all segments, a bitmap of 32 bytes per pattern byte
+     */
+    uint8_t (*sets)[32];
+    /**
+     * @brief The minimum length of a matching string
+     */
+    size_t minlen;
+} glob_pattern;
+
+/**
+ * @brief Compiles a pattern.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param g The pattern to initialize
+ * @param pattern The null-terminated pattern
+ * @return `true` if successful
+ *
+ * @see glob_free, glob_match
+ */
+bool glob_compile(glob_pattern *g, const char *pattern);
+/**
+ * @brief Frees the memory held by a compiled pattern.
+ *
+ * @param g The pattern
+ */
+void glob_free(glob_pattern *g);
+/**
+ * @brief Tells whether a whole string matches a pattern.
+ *
+ * The string may contain null bytes, see @ref strbuf_length to match a strbuf.
+ *
+ * @param g The pattern
+ * @param s The string
+ * @param len The length of the string
+ * @return `true` if the string matches
+ */
+bool glob_match(glob_pattern *g, const char *s, size_t len);
+/**
+ * @brief Appends the strbufs of a @ref dynarray matching a pattern to another one.
+ *
+ * The strbufs are not copied: `out` receives the same pointers as `d`, in the same order.
+ *
+ * Since heap allocation may be used, failure is possible. In this case, `false` is returned, `errno` is set
+ * to `ENOMEM` and `out` holds the matches found so far.
+ *
+ * @param g The pattern
+ * @param d The array of strbufs
+ * @param out The array receiving the matching strbufs
+ * @return `true` if successful
+ */
+bool glob_filter(glob_pattern *g, dynarray *d, dynarray *out);
+
+#endif
+
+#ifdef CLZ_GLOB_IMPL
+#undef CLZ_GLOB_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+struct _glob_seg {
+    // position in the bytes and sets of the pattern
+    size_t off;
+    size_t len;
+    // whether the segment has no `?` or sets, in which case only its bytes are used
+    bool literal;
+};
+
+static inline bool _glob_at(glob_pattern *g, struct _glob_seg *seg, const unsigned char *s) {
+    if (seg->literal) return !memcmp(s, g->bytes + seg->off, seg->len);
+    for (size_t i = 0; i < seg->len; ++i) {
+        if (!(g->sets[seg->off + i][s[i] >> 3] & (1 << (s[i] & 7)))) return false;
+    }
+    return true;
+}
+
+static const char *_glob_find(glob_pattern *g, struct _glob_seg *seg, const char *h, size_t hlen) {
+    if (seg->literal) return strbuf_memmem(h, hlen, g->bytes + seg->off, seg->len);
+    if (seg->len > hlen) return NULL;
+    for (const char *p = h, *last = h + hlen - seg->len; p <= last; ++p) {
+        if (_glob_at(g, seg, (const unsigned char *) p)) return p;
+    }
+    return NULL;
+}
+
+// parses the set starting after `[`, returning the position after `]`, or NULL if there is none
+static const char *_glob_set(const char *p, uint8_t set[32]) {
+    bool negate = *p == '!' || *p == '^';
+    if (negate) ++p;
+    memset(set, 0, 32);
+    // a `]` right after the opening bracket is a member
+    for (bool first = true; *p && (*p != ']' || first); first = false) {
+        unsigned char lo = (unsigned char) *p++, hi = lo;
+        if (lo == '\\' && *p) lo = hi = (unsigned char) *p++;
+        if (p[0] == '-' && p[1] && p[1] != ']') {
+            hi = (unsigned char) p[1];
+            p += 2;
+            if (hi == '\\' && *p) hi = (unsigned char) *p++;
+        }
+        for (unsigned c = lo; c <= hi; ++c) set[c >> 3] |= 1 << (c & 7);
+    }
+    if (*p != ']') return NULL;
+    if (negate) {
+        for (int i = 0; i < 32; ++i) set[i] = ~set[i];
+    }
+    return p + 1;
+}
+
+bool glob_compile(glob_pattern *g, const char *pattern) {
+    size_t plen = strlen(pattern), nsegs = 1;
+    for (const char *p = pattern; *p; ++p) {
+        if (*p == '\\' && p[1]) ++p;
+        else if (*p == '*') ++nsegs;
+    }
+    g->segs = malloc(nsegs * sizeof(struct _glob_seg));
+    g->bytes = malloc(plen + 1);
+    g->sets = malloc((plen + 1) * sizeof(*g->sets));
+    if (!g->segs || !g->bytes || !g->sets) {
+        glob_free(g);
+        errno = ENOMEM;
+        return false;
+    }
+
+    struct _glob_seg *seg = g->segs;
+    seg->off = seg->len = 0;
+    seg->literal = true;
+    g->nsegs = 1;
+    g->minlen = 0;
+    size_t n = 0;
+    for (const char *p = pattern; *p;) {
+        uint8_t *set = g->sets[n];
+        const char *next = NULL;
+        if (*p == '*') {
+            // consecutive stars are one
+            while (*p == '*') ++p;
+            ++seg;
+            ++g->nsegs;
+            seg->off = n;
+            seg->len = 0;
+            seg->literal = true;
+            continue;
+        }
+        if (*p == '?') {
+            memset(set, 0xFF, 32);
+            seg->literal = false;
+            next = p + 1;
+        } else if (*p == '[' && (next = _glob_set(p + 1, set))) {
+            seg->literal = false;
+        } else {
+            if (*p == '\\' && p[1]) ++p;
+            next = p + 1;
+            memset(set, 0, 32);
+            set[(unsigned char) *p >> 3] = 1 << ((unsigned char) *p & 7);
+        }
+        g->bytes[n++] = (unsigned char) *p;
+        ++seg->len;
+        ++g->minlen;
+        p = next;
+    }
+
+    return true;
+}
+
+void glob_free(glob_pattern *g) {
+    free(g->segs);
+    free(g->bytes);
+    free(g->sets);
+    g->segs = NULL;
+    g->bytes = NULL;
+    g->sets = NULL;
+}
+
+bool glob_match(glob_pattern *g, const char *s, size_t len) {
+    struct _glob_seg *first = g->segs, *last = g->segs + g->nsegs - 1;
+    if (len < g->minlen) return false;
+    if (g->nsegs == 1) return len == first->len && _glob_at(g, first, (const unsigned char *) s);
+    if (!_glob_at(g, first, (const unsigned char *) s)) return false;
+
+    // the last segment is anchored to the end, and the middle ones have to fit before it
+    size_t pos = first->len, end = len - last->len;
+    for (struct _glob_seg *seg = first + 1; seg < last; ++seg) {
+        const char *p = _glob_find(g, seg, s + pos, end - pos);
+        if (!p) return false;
+        pos = p - s + seg->len;
+    }
+    return _glob_at(g, last, (const unsigned char *) s + end);
+}
+
+bool glob_filter(glob_pattern *g, dynarray *d, dynarray *out) {
+    for (size_t i = 0; i < dynarray_length(d); ++i) {
+        char *buf = dynarray_at(d, i);
+        if (!glob_match(g, buf, strbuf_length(buf))) continue;
+        if (!dynarray_append(out, buf)) {
+            errno = ENOMEM;
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,477 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * A @ref histogram is a high dynamic range (HDR) histogram: it records integer values, typically latencies in
+ * nanoseconds, between 1 and a configurable maximum with a fixed number of significant decimal digits, so that
+ * for example with 3 significant digits both 1500 ns and 1.5 s are recorded with an error of at most 0.1%.
+ *
+ * The memory of the histogram is allocated once by @ref histogram_new and depends only on the range and
+ * precision (about 264 KiB for one hour in nanoseconds with 3 digits). Recording a value is a handful of
+ * integer instructions and never allocates.
+ *
+ * For multi-threaded programs, there are two options:
+ *  - each thread records into its own histogram with @ref histogram_record and the histograms are combined with
+ *    @ref histogram_merge when reporting,
+ *  - all threads record into the same histogram with @ref histogram_record_atomic.
+ *
+ * Example:
+ *
+ * @code
+ *     histogram *h = histogram_new(3600000000000LL, 3); // up to one hour in ns, 3 significant digits
+ *     for (...) {
+ *         uint64_t t0 = now_ns();
+ *         handle_request();
+ *         histogram_record(h, now_ns() - t0);
+ *     }
+ *     char *report = strbuf_new();
+ *     histogram_dump(h, &report);
+ *     puts(report);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_HISTOGRAM_IMPL` is defined beforehand. The functions
+ * working with strbufs require the implementation of @ref strbuf.h to be included as well.
+ *
+ * @file histogram.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a high dynamic range latency histogram
+ *
+ */
+
+#ifndef _CLZ_HISTOGRAM_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+#include "strbuf.h"
+
+/**
+ * @brief Definition of structure representing an HDR histogram
+ *
+ * **Notes**
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ * Use the provided API instead!
+ *
+ * @see histogram_new, histogram_record, histogram_value_at_percentile
+ */
+typedef struct histogram {
+    /**
+     * @brief The highest value that can be recorded
+     */
+    int64_t highest;
+    /**
+     * @brief The number of significant decimal digits
+     */
+    int sigfigs;
+    /**
+     * @brief Base 2 logarithm of @ref sub_bucket_half_count
+     */
+    int sub_bucket_half_count_magnitude;
+    /**
+     * @brief The number of linear sub-buckets per power of 2
+     */
+    int64_t sub_bucket_count;
+    /**
+     * @brief Half of @ref sub_bucket_count
+     */
+    int64_t sub_bucket_half_count;
+    /**
+     * @brief Mask of the values that fall into the first bucket
+     */
+    int64_t sub_bucket_mask;
+    /**
+     * @brief The number of entries of @ref counts
+     */
+    size_t counts_len;
+    /**
+     * @brief The number of recorded values
+     */
+    int64_t total;
+    /**
+     * @brief The smallest recorded value, `INT64_MAX` if empty
+     */
+    int64_t min;
+    /**
+     * @brief The largest recorded value, `0` if empty
+     */
+    int64_t max;
+    /**
+     * @brief The counts
+     */
+    int64_t counts[];
+} histogram;
+
+/**
+ * @brief Allocates a new, empty histogram.
+ *
+ * The histogram can record values from `0` to `highest`, which must be at least 2, with a precision of
+ * `sigfigs` significant decimal digits, which must be between 1 and 5.
+ *
+ * This function makes use of dynamic allocation (see `malloc` family). As such, it could _fail_
+ * if heap allocation fails. In this case, or if the parameters are invalid, `NULL` is returned.
+ *
+ * **Notes**
+ *
+ * Use @ref histogram_free on histograms returned by this function after done using.
+ *
+ * @param highest The highest value that can be recorded
+ * @param sigfigs The number of significant decimal digits
+ * @return The pointer to the histogram if successful, `NULL` otherwise
+ *
+ * @see histogram_free
+ */
+histogram *histogram_new(int64_t highest, int sigfigs);
+/**
+ * @brief Frees a histogram.
+ *
+ * @param h The histogram
+ */
+void histogram_free(histogram *h);
+/**
+ * @brief Removes all recorded values.
+ *
+ * @param h The histogram
+ */
+void histogram_reset(histogram *h);
+/**
+ * @brief Records a value.
+ *
+ * If `value` is negative or greater than the highest trackable value, nothing is recorded and `false` is returned.
+ * This function must not be used concurrently on the same histogram, see @ref histogram_record_atomic.
+ *
+ * @param h The histogram
+ * @param value The value
+ * @return `true` if successful
+ *
+ * @see histogram_record_n, histogram_record_atomic
+ */
+bool histogram_record(histogram *h, int64_t value);
+/**
+ * @brief Records a value `n` times.
+ *
+ * @param h The histogram
+ * @param value The value
+ * @param n The number of times
+ * @return `true` if successful
+ *
+ * @see histogram_record
+ */
+bool histogram_record_n(histogram *h, int64_t value, int64_t n);
+/**
+ * @brief Records a value, safely with respect to concurrent recordings into the same histogram.
+ *
+ * The counters are updated with relaxed atomic operations, so this is somewhat slower than @ref histogram_record
+ * and scales worse when many threads record into the same histogram. Queries and @ref histogram_merge should
+ * not run concurrently with recordings.
+ *
+ * @param h The histogram
+ * @param value The value
+ * @return `true` if successful
+ *
+ * @see histogram_record
+ */
+bool histogram_record_atomic(histogram *h, int64_t value);
+/**
+ * @brief Adds all the values recorded by `src` to `dest`.
+ *
+ * If both histograms have the same configuration, the counts are simply added. Otherwise every bucket of `src` is
+ * recorded into `dest` at its representative value. Values that do not fit into `dest` are skipped and counted.
+ *
+ * @param dest The destination histogram
+ * @param src The source histogram
+ * @return The number of values that could not be recorded into `dest`
+ */
+int64_t histogram_merge(histogram *dest, histogram *src);
+
+/**
+ * @brief Returns the value below or at which the given percentage of recorded values lie.
+ *
+ * The result is the highest value that is equivalent (within the precision of the histogram) to the value at the
+ * percentile. `percentile` is clamped to the range from 0 to 100. If the histogram is empty, `0` is returned.
+ *
+ * @param h The histogram
+ * @param percentile The percentile, e.g. `99.9`
+ * @return The value at the percentile
+ */
+int64_t histogram_value_at_percentile(histogram *h, double percentile);
+/**
+ * @brief Returns the mean of the recorded values, `0` if the histogram is empty.
+ *
+ * @param h The histogram
+ * @return The mean
+ */
+double histogram_mean(histogram *h);
+
+/**
+ * @brief Appends a summary of the histogram to a strbuf.
+ *
+ * The summary consists of the count, minimum, mean, the 50th, 90th, 99th, 99.9th and 99.99th percentile and the maximum,
+ * on a single line.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned.
+ *
+ * @param h The histogram
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ */
+bool histogram_dump(histogram *h, char **destbuf);
+/**
+ * @brief Appends a serialized form of the histogram to a strbuf.
+ *
+ * The serialized form is a single line of text holding the configuration and the non-zero counts, which can be
+ * parsed back with @ref histogram_deserialize, for example to merge the histograms of several processes.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned.
+ *
+ * @param h The histogram
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ *
+ * @see histogram_deserialize
+ */
+bool histogram_serialize(histogram *h, char **destbuf);
+/**
+ * @brief Creates a histogram from its serialized form.
+ *
+ * If the string is not a valid serialized histogram or heap allocation fails, `NULL` is returned.
+ *
+ * @param s The serialized histogram, as produced by @ref histogram_serialize
+ * @return The new histogram if successful, `NULL` otherwise
+ *
+ * @see histogram_serialize
+ */
+histogram *histogram_deserialize(char *s);
+
+#endif
+
+#ifdef CLZ_HISTOGRAM_IMPL
+#undef CLZ_HISTOGRAM_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static inline size_t _histogram_index(histogram *h, int64_t value) {
+    int pow2ceiling = 64 - __builtin_clzll((uint64_t) (value | h->sub_bucket_mask));
+    int bucket = pow2ceiling - (h->sub_bucket_half_count_magnitude + 1);
+    int64_t sub_bucket = value >> bucket;
+    return ((size_t) (bucket + 1) << h->sub_bucket_half_count_magnitude) + (sub_bucket - h->sub_bucket_half_count);
+}
+
+static inline int64_t _histogram_value(histogram *h, size_t index) {
+    int bucket = (int) (index >> h->sub_bucket_half_count_magnitude) - 1;
+    int64_t sub_bucket = (int64_t) (index & (h->sub_bucket_half_count - 1)) + h->sub_bucket_half_count;
+    if (bucket < 0) {
+        sub_bucket -= h->sub_bucket_half_count;
+        bucket = 0;
+    }
+    return sub_bucket << bucket;
+}
+
+static inline int64_t _histogram_highest_equivalent(histogram *h, size_t index) {
+    int bucket = (int) (index >> h->sub_bucket_half_count_magnitude) - 1;
+    if (bucket < 0) bucket = 0;
+    return _histogram_value(h, index) + ((int64_t) 1 << bucket) - 1;
+}
+
+histogram *histogram_new(int64_t highest, int sigfigs) {
+    if (highest < 2 || sigfigs < 1 || sigfigs > 5) return NULL;
+
+    int64_t largest_single_unit = 2;
+    for (int i = 0; i < sigfigs; ++i) largest_single_unit *= 10;
+    int sub_bucket_count_magnitude = 0;
+    while (((int64_t) 1 << sub_bucket_count_magnitude) < largest_single_unit) ++sub_bucket_count_magnitude;
+
+    int64_t sub_bucket_count = (int64_t) 1 << sub_bucket_count_magnitude;
+    int buckets = 1;
+    for (int64_t smallest_untrackable = sub_bucket_count; smallest_untrackable <= highest; ++buckets) {
+        if (smallest_untrackable > INT64_MAX / 2) {
+            ++buckets;
+            break;
+        }
+        smallest_untrackable <<= 1;
+    }
+
+    size_t counts_len = (size_t) (buckets + 1) * (size_t) (sub_bucket_count / 2);
+    histogram *h = calloc(1, sizeof(histogram) + counts_len * sizeof(int64_t));
+    if (h == NULL) return NULL;
+
+    h->highest = highest;
+    h->sigfigs = sigfigs;
+    h->sub_bucket_half_count_magnitude = sub_bucket_count_magnitude - 1;
+    h->sub_bucket_count = sub_bucket_count;
+    h->sub_bucket_half_count = sub_bucket_count / 2;
+    h->sub_bucket_mask = sub_bucket_count - 1;
+    h->counts_len = counts_len;
+    h->min = INT64_MAX;
+    return h;
+}
+
+void histogram_free(histogram *h) {
+    free(h);
+}
+
+void histogram_reset(histogram *h) {
+    memset(h->counts, 0, h->counts_len * sizeof(int64_t));
+    h->total = 0;
+    h->min = INT64_MAX;
+    h->max = 0;
+}
+
+bool histogram_record(histogram *h, int64_t value) {
+    return histogram_record_n(h, value, 1);
+}
+
+bool histogram_record_n(histogram *h, int64_t value, int64_t n) {
+    if (value < 0 || value > h->highest) return false;
+    h->counts[_histogram_index(h, value)] += n;
+    h->total += n;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    return true;
+}
+
+bool histogram_record_atomic(histogram *h, int64_t value) {
+    if (value < 0 || value > h->highest) return false;
+    __atomic_fetch_add(&h->counts[_histogram_index(h, value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->total, 1, __ATOMIC_RELAXED);
+
+    int64_t cur = __atomic_load_n(&h->min, __ATOMIC_RELAXED);
+    while (value < cur && !__atomic_compare_exchange_n(&h->min, &cur, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    cur = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    while (value > cur && !__atomic_compare_exchange_n(&h->max, &cur, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
+}
+
+int64_t histogram_merge(histogram *dest, histogram *src) {
+    if (dest->sigfigs == src->sigfigs && dest->counts_len >= src->counts_len && src->max <= dest->highest) {
+        for (size_t i = 0; i < src->counts_len; ++i) dest->counts[i] += src->counts[i];
+        dest->total += src->total;
+        if (src->min < dest->min) dest->min = src->min;
+        if (src->max > dest->max) dest->max = src->max;
+        return 0;
+    }
+
+    int64_t dropped = 0;
+    for (size_t i = 0; i < src->counts_len; ++i) {
+        if (src->counts[i] == 0) continue;
+        int64_t value = _histogram_value(src, i);
+        if (i == _histogram_index(src, src->max)) value = src->max;
+        if (!histogram_record_n(dest, value, src->counts[i])) dropped += src->counts[i];
+    }
+    return dropped;
+}
+
+int64_t histogram_value_at_percentile(histogram *h, double percentile) {
+    if (h->total == 0) return 0;
+    if (percentile < 0) percentile = 0;
+    if (percentile > 100) percentile = 100;
+
+    int64_t target = (int64_t) (percentile / 100 * (double) h->total + 0.5);
+    if (target < 1) target = 1;
+
+    int64_t seen = 0;
+    for (size_t i = 0; i < h->counts_len; ++i) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            int64_t value = _histogram_highest_equivalent(h, i);
+            return value > h->max ? h->max : value;
+        }
+    }
+    return h->max;
+}
+
+double histogram_mean(histogram *h) {
+    if (h->total == 0) return 0;
+    double sum = 0;
+    for (size_t i = 0; i < h->counts_len; ++i) {
+        if (h->counts[i] == 0) continue;
+        // the middle of the range of equivalent values
+        double lo = (double) _histogram_value(h, i), hi = (double) _histogram_highest_equivalent(h, i);
+        sum += (lo + hi) / 2 * (double) h->counts[i];
+    }
+    return sum / (double) h->total;
+}
+
+bool histogram_dump(histogram *h, char **destbuf) {
+    char line[320];
+    snprintf(line, sizeof(line),
+             "count=%lld min=%lld mean=%.1f p50=%lld p90=%lld p99=%lld p99.9=%lld p99.99=%lld max=%lld",
+             (long long) h->total, (long long) (h->total ? h->min : 0), histogram_mean(h),
+             (long long) histogram_value_at_percentile(h, 50), (long long) histogram_value_at_percentile(h, 90),
+             (long long) histogram_value_at_percentile(h, 99), (long long) histogram_value_at_percentile(h, 99.9),
+             (long long) histogram_value_at_percentile(h, 99.99), (long long) h->max);
+    return strbuf_append_str(destbuf, line);
+}
+
+bool histogram_serialize(histogram *h, char **destbuf) {
+    // HDR1 <highest> <sigfigs> <min> <max> <index>:<count> ...
+    size_t len = strbuf_length(*destbuf), extra = 96;
+    for (size_t i = 0; i < h->counts_len; ++i) {
+        if (h->counts[i]) extra += 42;
+    }
+    if (strbuf_alloc_size(*destbuf) < len + extra && !strbuf_resize(destbuf, len + extra)) return false;
+
+    char *p = *destbuf + len;
+    p += sprintf(p, "HDR1 %lld %d %lld %lld", (long long) h->highest, h->sigfigs,
+                 (long long) (h->total ? h->min : 0), (long long) h->max);
+    for (size_t i = 0; i < h->counts_len; ++i) {
+        if (h->counts[i]) p += sprintf(p, " %zu:%lld", i, (long long) h->counts[i]);
+    }
+    return strbuf_set_length(destbuf, p - *destbuf);
+}
+
+histogram *histogram_deserialize(char *s) {
+    long long highest, min, max;
+    int sigfigs, consumed;
+    if (sscanf(s, "HDR1 %lld %d %lld %lld%n", &highest, &sigfigs, &min, &max, &consumed) != 4) return NULL;
+
+    histogram *h = histogram_new(highest, sigfigs);
+    if (h == NULL) return NULL;
+
+    char *p = s + consumed;
+    size_t index;
+    long long count;
+    while (sscanf(p, " %zu:%lld%n", &index, &count, &consumed) == 2) {
+        if (index >= h->counts_len || count < 0) {
+            histogram_free(h);
+            return NULL;
+        }
+        h->counts[index] += count;
+        h->total += count;
+        p += consumed;
+    }
+    if (h->total) {
+        h->min = min;
+        h->max = max;
+    }
+    return h;
+}
+
+#endif
@@ -35,6 +35,12 @@
  *     |2021-05-08 20:55:07| [FATAL] This is a naked logger, aks without name
  *     |2021-05-08 20:55:07| [INFO] (Full Logger) This is a full logger
  *
+ * For latency-sensitive threads, a @ref logger_async puts a bounded queue in front of a logger: the calling thread
+ * formats the line into a fixed-size slot of the queue without any heap allocation, and a worker thread writes the
+ * slots out in batches. When the queue is full, the caller chooses between failing (@ref logger_async_try_log),
+ * blocking (@ref logger_async_log) or being notified when space frees up (@ref logger_async_on_space), which is what
+ * the C++20 awaitable `clz::AsyncLogger` in @ref clz.hpp builds on. The asynchronous queue requires POSIX threads.
+ *
  *
  * @file logger.h
  * @author Lorenzo Calza
@@ -53,8 +59,15 @@
 #include <string.h>
 #include <time.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 #include "clz.h"
+#include "stats.h"
+#include "usdt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /**
  * @brief Definition of enum representing the severity level of the log entry
@@ -136,7 +149,7 @@ typedef struct logger {
  *
  * @see logger_new
  */
-logger *logger_default();
+CLZ_API CLZ_COLD logger *logger_default();
 
 /**
  * @brief Constructs a new logger on heap
@@ -160,7 +173,7 @@ logger *logger_default();
  *
  * @see logger.h, logger, logger_default
  */
-logger *logger_new(FILE *out, bool date, bool time, char *prefix);
+CLZ_API CLZ_COLD logger *logger_new(FILE *out, bool date, bool time, char *prefix);
 
 /**
  * @brief Frees the logger on heap
@@ -177,7 +190,7 @@ logger *logger_new(FILE *out, bool date, bool time, char *prefix);
  *
  * @see logger_new, logger_default
  */
-void logger_free(logger *log, bool close);
+CLZ_API CLZ_COLD void logger_free(logger *log, bool close);
 
 /**
  * @brief Logs message using the given logger configuration
@@ -194,7 +207,7 @@ void logger_free(logger *log, bool close);
  *
  * @see logger.h, severity, logger_logf
  */
-void logger_log(logger *log, enum logger_severity level, char *line);
+CLZ_API CLZ_HOT void logger_log(logger *log, enum logger_severity level, char *line);
 
 /**
  * @brief Logs message using the given logger configuration and format string with variable args
@@ -214,7 +227,7 @@ void logger_log(logger *log, enum logger_severity level, char *line);
  *
  * @see logger.h, severity, logger_log
  */
-void logger_logf(logger *log, enum logger_severity level, char *fmt, ...);
+CLZ_API CLZ_HOT void logger_logf(logger *log, enum logger_severity level, char *fmt, ...);
 
 /**
  * @brief Shortcut for @ref logger_log with the @ref logger_severity level `LOG_INFO`
@@ -247,34 +260,215 @@ void logger_logf(logger *log, enum logger_severity level, char *fmt, ...);
  */
 #define logger_fatal(log, line) logger_log(log, LOG_FATAL, line)
 
+/**
+ * Macro defining the size of a slot of a @ref logger_async, i.e. the maximum length of a line including its
+ * date, time, severity and prefix. Longer lines are truncated.
+ */
+#ifndef CLZ_LOGGER_ASYNC_LINE
+#define CLZ_LOGGER_ASYNC_LINE 512
 #endif
 
-#ifdef CLZ_LOGGER_IMPL
+/**
+ * @brief Definition of structure representing a logger with an asynchronous queue
+ *
+ * The queue is a ring of `capacity` slots of @ref CLZ_LOGGER_ASYNC_LINE bytes each, allocated once by
+ * @ref logger_async_start. Producers format into the slots under a mutex, the worker thread writes out all
+ * filled slots at once and then releases them.
+ *
+ * **Notes**
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ * Use the provided API instead!
+ *
+ * @see logger_async_start, logger_async_try_log, logger_async_stop
+ */
+typedef struct logger_async {
+    /**
+     * @brief The logger whose configuration and output are used
+     */
+    logger *log;
+    /**
+     * @brief The slots, `capacity * CLZ_LOGGER_ASYNC_LINE` bytes
+     */
+    char *slots;
+    /**
+     * @brief The length of the line held by every slot
+     */
+    size_t *lengths;
+    /**
+     * @brief The number of slots, a power of 2
+     */
+    size_t capacity;
+    /**
+     * @brief The number of slots released by the worker so far
+     */
+    size_t head;
+    /**
+     * @brief The number of slots filled by producers so far
+     */
+    size_t tail;
+    /**
+     * @brief Whether the worker keeps waiting for new lines
+     */
+    bool running;
+    /**
+     * @brief Callback invoked by the worker after releasing slots, see @ref logger_async_on_space
+     */
+    void (*on_space)(void *);
+    /**
+     * @brief Argument of @ref on_space
+     */
+    void *on_space_arg;
+    /**
+     * @brief Mutex protecting the fields above
+     */
+    pthread_mutex_t lock;
+    /**
+     * @brief Signalled when a slot is filled or the queue is stopped
+     */
+    pthread_cond_t filled;
+    /**
+     * @brief Signalled when slots are released
+     */
+    pthread_cond_t released;
+    /**
+     * @brief The worker thread
+     */
+    pthread_t worker;
+} logger_async;
+
+/**
+ * @brief Starts an asynchronous queue in front of a logger
+ *
+ * `capacity` is rounded up to a power of 2. All the memory of the queue is allocated by this function, so logging
+ * through the queue never allocates. The logger is not owned by the queue and has to outlive it.
+ *
+ * Since heap allocation and thread creation take place, failure is possible. In this case, `NULL` is returned.
+ *
+ * @param log The logger
+ * @param capacity The number of lines the queue can hold
+ * @return The queue if successful, `NULL` otherwise
+ *
+ * @see logger_async_stop
+ */
+CLZ_API CLZ_COLD logger_async *logger_async_start(logger *log, size_t capacity);
+/**
+ * @brief Writes out all queued lines, stops the worker thread and frees the queue
+ *
+ * No other function may be called on the queue concurrently or afterwards.
+ *
+ * @param q The queue
+ *
+ * @see logger_async_start
+ */
+CLZ_API CLZ_COLD void logger_async_stop(logger_async *q);
+/**
+ * @brief Queues a message without blocking
+ *
+ * The line is formatted as by @ref logger_log, with the date and time of this call. If the queue is full, nothing is
+ * queued, the USDT probe `logger_queue_full` fires and `false` is returned.
+ *
+ * @param q The queue
+ * @param level The severity level
+ * @param line The message
+ * @return `true` if the message was queued
+ *
+ * @see logger_async_try_logn, logger_async_log
+ */
+CLZ_API CLZ_HOT bool logger_async_try_log(logger_async *q, enum logger_severity level, char *line);
+/**
+ * @brief Queues the first `n` bytes of a message without blocking
+ *
+ * Same as @ref logger_async_try_log, except that `line` does not need to be null-terminated.
+ *
+ * @param q The queue
+ * @param level The severity level
+ * @param line The message
+ * @param n The length of the message
+ * @return `true` if the message was queued
+ *
+ * @see logger_async_try_log
+ */
+CLZ_API CLZ_HOT bool logger_async_try_logn(logger_async *q, enum logger_severity level, const char *line, size_t n);
+/**
+ * @brief Queues a formatted message without blocking
+ *
+ * Same as @ref logger_async_try_log, with the message formatted by `vsnprintf` into a buffer of
+ * @ref CLZ_LOGGER_ASYNC_LINE bytes on the stack, which is then copied into the slot like any other message. The
+ * formatting takes place before the queue is locked.
+ *
+ * @param q The queue
+ * @param level The severity level
+ * @param fmt The format string
+ * @param ... The format args
+ * @return `true` if the message was queued
+ *
+ * @see logger_async_try_log, logger_logf
+ */
+CLZ_API CLZ_HOT bool logger_async_try_logf(logger_async *q, enum logger_severity level, char *fmt, ...);
+/**
+ * @brief Queues a message, waiting for space if the queue is full
+ *
+ * @param q The queue
+ * @param level The severity level
+ * @param line The message
+ *
+ * @see logger_async_try_log
+ */
+CLZ_API void logger_async_log(logger_async *q, enum logger_severity level, char *line);
+/**
+ * @brief Sets the callback invoked whenever the worker has released slots
+ *
+ * The callback runs on the worker thread, after the lines have been written and without any lock held, so it may
+ * call @ref logger_async_try_log. It should return quickly, since the worker does not write out further lines
+ * while it runs. Pass `NULL` to remove the callback.
+ *
+ * @param q The queue
+ * @param cb The callback
+ * @param arg The argument passed to the callback
+ */
+CLZ_API void logger_async_on_space(logger_async *q, void (*cb)(void *), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#if (defined(CLZ_LOGGER_IMPL) || defined(CLZ_STATIC_INLINE)) && !defined(_CLZ_LOGGER_IMPL_DONE)
 #undef CLZ_LOGGER_IMPL
+#define _CLZ_LOGGER_IMPL_DONE
 
-logger *logger_default() {
+CLZ_API logger *logger_default() {
+    CLZ_STATS_CALL(logger_default);
     static logger *def = NULL;
     if (def == NULL) def = logger_new(stdout, true, true, "STDOUT");
     return def;
 }
 
-logger *logger_new(FILE *out, bool date, bool time, char *prefix) {
+CLZ_API logger *logger_new(FILE *out, bool date, bool time, char *prefix) {
+    CLZ_STATS_CALL(logger_new);
     logger *log = malloc(sizeof(logger));
     if (log == NULL) return NULL;
+    CLZ_STATS_ALLOC(logger_new, sizeof(logger));
     log->date = date;
     log->time = time;
     log->out = out;
-    if (prefix != NULL) log->prefix = strdup(prefix);
+    if (prefix != NULL) {
+        log->prefix = strdup(prefix);
+        CLZ_STATS_ALLOC(logger_new, strlen(prefix) + 1);
+    }
     return log;
 }
 
-void logger_free(logger *log, bool close) {
+CLZ_API void logger_free(logger *log, bool close) {
+    CLZ_STATS_CALL(logger_free);
     if (close) fclose(log->out);
     free(log->prefix);
     free(log);
 }
 
-char *_logger_sev_level(enum logger_severity level) {
+CLZ_API char *_logger_sev_level(enum logger_severity level) {
     fflush(stdout);
     switch (level) {
         case LOG_DEBUG: return "DEBUG";
@@ -286,15 +480,20 @@ char *_logger_sev_level(enum logger_severity level) {
     }
 }
 
-void logger_log(logger *log, enum logger_severity level, char *line) {
+CLZ_API void logger_log(logger *log, enum logger_severity level, char *line) {
+    CLZ_STATS_CALL(logger_log);
+    CLZ_USDT_TIMER(t0);
+    CLZ_PROBE3(logger_log_entry, log, level, line);
     // |2020-04-18 14:58:22| [DEBUG] (PREFIX) line-contents\n
     char *datetime = "";
     if (log-> date || log->time) {
         time_t t = time(NULL);
         struct tm tm = *localtime(&t);
         datetime = malloc(24);
+        CLZ_STATS_ALLOC(logger_log, 24);
 
         char *date = malloc(12);
+        CLZ_STATS_ALLOC(logger_log, 12);
         if (log->date) {
             sprintf(date, "%04d-%02d-%02d%s", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, log->time ? " " : "");
         }
@@ -303,6 +502,7 @@ void logger_log(logger *log, enum logger_severity level, char *line) {
         }
 
         char *time = malloc(9);
+        CLZ_STATS_ALLOC(logger_log, 9);
         if (log->time) {
             sprintf(time, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
         }
@@ -318,6 +518,7 @@ void logger_log(logger *log, enum logger_severity level, char *line) {
     char *prefix = "";
     if (log->prefix != NULL) {
         prefix = malloc(strlen(log->prefix) + 4);
+        CLZ_STATS_ALLOC(logger_log, strlen(log->prefix) + 4);
         sprintf(prefix, "(%s) ", log->prefix);
     }
 
@@ -325,9 +526,13 @@ void logger_log(logger *log, enum logger_severity level, char *line) {
             datetime, strlen(datetime) > 0 ? " " : "", _logger_sev_level(level), prefix, line);
     free(datetime);
     free(prefix);
+    CLZ_PROBE3(logger_log_return, log, level, CLZ_USDT_ELAPSED(t0));
 }
 
-void logger_logf(logger *log, enum logger_severity level, char *fmt, ...) {
+CLZ_API void logger_logf(logger *log, enum logger_severity level, char *fmt, ...) {
+    CLZ_STATS_CALL(logger_logf);
+    CLZ_USDT_TIMER(t0);
+    CLZ_PROBE3(logger_log_entry, log, level, fmt);
     va_list args;
     va_start(args, fmt);
 
@@ -337,8 +542,10 @@ void logger_logf(logger *log, enum logger_severity level, char *fmt, ...) {
         time_t t = time(NULL);
         struct tm tm = *localtime(&t);
         datetime = malloc(24);
+        CLZ_STATS_ALLOC(logger_logf, 24);
 
         char *date = malloc(12);
+        CLZ_STATS_ALLOC(logger_logf, 12);
         if (log->date) {
             sprintf(date, "%04d-%02d-%02d%s", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, log->time ? " " : "");
         }
@@ -347,6 +554,7 @@ void logger_logf(logger *log, enum logger_severity level, char *fmt, ...) {
         }
 
         char *time = malloc(9);
+        CLZ_STATS_ALLOC(logger_logf, 9);
         if (log->time) {
             sprintf(time, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
         }
@@ -362,16 +570,182 @@ void logger_logf(logger *log, enum logger_severity level, char *fmt, ...) {
     char *prefix = "";
     if (log->prefix != NULL) {
         prefix = malloc(strlen(log->prefix) + 4);
+        CLZ_STATS_ALLOC(logger_logf, strlen(log->prefix) + 4);
         sprintf(prefix, "(%s) ", log->prefix);
     }
 
     fprintf(log->out, "%s%s[%s] %s",
             datetime, strlen(datetime) > 0 ? " " : "", _logger_sev_level(level), prefix);
     char *line = malloc(strlen(fmt) + 2);
+    CLZ_STATS_ALLOC(logger_logf, strlen(fmt) + 2);
     sprintf(line, "%s\n", fmt);
     vfprintf(log->out, line, args);
     free(line);
     free(datetime);
+    CLZ_PROBE3(logger_log_return, log, level, CLZ_USDT_ELAPSED(t0));
+}
+
+// same names as _logger_sev_level, without its flush of stdout, which could block the producer
+static const char *const _logger_sev_names[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+static size_t _logger_format_head(logger *log, enum logger_severity level, char *dest, size_t sz) {
+    char datetime[24] = "";
+    if (log->date || log->time) {
+        time_t t = time(NULL);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        size_t n = 0;
+        datetime[n++] = '|';
+        if (log->date) n += strftime(datetime + n, sizeof(datetime) - n, log->time ? "%Y-%m-%d " : "%Y-%m-%d", &tm);
+        if (log->time) n += strftime(datetime + n, sizeof(datetime) - n, "%H:%M:%S", &tm);
+        datetime[n++] = '|';
+        datetime[n++] = ' ';
+        datetime[n] = '\0';
+    }
+
+    const char *sev = (unsigned) level <= LOG_FATAL ? _logger_sev_names[level] : "invalid";
+    int n = snprintf(dest, sz, "%s[%s] %s%s%s", datetime, sev,
+                     log->prefix ? "(" : "", log->prefix ? log->prefix : "", log->prefix ? ") " : "");
+    if (n < 0) return 0;
+    return (size_t) n < sz ? (size_t) n : sz - 1;
+}
+
+static void *_logger_async_worker(void *arg) {
+    logger_async *q = arg;
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        while (q->head == q->tail && q->running) pthread_cond_wait(&q->filled, &q->lock);
+        size_t head = q->head, tail = q->tail;
+        if (head == tail) break;
+        pthread_mutex_unlock(&q->lock);
+
+        // the slots between head and tail are not touched by producers until head moves
+        for (size_t i = head; i != tail; ++i) {
+            size_t slot = i & (q->capacity - 1);
+            fwrite(q->slots + slot * CLZ_LOGGER_ASYNC_LINE, 1, q->lengths[slot], q->log->out);
+        }
+        fflush(q->log->out);
+
+        pthread_mutex_lock(&q->lock);
+        q->head = tail;
+        void (*cb)(void *) = q->on_space;
+        void *cbarg = q->on_space_arg;
+        pthread_cond_broadcast(&q->released);
+        pthread_mutex_unlock(&q->lock);
+        if (cb != NULL) cb(cbarg);
+        pthread_mutex_lock(&q->lock);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+CLZ_API logger_async *logger_async_start(logger *log, size_t capacity) {
+    CLZ_STATS_CALL(logger_async_start);
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+
+    logger_async *q = calloc(1, sizeof(logger_async));
+    if (q == NULL) return NULL;
+    q->slots = malloc(cap * CLZ_LOGGER_ASYNC_LINE);
+    q->lengths = calloc(cap, sizeof(size_t));
+    if (q->slots == NULL || q->lengths == NULL) goto fail;
+    CLZ_STATS_ALLOC(logger_async_start, sizeof(logger_async) + cap * (CLZ_LOGGER_ASYNC_LINE + sizeof(size_t)));
+
+    q->log = log;
+    q->capacity = cap;
+    q->running = true;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->filled, NULL);
+    pthread_cond_init(&q->released, NULL);
+    if (pthread_create(&q->worker, NULL, _logger_async_worker, q) != 0) {
+        pthread_cond_destroy(&q->released);
+        pthread_cond_destroy(&q->filled);
+        pthread_mutex_destroy(&q->lock);
+        goto fail;
+    }
+    return q;
+
+fail:
+    free(q->lengths);
+    free(q->slots);
+    free(q);
+    return NULL;
+}
+
+CLZ_API void logger_async_stop(logger_async *q) {
+    CLZ_STATS_CALL(logger_async_stop);
+    pthread_mutex_lock(&q->lock);
+    q->running = false;
+    pthread_cond_signal(&q->filled);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->worker, NULL);
+
+    pthread_cond_destroy(&q->released);
+    pthread_cond_destroy(&q->filled);
+    pthread_mutex_destroy(&q->lock);
+    free(q->lengths);
+    free(q->slots);
+    free(q);
+}
+
+static bool _logger_async_push(logger_async *q, enum logger_severity level, const char *line, size_t len, bool wait) {
+    // the line is formatted on the stack first, so that the lock is held only for the copy
+    char buf[CLZ_LOGGER_ASYNC_LINE];
+    size_t head = _logger_format_head(q->log, level, buf, sizeof(buf));
+    if (len > sizeof(buf) - 1 - head) len = sizeof(buf) - 1 - head;
+    memcpy(buf + head, line, len);
+    len += head;
+    buf[len++] = '\n';
+
+    pthread_mutex_lock(&q->lock);
+    if (q->tail - q->head == q->capacity) {
+        CLZ_PROBE3(logger_queue_full, q, level, q->capacity);
+        if (!wait) {
+            pthread_mutex_unlock(&q->lock);
+            return false;
+        }
+        while (q->tail - q->head == q->capacity) pthread_cond_wait(&q->released, &q->lock);
+    }
+    size_t slot = q->tail & (q->capacity - 1);
+    memcpy(q->slots + slot * CLZ_LOGGER_ASYNC_LINE, buf, len);
+    q->lengths[slot] = len;
+    if (q->tail++ == q->head) pthread_cond_signal(&q->filled);
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+CLZ_API bool logger_async_try_log(logger_async *q, enum logger_severity level, char *line) {
+    CLZ_STATS_CALL(logger_async_try_log);
+    return _logger_async_push(q, level, line, strlen(line), false);
+}
+
+CLZ_API bool logger_async_try_logn(logger_async *q, enum logger_severity level, const char *line, size_t n) {
+    CLZ_STATS_CALL(logger_async_try_logn);
+    return _logger_async_push(q, level, line, n, false);
+}
+
+CLZ_API bool logger_async_try_logf(logger_async *q, enum logger_severity level, char *fmt, ...) {
+    CLZ_STATS_CALL(logger_async_try_logf);
+    char line[CLZ_LOGGER_ASYNC_LINE];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n < 0) return false;
+    return _logger_async_push(q, level, line, (size_t) n < sizeof(line) ? (size_t) n : sizeof(line) - 1, false);
+}
+
+CLZ_API void logger_async_log(logger_async *q, enum logger_severity level, char *line) {
+    CLZ_STATS_CALL(logger_async_log);
+    _logger_async_push(q, level, line, strlen(line), true);
+}
+
+CLZ_API void logger_async_on_space(logger_async *q, void (*cb)(void *), void *arg) {
+    CLZ_STATS_CALL(logger_async_on_space);
+    pthread_mutex_lock(&q->lock);
+    q->on_space = cb;
+    q->on_space_arg = arg;
+    pthread_mutex_unlock(&q->lock);
 }
 
 #endif
@@ -0,0 +1,1142 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a fast lossless compressor without dependencies, meant for keeping large strbufs
+ * compressed in memory. Compression runs at a few hundred MB/s per core, and decompression, which only copies
+ * literal runs and earlier output, in the GB/s range.
+ *
+ * The data is written in the LZ4 formats, so that it can also be read and written by the `lz4` tool:
+ *
+ * - a block is a sequence of literal runs and matches of at least 4 bytes at most 65535 bytes back, found with
+ *   a hash table of the positions of the last 4-byte sequences seen. @ref lz_compress_block and
+ *   @ref lz_decompress_block work on single blocks, whose size the caller has to store.
+ * - a frame holds a header, blocks of up to @ref CLZ_LZ_BLOCK bytes of input each, and an end mark. @ref lz_compress
+ *   and @ref lz_decompress work on whole frames, the streaming @ref lz_encoder and @ref lz_decoder on frames
+ *   given or received in pieces.
+ *
+ * The frames written here have independent blocks, so large inputs are compressed and decompressed with one
+ * thread per block range. Each thread writes directly into the destination strbuf, which is grown only once.
+ * Decompression checks every length and offset against the bounds of its input and output, so corrupted or
+ * malicious data is rejected instead of causing out of bounds accesses.
+ *
+ * Example:
+ *
+ * @code
+ *     char *packed = strbuf_new();
+ *     if (!lz_compress(&packed, doc, strbuf_length(doc), 0)) return false;
+ *     strbuf_free(doc);
+ *     ...
+ *     char *doc = strbuf_new();
+ *     if (!lz_decompress(&doc, packed, strbuf_length(packed), 0)) return false;
+ * @endcode
+ *
+ * **Notes**
+ *
+ * All frames are decoded, including frames with linked blocks (the default of the `lz4` tool), checksums and
+ * several frames one after another. Frames with linked blocks are decoded by a single thread. Dictionaries and
+ * the legacy format are not supported.
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_LZ_IMPL` is defined beforehand. It requires POSIX threads
+ * and the implementation of @ref strbuf.h.
+ *
+ * @file lz.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a fast compressor in the LZ4 format
+ *
+ */
+
+#ifndef _CLZ_LZ_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "strbuf.h"
+
+/**
+ * Macro defining the size of the blocks of the frames written, which has to be 64 KiB, 256 KiB, 1 MiB or 4 MiB.
+ * The streaming @ref lz_encoder and @ref lz_decoder hold a block in memory.
+ */
+#ifndef CLZ_LZ_BLOCK
+#define CLZ_LZ_BLOCK (1 << 18)
+#endif
+
+/**
+ * Macro defining the base-2 logarithm of the number of entries of the hash table used to find matches.
+ * Larger tables find more matches but fit worse in the cache. The table is on the stack of the compressing thread.
+ */
+#ifndef CLZ_LZ_HASH_LOG
+#define CLZ_LZ_HASH_LOG 14
+#endif
+
+/**
+ * Macro defining the minimum number of bytes of input per thread.
+ */
+#ifndef CLZ_LZ_PARALLEL_MIN
+#define CLZ_LZ_PARALLEL_MIN (1 << 20)
+#endif
+
+/**
+ * @brief Returns the maximum size of a compressed block for `n` bytes of input.
+ */
+#define lz_bound(n) ((n) + (n) / 255 + 16)
+
+/**
+ * @brief Definition of a streaming compressor
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct lz_encoder {
+    /**
+     * @brief The input of the current block
+     */
+    char *block;
+    /**
+     * @brief The number of bytes of the current block
+     */
+    size_t len;
+    /**
+     * @brief Whether the header of the frame has been written
+     */
+    bool started;
+} lz_encoder;
+
+/**
+ * @brief Definition of a streaming decompressor
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct lz_decoder {
+    /**
+     * @brief The item being read: magic number, descriptor, block size, block, checksum...
+     */
+    int state;
+    /**
+     * @brief The number of bytes of the current item
+     */
+    size_t need;
+    /**
+     * @brief The number of bytes of the current item received so far
+     */
+    size_t have;
+    /**
+     * @brief The current item, unless it is a block
+     */
+    unsigned char head[16];
+    /**
+     * @brief The current block, if it was not received at once
+     */
+    char *block;
+    /**
+     * @brief The flags of the current frame
+     */
+    unsigned flags;
+    /**
+     * @brief The maximum size of a block of the current frame
+     */
+    size_t bmax;
+    /**
+     * @brief Whether the current block is stored uncompressed
+     */
+    bool raw;
+    /**
+     * @brief The number of bytes left in a skippable frame
+     */
+    size_t skip;
+    /**
+     * @brief The number of bytes decoded from the current frame
+     */
+    size_t produced;
+    /**
+     * @brief The state of the checksum of the current frame
+     */
+    struct _lz_xxh {
+        uint32_t v[4];
+        uint64_t total;
+        unsigned char buf[16];
+        size_t nbuf;
+    } xxh;
+} lz_decoder;
+
+/**
+ * @brief Compresses bytes into a single block.
+ *
+ * Up to @ref lz_bound of `n` bytes are written. The block does not record its size nor the size of the input.
+ *
+ * @param src The input
+ * @param n The number of bytes of input
+ * @param dst The output
+ * @param cap The number of bytes available at `dst`
+ * @return The size of the block, or `0` if it does not fit into `cap` bytes
+ *
+ * @see lz_decompress_block, lz_compress
+ */
+size_t lz_compress_block(const char *src, size_t n, char *dst, size_t cap);
+/**
+ * @brief Decompresses a single block.
+ *
+ * If the block is malformed or decompresses to more than `cap` bytes, `false` is returned and `errno` is set to
+ * `EINVAL`. The bytes at `dst` may have been overwritten anyway.
+ *
+ * @param src The block
+ * @param n The size of the block
+ * @param dst The output
+ * @param cap The number of bytes available at `dst`
+ * @param outlen The destination of the number of bytes decompressed
+ * @return `true` if successful
+ *
+ * @see lz_compress_block, lz_decompress
+ */
+bool lz_decompress_block(const char *src, size_t n, char *dst, size_t cap, size_t *outlen);
+/**
+ * @brief Compresses bytes into a frame appended to a strbuf.
+ *
+ * The buffer is switched to binary mode (see @ref strbuf_make_binary). Inputs of at least twice
+ * @ref CLZ_LZ_PARALLEL_MIN bytes are compressed by several threads, with identical output.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned, `errno` is set to `ENOMEM`
+ * and the length of the buffer is left unchanged.
+ *
+ * @param destbuf The destination buffer
+ * @param src The input
+ * @param n The number of bytes of input
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return `true` if successful
+ *
+ * @see lz_decompress, lz_encoder
+ */
+bool lz_compress(char **destbuf, const char *src, size_t n, size_t threads);
+/**
+ * @brief Decompresses one or more frames, appending their contents to a strbuf.
+ *
+ * The buffer is switched to binary mode (see @ref strbuf_make_binary). Frames with independent blocks are
+ * decompressed by several threads if they are large enough.
+ *
+ * The buffer is grown with the output, and no more than the content size of a frame is reserved up front when
+ * its header gives one. As a block cannot decompress to more than 255 times its size, the memory used stays
+ * proportional to the output, or at most to 255 times the input.
+ *
+ * If the input is malformed, truncated, or its checksums do not match, `false` is returned and `errno` is set to
+ * `EINVAL`. Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set
+ * to `ENOMEM`. In both cases, the length of the buffer is left unchanged.
+ *
+ * @param destbuf The destination buffer
+ * @param src The frames
+ * @param n The number of bytes of the frames
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return `true` if successful
+ *
+ * @see lz_compress, lz_decoder
+ */
+bool lz_decompress(char **destbuf, const char *src, size_t n, size_t threads);
+
+/**
+ * @brief Initializes a streaming compressor.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param e The compressor
+ * @return `true` if successful
+ *
+ * @see lz_encoder_write, lz_encoder_finish, lz_encoder_free
+ */
+bool lz_encoder_init(lz_encoder *e);
+/**
+ * @brief Compresses the next bytes of a frame.
+ *
+ * The input is collected into blocks of @ref CLZ_LZ_BLOCK bytes, each of which is compressed and appended to the
+ * buffer as soon as it is full, after the header of the frame for the first one. The buffer is switched to binary
+ * mode and may be a different one at every call, for example after its contents have been written to a file.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param e The compressor
+ * @param destbuf The destination buffer
+ * @param src The input
+ * @param n The number of bytes of input
+ * @return `true` if successful
+ */
+bool lz_encoder_write(lz_encoder *e, char **destbuf, const char *src, size_t n);
+/**
+ * @brief Ends a frame.
+ *
+ * The last block and the end mark are appended to the buffer. The compressor can then start a new frame.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param e The compressor
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ */
+bool lz_encoder_finish(lz_encoder *e, char **destbuf);
+/**
+ * @brief Frees the memory held by a streaming compressor.
+ *
+ * @param e The compressor
+ */
+void lz_encoder_free(lz_encoder *e);
+
+/**
+ * @brief Initializes a streaming decompressor.
+ *
+ * @param d The decompressor
+ *
+ * @see lz_decoder_write, lz_decoder_done, lz_decoder_free
+ */
+void lz_decoder_init(lz_decoder *d);
+/**
+ * @brief Decompresses the next bytes of one or more frames.
+ *
+ * The input may be cut anywhere. The contents of every block are appended to the buffer once the block has been
+ * received entirely, so at most a block is held back. The buffer is switched to binary mode. It may be a different
+ * one at every call, except for frames with linked blocks, whose blocks refer to the contents of the previous ones:
+ * these have to be kept in the buffer until the end of the frame.
+ *
+ * If the input is malformed or its checksums do not match, `false` is returned and `errno` is set to `EINVAL`, after
+ * which the decompressor cannot be used anymore. Since heap allocation is used, failure is possible. In this case,
+ * `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param d The decompressor
+ * @param destbuf The destination buffer
+ * @param src The input
+ * @param n The number of bytes of input
+ * @return `true` if successful
+ */
+bool lz_decoder_write(lz_decoder *d, char **destbuf, const char *src, size_t n);
+/**
+ * @brief Tells whether a decompressor has received whole frames only.
+ *
+ * This is the case before any input, and after the end of every frame. When the input is over, a decompressor that
+ * is not done has received a truncated frame.
+ *
+ * @param d The decompressor
+ * @return `true` if no frame is partially received
+ */
+bool lz_decoder_done(lz_decoder *d);
+/**
+ * @brief Frees the memory held by a streaming decompressor.
+ *
+ * @param d The decompressor
+ */
+void lz_decoder_free(lz_decoder *d);
+
+#endif
+
+#ifdef CLZ_LZ_IMPL
+#undef CLZ_LZ_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "parallel.h"
+
+#define _LZ_MAGIC 0x184D2204U
+#define _LZ_MINMATCH 4
+// the last match starts at least 12 bytes before the end, and the last 5 bytes are literals
+#define _LZ_MFLIMIT 12
+#define _LZ_LASTLITERALS 5
+#define _LZ_MAX_OFFSET 65535
+
+// frame descriptor flags
+#define _LZ_FLG_INDEPENDENT 0x20
+#define _LZ_FLG_BLOCK_CHECKSUM 0x10
+#define _LZ_FLG_CONTENT_SIZE 0x08
+#define _LZ_FLG_CONTENT_CHECKSUM 0x04
+#define _LZ_FLG_DICT_ID 0x01
+
+// the block size identifier of CLZ_LZ_BLOCK: 4 for 64 KiB up to 7 for 4 MiB
+#define _LZ_BLOCK_ID (CLZ_LZ_BLOCK == (1 << 16) ? 4 : CLZ_LZ_BLOCK == (1 << 18) ? 5 : CLZ_LZ_BLOCK == (1 << 20) ? 6 : 7)
+
+enum {
+    _LZ_D_MAGIC, _LZ_D_SKIP_SIZE, _LZ_D_SKIP, _LZ_D_FLAGS, _LZ_D_DESCRIPTOR, _LZ_D_BLOCK_SIZE, _LZ_D_BLOCK,
+    _LZ_D_CHECKSUM, _LZ_D_FAILED
+};
+
+static inline uint32_t _lz_load32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _lz_load64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t _lz_read32(const unsigned char *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static inline void _lz_write32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char) (v >> 8);
+    p[2] = (unsigned char) (v >> 16);
+    p[3] = (unsigned char) (v >> 24);
+}
+
+/*
+ * xxHash32, the checksum of the frames
+ */
+
+#define _LZ_P1 2654435761U
+#define _LZ_P2 2246822519U
+#define _LZ_P3 3266489917U
+#define _LZ_P4 668265263U
+#define _LZ_P5 374761393U
+
+static inline uint32_t _lz_rotl(uint32_t x, int r) {
+    return x << r | x >> (32 - r);
+}
+
+static inline uint32_t _lz_xxh_round(uint32_t acc, uint32_t input) {
+    return _lz_rotl(acc + input * _LZ_P2, 13) * _LZ_P1;
+}
+
+static void _lz_xxh_init(struct _lz_xxh *x) {
+    x->v[0] = _LZ_P1 + _LZ_P2;
+    x->v[1] = _LZ_P2;
+    x->v[2] = 0;
+    x->v[3] = 0 - _LZ_P1;
+    x->total = 0;
+    x->nbuf = 0;
+}
+
+static void _lz_xxh_stripe(struct _lz_xxh *x, const unsigned char *p) {
+    for (int i = 0; i < 4; ++i) x->v[i] = _lz_xxh_round(x->v[i], _lz_read32(p + 4 * i));
+}
+
+static void _lz_xxh_update(struct _lz_xxh *x, const unsigned char *p, size_t n) {
+    x->total += n;
+    if (x->nbuf) {
+        size_t take = 16 - x->nbuf < n ? 16 - x->nbuf : n;
+        memcpy(x->buf + x->nbuf, p, take);
+        x->nbuf += take;
+        p += take;
+        n -= take;
+        if (x->nbuf < 16) return;
+        _lz_xxh_stripe(x, x->buf);
+        x->nbuf = 0;
+    }
+    for (; n >= 16; p += 16, n -= 16) _lz_xxh_stripe(x, p);
+    memcpy(x->buf, p, n);
+    x->nbuf = n;
+}
+
+static uint32_t _lz_xxh_digest(struct _lz_xxh *x) {
+    uint32_t h = x->total >= 16
+            ? _lz_rotl(x->v[0], 1) + _lz_rotl(x->v[1], 7) + _lz_rotl(x->v[2], 12) + _lz_rotl(x->v[3], 18)
+            : x->v[2] + _LZ_P5;
+    h += (uint32_t) x->total;
+    const unsigned char *p = x->buf, *end = x->buf + x->nbuf;
+    for (; p + 4 <= end; p += 4) h = _lz_rotl(h + _lz_read32(p) * _LZ_P3, 17) * _LZ_P4;
+    for (; p < end; ++p) h = _lz_rotl(h + *p * _LZ_P5, 11) * _LZ_P1;
+    h ^= h >> 15;
+    h *= _LZ_P2;
+    h ^= h >> 13;
+    h *= _LZ_P3;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t _lz_xxh(const unsigned char *p, size_t n) {
+    struct _lz_xxh x;
+    _lz_xxh_init(&x);
+    _lz_xxh_update(&x, p, n);
+    return _lz_xxh_digest(&x);
+}
+
+/*
+ * Blocks
+ */
+
+static inline uint32_t _lz_hash(const unsigned char *p) {
+    return (_lz_load32(p) * _LZ_P1) >> (32 - CLZ_LZ_HASH_LOG);
+}
+
+// the number of equal bytes at p and m, not going past limit
+static inline size_t _lz_count(const unsigned char *p, const unsigned char *m, const unsigned char *limit) {
+    const unsigned char *start = p;
+    while (p + 8 <= limit) {
+        uint64_t diff = _lz_load64(p) ^ _lz_load64(m);
+        if (diff) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return p - start + (__builtin_ctzll(diff) >> 3);
+#else
+            break;
+#endif
+        }
+        p += 8;
+        m += 8;
+    }
+    while (p < limit && *p == *m) {
+        ++p;
+        ++m;
+    }
+    return p - start;
+}
+
+static inline unsigned char *_lz_put_length(unsigned char *op, size_t len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (unsigned char) len;
+    return op;
+}
+
+size_t lz_compress_block(const char *src, size_t n, char *dst, size_t cap) {
+    uint32_t table[1 << CLZ_LZ_HASH_LOG];
+    const unsigned char *base = (const unsigned char *) src, *ip = base, *anchor = base, *iend = base + n;
+    const unsigned char *mflimit = iend - _LZ_MFLIMIT, *matchlimit = iend - _LZ_LASTLITERALS;
+    unsigned char *op = (unsigned char *) dst, *oend = op + cap;
+
+    // shorter inputs are literals only
+    if (n > _LZ_MFLIMIT) {
+        memset(table, 0, sizeof(table));
+        ++ip;
+        for (;;) {
+            // the step grows while nothing is found, so that incompressible data is skipped quickly
+            const unsigned char *match;
+            size_t attempts = 1 << 6, step = 1;
+            for (;;) {
+                uint32_t h = _lz_hash(ip);
+                match = base + table[h];
+                table[h] = (uint32_t) (ip - base);
+                if (ip - match <= _LZ_MAX_OFFSET && _lz_load32(match) == _lz_load32(ip)) break;
+                ip += step;
+                step = attempts++ >> 6;
+                if (ip > mflimit) goto last;
+            }
+            while (ip > anchor && match > base && ip[-1] == match[-1]) {
+                --ip;
+                --match;
+            }
+
+            size_t lit = ip - anchor;
+            size_t mlen = _LZ_MINMATCH + _lz_count(ip + _LZ_MINMATCH, match + _LZ_MINMATCH, matchlimit);
+            if ((size_t) (oend - op) < lit + lit / 255 + mlen / 255 + 6) return 0;
+            unsigned char *token = op++;
+            *token = (unsigned char) ((lit >= 15 ? 15 : lit) << 4);
+            if (lit >= 15) op = _lz_put_length(op, lit - 15);
+            memcpy(op, anchor, lit);
+            op += lit;
+            size_t off = ip - match;
+            *op++ = (unsigned char) off;
+            *op++ = (unsigned char) (off >> 8);
+            *token |= (unsigned char) (mlen - _LZ_MINMATCH >= 15 ? 15 : mlen - _LZ_MINMATCH);
+            if (mlen - _LZ_MINMATCH >= 15) op = _lz_put_length(op, mlen - _LZ_MINMATCH - 15);
+
+            ip += mlen;
+            anchor = ip;
+            if (ip > mflimit) break;
+            table[_lz_hash(ip - 2)] = (uint32_t) (ip - 2 - base);
+        }
+    }
+
+last:;
+    size_t lit = iend - anchor;
+    if ((size_t) (oend - op) < lit + lit / 255 + 2) return 0;
+    *op++ = (unsigned char) ((lit >= 15 ? 15 : lit) << 4);
+    if (lit >= 15) op = _lz_put_length(op, lit - 15);
+    memcpy(op, anchor, lit);
+    op += lit;
+    return op - (unsigned char *) dst;
+}
+
+// reads the extension of a length, returning false if the block ends first
+static inline bool _lz_get_length(const unsigned char **ip, const unsigned char *iend, size_t *len) {
+    unsigned char b;
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+// decompresses a block, with matches reaching back to low at most
+static bool _lz_decompress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap,
+                           const unsigned char *low, size_t *outlen) {
+    const unsigned char *ip = src, *iend = src + n;
+    unsigned char *op = dst, *oend = dst + cap;
+    for (;;) {
+        if (ip >= iend) return false;
+        unsigned token = *ip++;
+
+        size_t lit = token >> 4;
+        if (lit == 15 && !_lz_get_length(&ip, iend, &lit)) return false;
+        if (lit > (size_t) (iend - ip) || lit > (size_t) (oend - op)) return false;
+        // short runs are copied 16 bytes at once when there is room
+        if (lit <= 16 && iend - ip >= 16 && oend - op >= 16) memcpy(op, ip, 16);
+        else memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        // the last sequence has no match
+        if (ip == iend) break;
+
+        if (iend - ip < 2) return false;
+        size_t off = ip[0] | (size_t) ip[1] << 8;
+        ip += 2;
+        if (!off || off > (size_t) (op - low)) return false;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !_lz_get_length(&ip, iend, &mlen)) return false;
+        mlen += _LZ_MINMATCH;
+        if (mlen > (size_t) (oend - op)) return false;
+
+        const unsigned char *match = op - off;
+        if (off >= 16 && (size_t) (oend - op) >= mlen + 16) {
+            for (size_t i = 0; i < mlen; i += 16) memcpy(op + i, match + i, 16);
+        } else if (off >= 8 && (size_t) (oend - op) >= mlen + 8) {
+            for (size_t i = 0; i < mlen; i += 8) memcpy(op + i, match + i, 8);
+        } else if ((size_t) (oend - op) >= mlen + 8) {
+            // the first 8 bytes repeat the pattern, then a multiple of its period at least 8 long is copied
+            for (int i = 0; i < 8; ++i) op[i] = match[i];
+            size_t period = off * ((8 + off - 1) / off);
+            for (size_t i = 8; i < mlen; i += 8) memcpy(op + i, op + i - period, 8);
+        } else {
+            for (size_t i = 0; i < mlen; ++i) op[i] = match[i];
+        }
+        op += mlen;
+    }
+    *outlen = op - dst;
+    return true;
+}
+
+bool lz_decompress_block(const char *src, size_t n, char *dst, size_t cap, size_t *outlen) {
+    if (!_lz_decompress((const unsigned char *) src, n, (unsigned char *) dst, cap, (unsigned char *) dst, outlen)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Frames
+ */
+
+static bool _lz_reserve(char **destbuf, size_t n) {
+    size_t len = strbuf_length(*destbuf);
+    if (strbuf_alloc_size(*destbuf) < len + n + 1 && !strbuf_resize(destbuf, len + n + 1)) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+// writes the header of a frame with independent blocks, returning its size
+static size_t _lz_header(unsigned char *p, bool sized, uint64_t content_size) {
+    _lz_write32(p, _LZ_MAGIC);
+    p[4] = 0x40 | _LZ_FLG_INDEPENDENT | (sized ? _LZ_FLG_CONTENT_SIZE : 0);
+    p[5] = _LZ_BLOCK_ID << 4;
+    size_t n = 6;
+    if (sized) {
+        for (int i = 0; i < 8; ++i) p[n++] = (unsigned char) (content_size >> 8 * i);
+    }
+    p[n] = (unsigned char) (_lz_xxh(p + 4, n - 4) >> 8);
+    return n + 1;
+}
+
+// writes a block with its size, uncompressed if compression does not make it smaller, returning its size
+static size_t _lz_frame_block(const char *src, size_t n, unsigned char *dst) {
+    size_t size = lz_compress_block(src, n, (char *) dst + 4, n - 1);
+    if (size) {
+        _lz_write32(dst, (uint32_t) size);
+        return 4 + size;
+    }
+    _lz_write32(dst, (uint32_t) n | 0x80000000U);
+    memcpy(dst + 4, src, n);
+    return 4 + n;
+}
+
+typedef struct _lz_chunk {
+    const unsigned char *src;
+    unsigned char *dst;
+    // blocks begin to end of the input, or of the frame when decompressing
+    size_t begin;
+    size_t end;
+    size_t n;
+    // bytes written
+    size_t out;
+    struct _lz_span *spans;
+    bool failed;
+} _lz_chunk;
+
+struct _lz_span {
+    size_t off;
+    size_t size;
+    bool raw;
+};
+
+static void *_lz_compress_chunk(void *arg) {
+    _lz_chunk *c = arg;
+    unsigned char *op = c->dst;
+    for (size_t b = c->begin; b < c->end; ++b) {
+        size_t from = b * CLZ_LZ_BLOCK, size = c->n - from < CLZ_LZ_BLOCK ? c->n - from : CLZ_LZ_BLOCK;
+        op += _lz_frame_block((const char *) c->src + from, size, op);
+    }
+    c->out = op - c->dst;
+    return NULL;
+}
+
+bool lz_compress(char **destbuf, const char *src, size_t n, size_t threads) {
+    strbuf_make_binary(destbuf);
+    size_t nblocks = (n + CLZ_LZ_BLOCK - 1) / CLZ_LZ_BLOCK;
+    // blocks are never larger than their input and their size
+    if (!_lz_reserve(destbuf, 15 + n + 4 * nblocks + 4)) return false;
+
+    size_t dlen = strbuf_length(*destbuf);
+    unsigned char *out = (unsigned char *) *destbuf + dlen, *op = out;
+    op += _lz_header(op, true, n);
+
+    // every chunk writes its blocks where they would be if all blocks before were uncompressed
+    size_t count = _clz_threads(threads, n, CLZ_LZ_PARALLEL_MIN);
+    if (count > nblocks) count = nblocks;
+    _lz_chunk stack[1], *chunks = count > 1 ? calloc(count, sizeof(_lz_chunk)) : NULL;
+    if (!chunks) {
+        count = nblocks ? 1 : 0;
+        chunks = stack;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].src = (const unsigned char *) src;
+        chunks[i].n = n;
+        chunks[i].begin = nblocks * i / count;
+        chunks[i].end = nblocks * (i + 1) / count;
+        chunks[i].dst = op + chunks[i].begin * (CLZ_LZ_BLOCK + 4);
+    }
+    if (count) _clz_run(_lz_compress_chunk, chunks, sizeof(_lz_chunk), count);
+    for (size_t i = 0; i < count; ++i) {
+        memmove(op, chunks[i].dst, chunks[i].out);
+        op += chunks[i].out;
+    }
+    if (chunks != stack) free(chunks);
+
+    _lz_write32(op, 0);
+    op += 4;
+    strbuf_set_length(destbuf, dlen + (op - out));
+    return true;
+}
+
+// checks the descriptor of a frame after the magic number, returning its size or 0 if it is invalid or incomplete
+static size_t _lz_descriptor(const unsigned char *p, size_t n, unsigned *flags, size_t *bmax, uint64_t *content_size) {
+    if (n < 3) return 0;
+    unsigned flg = p[0], bd = p[1];
+    if ((flg >> 6) != 1 || (flg & 0x02) || (bd & 0x8F) || (bd >> 4) < 4) return 0;
+    size_t size = 3 + (flg & _LZ_FLG_CONTENT_SIZE ? 8 : 0) + (flg & _LZ_FLG_DICT_ID ? 4 : 0);
+    if (n < size || p[size - 1] != (unsigned char) (_lz_xxh(p, size - 1) >> 8)) return 0;
+    // dictionaries are not supported
+    if (flg & _LZ_FLG_DICT_ID) return 0;
+    *flags = flg;
+    *bmax = (size_t) 1 << (2 * (bd >> 4) + 8);
+    *content_size = 0;
+    if (flg & _LZ_FLG_CONTENT_SIZE) {
+        for (int i = 7; i >= 0; --i) *content_size = *content_size << 8 | p[2 + i];
+    }
+    return size;
+}
+
+static void *_lz_decompress_chunk(void *arg) {
+    _lz_chunk *c = arg;
+    for (size_t b = c->begin; b < c->end; ++b) {
+        struct _lz_span *s = c->spans + b;
+        unsigned char *op = c->dst + (b - c->begin) * c->n;
+        size_t cap = b + 1 == c->end ? c->out : c->n, out = s->size;
+        if (s->raw) {
+            if (s->size > cap) c->failed = true;
+            else memcpy(op, c->src + s->off, s->size);
+        } else if (!_lz_decompress(c->src + s->off, s->size, op, cap, op, &out)) {
+            c->failed = true;
+        }
+        // blocks are assumed full but the last one
+        if (c->failed || (b + 1 < c->end && out != c->n)) {
+            c->failed = true;
+            return NULL;
+        }
+        if (b + 1 == c->end) c->out = out;
+    }
+    return NULL;
+}
+
+// the most bytes a block can decompress to, as no input byte yields more than 255 output bytes
+static inline size_t _lz_span_bound(const struct _lz_span *s, size_t bmax) {
+    return s->raw ? s->size : s->size < bmax / 255 ? 255 * s->size : bmax;
+}
+
+// decompresses the blocks of a frame one after another after dlen, growing the buffer as they are written,
+// returning the number of bytes written or SIZE_MAX with err set
+static size_t _lz_decompress_blocks(char **destbuf, size_t dlen, const unsigned char *src, struct _lz_span *spans,
+                                    size_t nspans, size_t bmax, bool linked, int *err) {
+    size_t out = 0;
+    for (size_t i = 0; i < nspans; ++i) {
+        // the length covers the output so far, which the resize has to keep
+        strbuf_set_length(destbuf, dlen + out);
+        if (!_lz_reserve(destbuf, _lz_span_bound(spans + i, bmax))) {
+            *err = ENOMEM;
+            return SIZE_MAX;
+        }
+        unsigned char *dst = (unsigned char *) *destbuf + dlen, *op = dst + out;
+        size_t size = spans[i].size, room = strbuf_alloc_size(*destbuf) - 1 - dlen - out;
+        if (spans[i].raw) {
+            if (size > room) {
+                *err = EINVAL;
+                return SIZE_MAX;
+            }
+            memcpy(op, src + spans[i].off, size);
+        } else if (!_lz_decompress(src + spans[i].off, size, op, room, linked ? dst : op, &size)) {
+            *err = EINVAL;
+            return SIZE_MAX;
+        }
+        out += size;
+    }
+    return out;
+}
+
+// decompresses the frame at the start of src, returning its size or 0
+static size_t _lz_frame(char **destbuf, const unsigned char *src, size_t n, size_t threads) {
+    if (n >= 8 && (_lz_read32(src) & 0xFFFFFFF0U) == 0x184D2A50U) {
+        size_t size = _lz_read32(src + 4);
+        if (size <= n - 8) return 8 + size;
+        errno = EINVAL;
+        return 0;
+    }
+    unsigned flags;
+    size_t bmax;
+    uint64_t content_size;
+    size_t pos = n >= 4 && _lz_read32(src) == _LZ_MAGIC ? _lz_descriptor(src + 4, n - 4, &flags, &bmax, &content_size) : 0;
+    if (!pos) {
+        errno = EINVAL;
+        return 0;
+    }
+    pos += 4;
+
+    // the blocks are located first, to bound the size of the output
+    size_t nspans = 0, cap = 0, total = 0;
+    struct _lz_span *spans = NULL;
+    int err = EINVAL;
+    for (;;) {
+        if (n - pos < 4) goto fail;
+        uint32_t v = _lz_read32(src + pos);
+        pos += 4;
+        if (!v) break;
+        size_t size = v & 0x7FFFFFFFU;
+        if (size > bmax || size > n - pos) goto fail;
+        if (nspans == cap) {
+            cap = cap ? 2 * cap : 16;
+            struct _lz_span *s = realloc(spans, cap * sizeof(struct _lz_span));
+            if (!s) {
+                err = ENOMEM;
+                goto fail;
+            }
+            spans = s;
+        }
+        spans[nspans] = (struct _lz_span) {pos, size, v >> 31};
+        total += _lz_span_bound(spans + nspans++, bmax);
+        pos += size;
+        if (flags & _LZ_FLG_BLOCK_CHECKSUM) {
+            if (n - pos < 4 || _lz_read32(src + pos) != _lz_xxh(src + pos - size, size)) goto fail;
+            pos += 4;
+        }
+    }
+    // the output is reserved up front only when its size is known, or for blocks decompressed in parallel
+    if (flags & _LZ_FLG_CONTENT_SIZE) {
+        if (content_size > total) goto fail;
+        total = (size_t) content_size;
+    }
+
+    size_t dlen = strbuf_length(*destbuf), out = SIZE_MAX;
+    size_t count = flags & _LZ_FLG_INDEPENDENT ? _clz_threads(threads, total, CLZ_LZ_PARALLEL_MIN) : 1;
+    if (count > nspans) count = nspans;
+    // the blocks but the last are assumed full, which the sizes have to allow
+    if (nspans && total <= (nspans - 1) * bmax) count = 1;
+    if ((count > 1 || flags & _LZ_FLG_CONTENT_SIZE) && !_lz_reserve(destbuf, total)) {
+        err = ENOMEM;
+        goto fail;
+    }
+    _lz_chunk *chunks = count > 1 ? calloc(count, sizeof(_lz_chunk)) : NULL;
+    if (chunks) {
+        unsigned char *dst = (unsigned char *) *destbuf + dlen;
+        for (size_t i = 0; i < count; ++i) {
+            chunks[i].src = src;
+            chunks[i].spans = spans;
+            chunks[i].n = bmax;
+            chunks[i].begin = nspans * i / count;
+            chunks[i].end = nspans * (i + 1) / count;
+            chunks[i].dst = dst + chunks[i].begin * bmax;
+            chunks[i].out = i + 1 == count ? total - (nspans - 1) * bmax : bmax;
+        }
+        _clz_run(_lz_decompress_chunk, chunks, sizeof(_lz_chunk), count);
+        bool failed = false;
+        for (size_t i = 0; i < count; ++i) failed |= chunks[i].failed;
+        if (!failed) out = (nspans - 1) * bmax + chunks[count - 1].out;
+        free(chunks);
+    }
+    // blocks that are not full, or a failure, are handled by a single thread
+    if (out == SIZE_MAX) {
+        out = _lz_decompress_blocks(destbuf, dlen, src, spans, nspans, bmax, !(flags & _LZ_FLG_INDEPENDENT), &err);
+    }
+    free(spans);
+    spans = NULL;
+    if (out == SIZE_MAX || (flags & _LZ_FLG_CONTENT_SIZE && out != content_size)) goto fail;
+
+    if (flags & _LZ_FLG_CONTENT_CHECKSUM) {
+        if (n - pos < 4 || _lz_read32(src + pos) != _lz_xxh((unsigned char *) *destbuf + dlen, out)) goto fail;
+        pos += 4;
+    }
+    strbuf_set_length(destbuf, dlen + out);
+    return pos;
+
+fail:
+    free(spans);
+    errno = err;
+    return 0;
+}
+
+bool lz_decompress(char **destbuf, const char *src, size_t n, size_t threads) {
+    strbuf_make_binary(destbuf);
+    size_t dlen = strbuf_length(*destbuf);
+    const unsigned char *p = (const unsigned char *) src;
+    while (n) {
+        size_t size = _lz_frame(destbuf, p, n, threads);
+        if (!size) {
+            strbuf_set_length(destbuf, dlen);
+            return false;
+        }
+        p += size;
+        n -= size;
+    }
+    return true;
+}
+
+/*
+ * Streaming
+ */
+
+bool lz_encoder_init(lz_encoder *e) {
+    e->block = malloc(CLZ_LZ_BLOCK);
+    e->len = 0;
+    e->started = false;
+    if (!e->block) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+static bool _lz_encoder_block(lz_encoder *e, char **destbuf, const char *src, size_t n) {
+    if (!_lz_reserve(destbuf, 15 + 4 + n)) return false;
+    size_t dlen = strbuf_length(*destbuf);
+    unsigned char *op = (unsigned char *) *destbuf + dlen;
+    if (!e->started) {
+        op += _lz_header(op, false, 0);
+        e->started = true;
+    }
+    if (n) op += _lz_frame_block(src, n, op);
+    strbuf_set_length(destbuf, op - (unsigned char *) *destbuf);
+    return true;
+}
+
+bool lz_encoder_write(lz_encoder *e, char **destbuf, const char *src, size_t n) {
+    strbuf_make_binary(destbuf);
+    while (n) {
+        // full blocks of the input are compressed without copying them
+        if (!e->len && n >= CLZ_LZ_BLOCK) {
+            if (!_lz_encoder_block(e, destbuf, src, CLZ_LZ_BLOCK)) return false;
+            src += CLZ_LZ_BLOCK;
+            n -= CLZ_LZ_BLOCK;
+            continue;
+        }
+        size_t take = CLZ_LZ_BLOCK - e->len < n ? CLZ_LZ_BLOCK - e->len : n;
+        memcpy(e->block + e->len, src, take);
+        e->len += take;
+        src += take;
+        n -= take;
+        if (e->len == CLZ_LZ_BLOCK) {
+            if (!_lz_encoder_block(e, destbuf, e->block, e->len)) return false;
+            e->len = 0;
+        }
+    }
+    return true;
+}
+
+bool lz_encoder_finish(lz_encoder *e, char **destbuf) {
+    strbuf_make_binary(destbuf);
+    if (!_lz_encoder_block(e, destbuf, e->block, e->len) || !_lz_reserve(destbuf, 4)) return false;
+    size_t dlen = strbuf_length(*destbuf);
+    _lz_write32((unsigned char *) *destbuf + dlen, 0);
+    strbuf_set_length(destbuf, dlen + 4);
+    e->len = 0;
+    e->started = false;
+    return true;
+}
+
+void lz_encoder_free(lz_encoder *e) {
+    free(e->block);
+    e->block = NULL;
+}
+
+void lz_decoder_init(lz_decoder *d) {
+    d->state = _LZ_D_MAGIC;
+    d->need = 4;
+    d->have = 0;
+    d->block = NULL;
+    d->bmax = 0;
+    d->produced = 0;
+}
+
+// handles a complete item, returning false if it is invalid
+static bool _lz_decoder_item(lz_decoder *d, char **destbuf, const unsigned char *p) {
+    switch (d->state) {
+        case _LZ_D_MAGIC:
+            if ((_lz_read32(p) & 0xFFFFFFF0U) == 0x184D2A50U) {
+                d->state = _LZ_D_SKIP_SIZE;
+                d->need = 4;
+                return true;
+            }
+            if (_lz_read32(p) != _LZ_MAGIC) break;
+            d->state = _LZ_D_FLAGS;
+            d->need = 1;
+            return true;
+        case _LZ_D_SKIP_SIZE:
+            d->skip = _lz_read32(p);
+            d->state = _LZ_D_SKIP;
+            return true;
+        case _LZ_D_FLAGS:
+            // the descriptor is read again from the start once its size is known
+            d->head[0] = p[0];
+            d->state = _LZ_D_DESCRIPTOR;
+            d->need = 3 + (p[0] & _LZ_FLG_CONTENT_SIZE ? 8 : 0) + (p[0] & _LZ_FLG_DICT_ID ? 4 : 0);
+            d->have = 1;
+            return true;
+        case _LZ_D_DESCRIPTOR: {
+            uint64_t content_size;
+            size_t bmax = d->bmax;
+            if (!_lz_descriptor(p, d->need, &d->flags, &d->bmax, &content_size)) break;
+            if (d->bmax > bmax) {
+                char *block = realloc(d->block, d->bmax + 4);
+                if (!block) {
+                    d->bmax = bmax;
+                    errno = ENOMEM;
+                    return false;
+                }
+                d->block = block;
+            }
+            _lz_xxh_init(&d->xxh);
+            d->produced = 0;
+            d->state = _LZ_D_BLOCK_SIZE;
+            d->need = 4;
+            return true;
+        }
+        case _LZ_D_BLOCK_SIZE: {
+            uint32_t v = _lz_read32(p);
+            if (!v) {
+                d->state = d->flags & _LZ_FLG_CONTENT_CHECKSUM ? _LZ_D_CHECKSUM : _LZ_D_MAGIC;
+                d->need = 4;
+                return true;
+            }
+            d->need = v & 0x7FFFFFFFU;
+            d->raw = v >> 31;
+            if (d->need > d->bmax) break;
+            d->need += d->flags & _LZ_FLG_BLOCK_CHECKSUM ? 4 : 0;
+            d->state = _LZ_D_BLOCK;
+            return true;
+        }
+        case _LZ_D_BLOCK: {
+            size_t size = d->need - (d->flags & _LZ_FLG_BLOCK_CHECKSUM ? 4 : 0), out = size;
+            if (d->flags & _LZ_FLG_BLOCK_CHECKSUM && _lz_read32(p + size) != _lz_xxh(p, size)) break;
+            if (!_lz_reserve(destbuf, d->bmax)) return false;
+            size_t dlen = strbuf_length(*destbuf);
+            unsigned char *op = (unsigned char *) *destbuf + dlen;
+            // linked blocks refer to the output of the frame kept in the buffer
+            const unsigned char *low = op;
+            if (!(d->flags & _LZ_FLG_INDEPENDENT)) low -= d->produced < dlen ? d->produced : dlen;
+            if (d->raw) memcpy(op, p, size);
+            else if (!_lz_decompress(p, size, op, d->bmax, low, &out)) break;
+            if (d->flags & _LZ_FLG_CONTENT_CHECKSUM) _lz_xxh_update(&d->xxh, op, out);
+            d->produced += out;
+            strbuf_set_length(destbuf, dlen + out);
+            d->state = _LZ_D_BLOCK_SIZE;
+            d->need = 4;
+            return true;
+        }
+        case _LZ_D_CHECKSUM:
+            if (_lz_read32(p) != _lz_xxh_digest(&d->xxh)) break;
+            d->state = _LZ_D_MAGIC;
+            return true;
+        default:
+            break;
+    }
+    d->state = _LZ_D_FAILED;
+    errno = EINVAL;
+    return false;
+}
+
+bool lz_decoder_write(lz_decoder *d, char **destbuf, const char *src, size_t n) {
+    const unsigned char *p = (const unsigned char *) src;
+    strbuf_make_binary(destbuf);
+    while (n) {
+        if (d->state == _LZ_D_FAILED) {
+            errno = EINVAL;
+            return false;
+        }
+        if (d->state == _LZ_D_SKIP) {
+            size_t take = d->skip < n ? d->skip : n;
+            p += take;
+            n -= take;
+            d->skip -= take;
+            if (!d->skip) {
+                d->state = _LZ_D_MAGIC;
+                d->need = 4;
+            }
+            continue;
+        }
+
+        unsigned char *buf = d->state == _LZ_D_BLOCK ? (unsigned char *) d->block : d->head;
+        size_t take = d->need - d->have < n ? d->need - d->have : n;
+        const unsigned char *item = p;
+        // an item received at once is used where it is
+        if (d->have || take < d->need) {
+            memcpy(buf + d->have, p, take);
+            item = buf;
+        }
+        d->have += take;
+        p += take;
+        n -= take;
+        if (d->have < d->need) continue;
+        d->have = 0;
+        if (!_lz_decoder_item(d, destbuf, item)) return false;
+    }
+    return true;
+}
+
+bool lz_decoder_done(lz_decoder *d) {
+    return d->state == _LZ_D_MAGIC && !d->have;
+}
+
+void lz_decoder_free(lz_decoder *d) {
+    free(d->block);
+    d->block = NULL;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains the internal helpers shared by the multi-threaded functions of the library, such as
+ * those of @ref strbuf_parallel.h, @ref csv.h and @ref lz.h: choosing a number of threads for an input, and running
+ * a function on an array of work items with one thread per item.
+ *
+ * **Implementation**
+ *
+ * There is no implementation section, as this header file contains only `static inline` helpers. It requires
+ * POSIX threads.
+ *
+ * @file parallel.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the internal helpers for multi-threaded functions
+ *
+ */
+
+#ifndef _CLZ_PARALLEL_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_PARALLEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// the number of threads for len bytes, each one getting at least min bytes, 0 standing for one per online processor
+static inline size_t _clz_threads(size_t threads, size_t len, size_t min) {
+    if (!threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t) online : 1;
+    }
+    if (min && threads > len / min) threads = len / min;
+    return threads ? threads : 1;
+}
+
+// runs fn on count elements of the given size, the first one on the calling thread
+static inline void _clz_run(void *(*fn)(void *), void *args, size_t size, size_t count) {
+    pthread_t *tids = count > 1 ? malloc((count - 1) * sizeof(pthread_t)) : NULL;
+    bool *started = count > 1 ? calloc(count - 1, sizeof(bool)) : NULL;
+    for (size_t i = 1; i < count; ++i) {
+        // without threads, the work is done sequentially
+        if (tids && started) started[i - 1] = !pthread_create(tids + i - 1, NULL, fn, (char *) args + i * size);
+    }
+    fn(args);
+    for (size_t i = 1; i < count; ++i) {
+        if (tids && started && started[i - 1]) pthread_join(tids[i - 1], NULL);
+        else fn((char *) args + i * size);
+    }
+    free(tids);
+    free(started);
+}
+
+#endif
@@ -0,0 +1,624 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a piece table, a text representation for editing large documents. The text is never
+ * copied on edits: it is described by a sequence of pieces, each referring to a range of either the original
+ * document (read-only, not owned by the table) or the add buffer, an append-only strbuf holding all inserted text.
+ * An insertion appends to the add buffer and splits a piece, a removal shortens or drops pieces.
+ *
+ * The pieces are kept in a balanced tree (a treap ordered by position, where every node knows the length of its
+ * subtree), so that edits and lookups take `O(log n)` time in the number of pieces. The tree is persistent:
+ * nodes are reference counted and never modified while shared, so that a snapshot of the whole document is a single
+ * reference to the root and takes `O(1)` time. Edits copy only the path to the affected nodes that are still shared
+ * with a snapshot. The undo and redo stacks of the table are made of such snapshots.
+ *
+ * Example:
+ *
+ * @code
+ *     piecetable pt;
+ *     if (!piecetable_init(&pt, text, strlen(text))) return false;
+ *     piecetable_checkpoint(&pt);
+ *     piecetable_insert(&pt, "Hello ", 0, 6);
+ *     piecetable_remove(&pt, 6, 12);
+ *     piecetable_undo(&pt); // back to text
+ *
+ *     char *buf = strbuf_new();
+ *     piecetable_append_to(&buf, &pt, 0, piecetable_length(&pt));
+ *     piecetable_free(&pt);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_PIECETABLE_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h and @ref dynarray.h.
+ *
+ * @file piecetable.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a piece table with snapshots
+ *
+ */
+
+#ifndef _CLZ_PIECETABLE_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_PIECETABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * @brief A snapshot of the contents of a @ref piecetable
+ *
+ * A snapshot is only valid for the table it was taken from, and has to be released with @ref piecetable_release.
+ */
+typedef struct _piece_node *piecetable_snapshot;
+
+/**
+ * @brief Definition of a piece table
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct piecetable {
+    /**
+     * @brief The original document, which is not owned by the table
+     */
+    const char *original;
+    /**
+     * @brief The length of the original document
+     */
+    size_t original_len;
+    /**
+     * @brief The add buffer, a binary strbuf
+     */
+    char *add;
+    /**
+     * @brief The root of the tree of pieces
+     */
+    struct _piece_node *root;
+    /**
+     * @brief The stack of snapshots restored by @ref piecetable_undo
+     */
+    dynarray undo;
+    /**
+     * @brief The stack of snapshots restored by @ref piecetable_redo
+     */
+    dynarray redo;
+    /**
+     * @brief The state of the generator of the tree priorities
+     */
+    uint64_t seed;
+} piecetable;
+
+/**
+ * @brief Initializes a piece table over a document.
+ *
+ * The document is not copied, and has to stay valid and unchanged while the table is used.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param pt The table to initialize
+ * @param original The document
+ * @param len The length of the document
+ * @return `true` if successful
+ *
+ * @see piecetable_free
+ */
+bool piecetable_init(piecetable *pt, const char *original, size_t len);
+/**
+ * @brief Frees the memory held by the table, including the undo and redo stacks.
+ *
+ * Snapshots taken with @ref piecetable_snapshot_take are not released.
+ *
+ * @param pt The table
+ */
+void piecetable_free(piecetable *pt);
+/**
+ * @brief Returns the length of the document
+ *
+ * @param pt The table
+ * @return The length of the document
+ */
+size_t piecetable_length(piecetable *pt);
+/**
+ * @brief Returns the number of pieces describing the document
+ *
+ * @param pt The table
+ * @return The number of pieces
+ */
+size_t piecetable_pieces(piecetable *pt);
+/**
+ * @brief Inserts `n` bytes at `index`.
+ *
+ * Typing at the end of the last insertion extends its piece instead of adding a new one.
+ *
+ * If `index` is greater than the length of the document, `false` is returned and nothing happens. Since heap
+ * allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param pt The table
+ * @param src The bytes to insert
+ * @param index The position to insert at
+ * @param n The number of bytes
+ * @return `true` if successful
+ */
+bool piecetable_insert(piecetable *pt, const char *src, size_t index, size_t n);
+/**
+ * @brief Removes the bytes in the range from `start` (included) to `end` (excluded).
+ *
+ * If the range is not within the document, `false` is returned and nothing happens. Since heap allocation may be
+ * used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param pt The table
+ * @param start The start of the range
+ * @param end The end of the range
+ * @return `true` if successful
+ */
+bool piecetable_remove(piecetable *pt, size_t start, size_t end);
+/**
+ * @brief Copies up to `n` bytes starting at `index` to a byte array.
+ *
+ * @param pt The table
+ * @param index The position of the first byte
+ * @param out The destination array, of at least `n` bytes
+ * @param n The maximum number of bytes
+ * @return The number of bytes copied
+ */
+size_t piecetable_read(piecetable *pt, size_t index, char *out, size_t n);
+/**
+ * @brief Appends up to `n` bytes starting at `index` to a strbuf.
+ *
+ * The destination is grown once and the pieces copied into it directly. The mode of the destination is preserved:
+ * a document containing null bytes should be appended to a binary strbuf (see @ref strbuf_make_binary).
+ *
+ * Since heap allocation may be used, failure is possible. In this case, `false` is returned and `errno` is set
+ * to `ENOMEM`.
+ *
+ * @param destbuf The destination buffer
+ * @param pt The table
+ * @param index The position of the first byte
+ * @param n The maximum number of bytes
+ * @return `true` if successful
+ */
+bool piecetable_append_to(char **destbuf, piecetable *pt, size_t index, size_t n);
+/**
+ * @brief Takes a snapshot of the document in constant time.
+ *
+ * @param pt The table
+ * @return The snapshot, or `NULL` if the document is empty
+ *
+ * @see piecetable_restore, piecetable_release
+ */
+piecetable_snapshot piecetable_snapshot_take(piecetable *pt);
+/**
+ * @brief Replaces the document with a snapshot in constant time.
+ *
+ * The snapshot stays valid and still has to be released.
+ *
+ * @param pt The table the snapshot was taken from
+ * @param s The snapshot
+ */
+void piecetable_restore(piecetable *pt, piecetable_snapshot s);
+/**
+ * @brief Releases a snapshot.
+ *
+ * @param s The snapshot
+ */
+void piecetable_release(piecetable_snapshot s);
+/**
+ * @brief Pushes a snapshot of the document onto the undo stack and clears the redo stack.
+ *
+ * Since heap allocation may be used, failure is possible. In this case, `false` is returned and `errno` is set
+ * to `ENOMEM`.
+ *
+ * @param pt The table
+ * @return `true` if successful
+ *
+ * @see piecetable_undo, piecetable_redo
+ */
+bool piecetable_checkpoint(piecetable *pt);
+/**
+ * @brief Restores the last checkpoint, saving the document onto the redo stack.
+ *
+ * If the undo stack is empty or heap allocation fails, `false` is returned and nothing happens.
+ *
+ * @param pt The table
+ * @return `true` if successful
+ */
+bool piecetable_undo(piecetable *pt);
+/**
+ * @brief Restores the document saved by the last @ref piecetable_undo, saving the document onto the undo stack.
+ *
+ * If the redo stack is empty or heap allocation fails, `false` is returned and nothing happens.
+ *
+ * @param pt The table
+ * @return `true` if successful
+ */
+bool piecetable_redo(piecetable *pt);
+
+#endif
+
+#ifdef CLZ_PIECETABLE_IMPL
+#undef CLZ_PIECETABLE_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+struct _piece_node {
+    struct _piece_node *left;
+    struct _piece_node *right;
+    size_t refs;
+    uint32_t prio;
+    // whether the piece refers to the add buffer
+    bool add;
+    size_t start;
+    size_t len;
+    // length and number of pieces of the subtree
+    size_t total;
+    size_t count;
+};
+
+static inline size_t _piece_total(struct _piece_node *t) {
+    return t ? t->total : 0;
+}
+
+static inline void _piece_update(struct _piece_node *t) {
+    t->total = _piece_total(t->left) + t->len + _piece_total(t->right);
+    t->count = (t->left ? t->left->count : 0) + 1 + (t->right ? t->right->count : 0);
+}
+
+static inline struct _piece_node *_piece_ref(struct _piece_node *t) {
+    if (t) ++t->refs;
+    return t;
+}
+
+static void _piece_drop(struct _piece_node *t) {
+    while (t && --t->refs == 0) {
+        struct _piece_node *right = t->right;
+        _piece_drop(t->left);
+        free(t);
+        t = right;
+    }
+}
+
+static uint32_t _piece_prio(piecetable *pt) {
+    // xorshift64*
+    pt->seed ^= pt->seed >> 12;
+    pt->seed ^= pt->seed << 25;
+    pt->seed ^= pt->seed >> 27;
+    return (uint32_t) ((pt->seed * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static struct _piece_node *_piece_node_new(bool add, size_t start, size_t len, uint32_t prio) {
+    struct _piece_node *t = malloc(sizeof(struct _piece_node));
+    if (!t) return NULL;
+    t->left = t->right = NULL;
+    t->refs = 1;
+    t->prio = prio;
+    t->add = add;
+    t->start = start;
+    t->len = len;
+    _piece_update(t);
+    return t;
+}
+
+// takes a reference to t, and returns a node that is not shared, copying t if needed
+static struct _piece_node *_piece_own(struct _piece_node *t) {
+    if (t->refs == 1) return t;
+    struct _piece_node *c = malloc(sizeof(struct _piece_node));
+    if (!c) return NULL;
+    *c = *t;
+    c->refs = 1;
+    _piece_ref(c->left);
+    _piece_ref(c->right);
+    --t->refs;
+    return c;
+}
+
+// takes a reference to t, and splits it into the first k bytes and the rest
+static bool _piece_split(struct _piece_node *t, size_t k, struct _piece_node **l, struct _piece_node **r) {
+    *l = *r = NULL;
+    if (!t) return true;
+    if (k == 0) {
+        *r = t;
+        return true;
+    }
+    if (k >= t->total) {
+        *l = t;
+        return true;
+    }
+
+    struct _piece_node *o = _piece_own(t);
+    if (!o) {
+        _piece_drop(t);
+        return false;
+    }
+    size_t leftlen = _piece_total(o->left);
+    bool ok = true;
+    if (k <= leftlen) {
+        struct _piece_node *a;
+        ok = _piece_split(o->left, k, l, &a);
+        o->left = a;
+        *r = o;
+    } else if (k >= leftlen + o->len) {
+        struct _piece_node *b;
+        ok = _piece_split(o->right, k - leftlen - o->len, &b, r);
+        o->right = b;
+        *l = o;
+    } else {
+        size_t off = k - leftlen;
+        struct _piece_node *m = _piece_node_new(o->add, o->start + off, o->len - off, o->prio);
+        if (m) {
+            m->right = o->right;
+            _piece_update(m);
+            o->right = NULL;
+            o->len = off;
+        } else {
+            ok = false;
+        }
+        *l = o;
+        *r = m;
+    }
+    _piece_update(o);
+    return ok;
+}
+
+// takes references to a and b, and concatenates them
+static struct _piece_node *_piece_merge(struct _piece_node *a, struct _piece_node *b) {
+    if (!a) return b;
+    if (!b) return a;
+    struct _piece_node *t;
+    if (a->prio > b->prio) {
+        if (!(t = _piece_own(a))) goto fail;
+        // on failure, both subtrees have been released
+        if (!(t->right = _piece_merge(t->right, b))) goto fail_child;
+    } else {
+        if (!(t = _piece_own(b))) goto fail;
+        if (!(t->left = _piece_merge(a, t->left))) goto fail_child;
+    }
+    _piece_update(t);
+    return t;
+
+fail:
+    _piece_drop(a);
+    _piece_drop(b);
+    return NULL;
+
+fail_child:
+    _piece_drop(t);
+    return NULL;
+}
+
+// whether the last piece of t ends at the end of the add buffer
+static bool _piece_extendable(struct _piece_node *t, size_t addlen) {
+    while (t && t->right) t = t->right;
+    return t && t->add && t->start + t->len == addlen;
+}
+
+// extends the last piece of *link by n bytes, copying the shared nodes on the way
+static bool _piece_extend(struct _piece_node **link, size_t n) {
+    struct _piece_node *o = _piece_own(*link);
+    if (!o) return false;
+    *link = o;
+    bool ok = true;
+    if (o->right) ok = _piece_extend(&o->right, n);
+    else o->len += n;
+    _piece_update(o);
+    return ok;
+}
+
+bool piecetable_init(piecetable *pt, const char *original, size_t len) {
+    pt->original = original;
+    pt->original_len = len;
+    pt->root = NULL;
+    pt->seed = 0x9E3779B97F4A7C15ULL ^ (uint64_t) (uintptr_t) pt;
+    pt->add = strbuf_new();
+    if (!pt->add) goto fail;
+    strbuf_make_binary(&pt->add);
+    if (len && !(pt->root = _piece_node_new(false, 0, len, _piece_prio(pt)))) goto fail_add;
+    if (!dynarray_init(&pt->undo)) goto fail_root;
+    if (!dynarray_init(&pt->redo)) goto fail_undo;
+    return true;
+
+fail_undo:
+    dynarray_free(&pt->undo, false);
+fail_root:
+    _piece_drop(pt->root);
+fail_add:
+    strbuf_free(pt->add);
+fail:
+    errno = ENOMEM;
+    return false;
+}
+
+static void _piece_clear_stack(dynarray *d) {
+    while (dynarray_length(d)) _piece_drop(dynarray_pop(d));
+}
+
+void piecetable_free(piecetable *pt) {
+    _piece_clear_stack(&pt->undo);
+    _piece_clear_stack(&pt->redo);
+    dynarray_free(&pt->undo, false);
+    dynarray_free(&pt->redo, false);
+    _piece_drop(pt->root);
+    strbuf_free(pt->add);
+    pt->root = NULL;
+    pt->add = NULL;
+}
+
+size_t piecetable_length(piecetable *pt) {
+    return _piece_total(pt->root);
+}
+
+size_t piecetable_pieces(piecetable *pt) {
+    return pt->root ? pt->root->count : 0;
+}
+
+bool piecetable_insert(piecetable *pt, const char *src, size_t index, size_t n) {
+    if (index > piecetable_length(pt)) return false;
+    if (!n) return true;
+    size_t addlen = strbuf_length(pt->add);
+    if (!strbuf_append_bytes(&pt->add, src, n)) return false;
+
+    // the edit works on a new version of the tree, so that the document is unchanged on failure
+    struct _piece_node *l, *r, *t = NULL;
+    if (!_piece_split(_piece_ref(pt->root), index, &l, &r)) goto fail;
+    if (_piece_extendable(l, addlen)) {
+        if (!_piece_extend(&l, n)) goto fail;
+        t = l;
+    } else {
+        struct _piece_node *m = _piece_node_new(true, addlen, n, _piece_prio(pt));
+        if (!m) goto fail;
+        if (!(t = _piece_merge(l, m))) goto fail_merge;
+    }
+    if (!(t = _piece_merge(t, r))) goto fail_add;
+    _piece_drop(pt->root);
+    pt->root = t;
+    return true;
+
+fail:
+    _piece_drop(l);
+fail_merge:
+    _piece_drop(r);
+fail_add:
+    strbuf_set_length(&pt->add, addlen);
+    errno = ENOMEM;
+    return false;
+}
+
+bool piecetable_remove(piecetable *pt, size_t start, size_t end) {
+    if (start > end || end > piecetable_length(pt)) return false;
+    if (start == end) return true;
+
+    struct _piece_node *l, *rest, *m, *r;
+    if (!_piece_split(_piece_ref(pt->root), start, &l, &rest)) {
+        _piece_drop(rest);
+        goto fail;
+    }
+    bool ok = _piece_split(rest, end - start, &m, &r);
+    _piece_drop(m);
+    if (!ok) {
+        _piece_drop(r);
+        goto fail;
+    }
+    struct _piece_node *t = _piece_merge(l, r);
+    if (!t && (l || r)) goto fail_merge;
+    _piece_drop(pt->root);
+    pt->root = t;
+    return true;
+
+fail:
+    _piece_drop(l);
+fail_merge:
+    errno = ENOMEM;
+    return false;
+}
+
+static char *_piece_copy(piecetable *pt, struct _piece_node *t, size_t index, char *out, size_t n) {
+    while (t && n) {
+        size_t leftlen = _piece_total(t->left);
+        if (index < leftlen) {
+            size_t k = leftlen - index < n ? leftlen - index : n;
+            out = _piece_copy(pt, t->left, index, out, k);
+            n -= k;
+            index = leftlen;
+        }
+        if (n && index < leftlen + t->len) {
+            size_t off = index - leftlen, k = t->len - off < n ? t->len - off : n;
+            memcpy(out, (t->add ? pt->add : pt->original) + t->start + off, k);
+            out += k;
+            n -= k;
+            index += k;
+        }
+        index -= leftlen + t->len;
+        t = t->right;
+    }
+    return out;
+}
+
+size_t piecetable_read(piecetable *pt, size_t index, char *out, size_t n) {
+    size_t len = piecetable_length(pt);
+    if (index >= len) return 0;
+    if (n > len - index) n = len - index;
+    return _piece_copy(pt, pt->root, index, out, n) - out;
+}
+
+bool piecetable_append_to(char **destbuf, piecetable *pt, size_t index, size_t n) {
+    size_t len = piecetable_length(pt), dlen = strbuf_length(*destbuf);
+    if (index >= len) return true;
+    if (n > len - index) n = len - index;
+    if (strbuf_alloc_size(*destbuf) < dlen + n + 1 && !strbuf_resize(destbuf, dlen + n + 1)) return false;
+    _piece_copy(pt, pt->root, index, *destbuf + dlen, n);
+    return strbuf_set_length(destbuf, dlen + n);
+}
+
+piecetable_snapshot piecetable_snapshot_take(piecetable *pt) {
+    return _piece_ref(pt->root);
+}
+
+void piecetable_restore(piecetable *pt, piecetable_snapshot s) {
+    _piece_ref(s);
+    _piece_drop(pt->root);
+    pt->root = s;
+}
+
+void piecetable_release(piecetable_snapshot s) {
+    _piece_drop(s);
+}
+
+// the empty document is a NULL root, so failure is told by the length of the stack
+static bool _piece_push(dynarray *d, struct _piece_node *t) {
+    size_t len = dynarray_length(d);
+    dynarray_append(d, t);
+    if (dynarray_length(d) == len) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+// moves the document to the top of stack `to`, and replaces it with the top of stack `from`
+static bool _piece_swap(piecetable *pt, dynarray *from, dynarray *to) {
+    if (!dynarray_length(from) || !_piece_push(to, pt->root)) return false;
+    pt->root = dynarray_pop(from);
+    return true;
+}
+
+bool piecetable_checkpoint(piecetable *pt) {
+    if (!_piece_push(&pt->undo, pt->root)) return false;
+    _piece_ref(pt->root);
+    _piece_clear_stack(&pt->redo);
+    return true;
+}
+
+bool piecetable_undo(piecetable *pt) {
+    return _piece_swap(pt, &pt->undo, &pt->redo);
+}
+
+bool piecetable_redo(piecetable *pt) {
+    return _piece_swap(pt, &pt->redo, &pt->undo);
+}
+
+#endif
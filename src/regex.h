@@ -0,0 +1,1254 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a regular expression engine whose running time is linear in the length of the input,
+ * whatever the pattern: there is no backtracking. The following syntax is supported:
+ *
+ * - literal bytes, and `\` followed by a punctuation character for the character itself
+ * - `.` for any byte except `'\n'`, `[abc]`, `[a-z]`, `[^abc]` for sets of bytes
+ * - `\d`, `\w`, `\s` for digits, word characters and whitespace, `\D`, `\W`, `\S` for their complements
+ * - `\n`, `\r`, `\t`, `\f`, `\v`, `\xHH` for control characters and arbitrary bytes
+ * - `^` and `$` for the start and the end of the input
+ * - `(...)` for capture groups and `(?:...)` for non-capturing groups, `|` for alternatives
+ * - `*`, `+`, `?`, `{n}`, `{n,}`, `{n,m}` for repetitions, followed by `?` to make them lazy. A repetition can only
+ *   be repeated again inside a group, as in `(?:a*)+`
+ *
+ * Matches are leftmost-first, as in Perl and PCRE: among the matches starting at the leftmost position, the one
+ * preferred by the alternatives and the greediness of the repetitions is returned. Matching is done on bytes.
+ *
+ * The pattern is compiled into a program for a Thompson NFA, which is executed in two ways:
+ *
+ * - a lazy DFA, whose states are sets of NFA instructions, built on demand and cached in the compiled expression.
+ *   Once the states for an input are known, every byte costs one table lookup. The cache holds up to
+ *   @ref CLZ_REGEX_DFA_STATES states and is flushed when full. The DFA tells whether and where a match ends,
+ *   which is all that @ref regex_test needs and lets @ref regex_search reject inputs without a match quickly.
+ * - a Pike VM, which simulates all NFA threads in lockstep, each with its own captures, so that the bounds and the
+ *   groups of the leftmost-first match are known. It only runs once the DFA has found that a match exists.
+ *
+ * If every match starts with the same literal bytes (as in `"ERROR [0-9]+"`), both skip ahead to the next
+ * occurrence of them with @ref strbuf_memmem whenever no match is in progress.
+ *
+ * Example:
+ *
+ * @code
+ *     regex re;
+ *     if (!regex_compile(&re, "(\\w+)@(\\w+)\\.com")) return false;
+ *     clz_view caps[3];
+ *     if (regex_search(&re, buf, strbuf_length(buf), 0, caps, 3)) {
+ *         printf("user %.*s\n", (int) caps[1].len, caps[1].ptr);
+ *     }
+ *     strbuf_regex_replace_all(&buf, &re, "$1 at $2");
+ *     regex_free(&re);
+ * @endcode
+ *
+ * **Notes**
+ *
+ * The caches of a compiled expression are modified by every match, so an expression must not be used by several
+ * threads at the same time. Compile one per thread instead.
+ *
+ * A repetition whose body can match the empty string, as in `(a|b?)*`, may end at a different position than with
+ * a backtracking engine: an iteration matching nothing does not stop the repetition, the next alternative of the
+ * body is tried instead. Other expressions match exactly as in Perl.
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_REGEX_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h.
+ *
+ * @file regex.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a linear-time regular expression engine
+ *
+ */
+
+#ifndef _CLZ_REGEX_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_REGEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "clz.h"
+#include "strbuf.h"
+
+/**
+ * Macro defining the maximum number of states cached by the lazy DFA of an expression.
+ */
+#ifndef CLZ_REGEX_DFA_STATES
+#define CLZ_REGEX_DFA_STATES 1024
+#endif
+
+/**
+ * Macro defining the maximum number of instructions of a compiled expression.
+ */
+#ifndef CLZ_REGEX_MAX_INST
+#define CLZ_REGEX_MAX_INST 65536
+#endif
+
+/**
+ * Macro defining the maximum count of a repetition `{n,m}`.
+ */
+#ifndef CLZ_REGEX_MAX_REPEAT
+#define CLZ_REGEX_MAX_REPEAT 1000
+#endif
+
+/**
+ * Macro defining the maximum nesting depth of groups and repetitions.
+ */
+#ifndef CLZ_REGEX_MAX_DEPTH
+#define CLZ_REGEX_MAX_DEPTH 256
+#endif
+
+/**
+ * @brief Definition of a compiled regular expression
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct regex {
+    /**
+     * @brief The instructions of the NFA
+     */
+    struct _regex_inst *prog;
+    /**
+     * @brief The number of instructions
+     */
+    size_t ninst;
+    /**
+     * @brief The byte sets matched by the instructions, a bitmap of 32 bytes each
+     */
+    uint8_t (*sets)[32];
+    /**
+     * @brief The number of byte sets
+     */
+    size_t nsets;
+    /**
+     * @brief The number of capture groups, including the whole match as group `0`
+     */
+    size_t ngroups;
+    /**
+     * @brief The literal bytes every match starts with
+     */
+    char *prefix;
+    /**
+     * @brief The number of literal bytes every match starts with
+     */
+    size_t prefix_len;
+    /**
+     * @brief Whether every match starts at the beginning of the input
+     */
+    bool anchored;
+    /**
+     * @brief The state of the Pike VM
+     */
+    struct _regex_vm *vm;
+    /**
+     * @brief The cache of the lazy DFA
+     */
+    struct _regex_dfa *dfa;
+} regex;
+
+/**
+ * @brief Compiles a regular expression.
+ *
+ * If the pattern is invalid or too large (see @ref CLZ_REGEX_MAX_INST), `false` is returned and `errno` is set
+ * to `EINVAL`. Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno`
+ * is set to `ENOMEM`.
+ *
+ * @param re The expression to initialize
+ * @param pattern The null-terminated pattern
+ * @return `true` if successful
+ *
+ * @see regex_free, regex_search
+ */
+bool regex_compile(regex *re, const char *pattern);
+/**
+ * @brief Frees the memory held by a compiled expression.
+ *
+ * @param re The expression
+ */
+void regex_free(regex *re);
+/**
+ * @brief Tells whether a string contains a match.
+ *
+ * This only runs the DFA, and stops at the end of the earliest match.
+ *
+ * @param re The expression
+ * @param s The string, which may contain null bytes
+ * @param len The length of the string
+ * @return `true` if there is a match
+ */
+bool regex_test(regex *re, const char *s, size_t len);
+/**
+ * @brief Finds the leftmost-first match starting at or after `from`.
+ *
+ * `^` still only matches at the start of the string, not at `from`. On success, the first `ncaps` groups are stored
+ * into `caps`, group `0` being the whole match. A group that did not take part in the match, or does not exist,
+ * is stored as an empty view with a `NULL` pointer. With `ncaps` equal to `0`, only the DFA is run.
+ *
+ * @param re The expression
+ * @param s The string, which may contain null bytes
+ * @param len The length of the string
+ * @param from The position to start searching at
+ * @param caps The array receiving the groups, or `NULL`
+ * @param ncaps The number of groups to store
+ * @return `true` if there is a match
+ *
+ * @see regex_groups
+ */
+bool regex_search(regex *re, const char *s, size_t len, size_t from, clz_view *caps, size_t ncaps);
+/**
+ * @brief Replaces all matches within a strbuf.
+ *
+ * In `replacement`, `$0` to `$9` stand for the groups of the match and `$$` for a single `$`. Matches do not
+ * overlap and are taken from left to right; an empty match right after the previous match is skipped. All matches
+ * are found before the output is written, so that the new buffer is allocated once with its final size. The buffer
+ * keeps its mode (see @ref strbuf_make_binary).
+ *
+ * If nothing is found, the buffer is left unchanged. If heap allocation fails, the buffer is left unchanged, `0` is
+ * returned and `errno` is set to `ENOMEM`.
+ *
+ * @param destbuf The destination buffer
+ * @param re The expression
+ * @param replacement The null-terminated replacement
+ * @return the number of replacements
+ */
+size_t strbuf_regex_replace_all(char **destbuf, regex *re, const char *replacement);
+
+/**
+ * @brief Returns the number of capture groups of an expression, including the whole match as group `0`
+ */
+#define regex_groups(re) ((re)->ngroups)
+
+#endif
+
+#ifdef CLZ_REGEX_IMPL
+#undef CLZ_REGEX_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+enum {
+    _REGEX_SET, _REGEX_SPLIT, _REGEX_JMP, _REGEX_SAVE, _REGEX_BOL, _REGEX_EOL, _REGEX_MATCH
+};
+
+struct _regex_inst {
+    uint8_t op;
+    // set, first target or capture slot
+    uint32_t x;
+    // second target of a split, taken if the first one fails
+    uint32_t y;
+};
+
+enum {
+    _REGEX_N_EMPTY, _REGEX_N_SET, _REGEX_N_CAT, _REGEX_N_ALT, _REGEX_N_REPEAT, _REGEX_N_GROUP, _REGEX_N_BOL,
+    _REGEX_N_EOL
+};
+
+struct _regex_node {
+    int type;
+    // first child of a concatenation, alternation, repetition or group
+    int child;
+    // next sibling within a concatenation or alternation
+    int next;
+    int min;
+    // -1 if unbounded
+    int max;
+    bool greedy;
+    // set or group
+    size_t x;
+};
+
+typedef struct _regex_parser {
+    const char *p;
+    regex *re;
+    struct _regex_node *nodes;
+    size_t nnodes;
+    size_t cap;
+    size_t sets_cap;
+    int depth;
+    int err;
+} _regex_parser;
+
+struct _regex_state {
+    size_t off;
+    uint32_t n;
+    bool match;
+};
+
+struct _regex_dfa {
+    uint8_t classes[256];
+    // a byte of every class
+    unsigned char reps[256];
+    size_t nclasses;
+    struct _regex_state *states;
+    size_t nstates;
+    // next state for every state and class, -1 if not known yet
+    int32_t *trans;
+    // hash table of the states, -1 if empty
+    int32_t *table;
+    // instructions of all states
+    uint32_t *pool;
+    size_t npool;
+    size_t pool_cap;
+    // start state without and with `^`
+    int32_t start[2];
+    uint32_t *mark;
+    uint32_t gen;
+    uint32_t *work;
+    size_t nwork;
+    uint32_t *stack;
+};
+
+struct _regex_frame {
+    uint32_t pc;
+    // whether the frame restores a capture slot instead of adding an instruction
+    bool restore;
+    size_t slot;
+    size_t val;
+};
+
+struct _regex_vm {
+    // two sparse sets of instructions with the captures of their threads
+    uint32_t *dense[2];
+    uint32_t *sparse[2];
+    size_t n[2];
+    size_t *caps[2];
+    struct _regex_frame *stack;
+    size_t *tmp;
+    size_t *best;
+};
+
+#define _REGEX_TABLE (2 * CLZ_REGEX_DFA_STATES)
+#define _REGEX_UNSET ((size_t) -1)
+
+static inline bool _regex_in(const uint8_t set[32], unsigned char c) {
+    return set[c >> 3] & (1 << (c & 7));
+}
+
+static inline void _regex_add_range(uint8_t set[32], unsigned lo, unsigned hi) {
+    for (unsigned c = lo; c <= hi; ++c) set[c >> 3] |= 1 << (c & 7);
+}
+
+/*
+ * Parser, building a tree of nodes
+ */
+
+static int _regex_node_new(_regex_parser *ps, int type) {
+    if (ps->nnodes == ps->cap) {
+        size_t cap = ps->cap ? 2 * ps->cap : 64;
+        struct _regex_node *nodes = realloc(ps->nodes, cap * sizeof(struct _regex_node));
+        if (!nodes) {
+            ps->err = ENOMEM;
+            return -1;
+        }
+        ps->nodes = nodes;
+        ps->cap = cap;
+    }
+    struct _regex_node *n = ps->nodes + ps->nnodes;
+    memset(n, 0, sizeof(struct _regex_node));
+    n->type = type;
+    n->child = n->next = -1;
+    return (int) ps->nnodes++;
+}
+
+// a node matching a new, empty set
+static int _regex_set_new(_regex_parser *ps) {
+    regex *re = ps->re;
+    if (re->nsets == ps->sets_cap) {
+        size_t cap = ps->sets_cap ? 2 * ps->sets_cap : 16;
+        uint8_t (*sets)[32] = realloc(re->sets, cap * sizeof(*sets));
+        if (!sets) {
+            ps->err = ENOMEM;
+            return -1;
+        }
+        re->sets = sets;
+        ps->sets_cap = cap;
+    }
+    int n = _regex_node_new(ps, _REGEX_N_SET);
+    if (n < 0) return -1;
+    memset(re->sets[re->nsets], 0, 32);
+    ps->nodes[n].x = re->nsets++;
+    return n;
+}
+
+static inline uint8_t *_regex_node_set(_regex_parser *ps, int n) {
+    return ps->re->sets[ps->nodes[n].x];
+}
+
+static int _regex_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// parses the escape after `\`, adding its bytes to the set
+static bool _regex_escape(_regex_parser *ps, uint8_t set[32]) {
+    char c = *ps->p++;
+    uint8_t cls[32] = {0};
+    switch (c) {
+        case 'd': case 'D':
+            _regex_add_range(cls, '0', '9');
+            break;
+        case 'w': case 'W':
+            _regex_add_range(cls, '0', '9');
+            _regex_add_range(cls, 'a', 'z');
+            _regex_add_range(cls, 'A', 'Z');
+            _regex_add_range(cls, '_', '_');
+            break;
+        case 's': case 'S':
+            _regex_add_range(cls, '\t', '\r');
+            _regex_add_range(cls, ' ', ' ');
+            break;
+        case 'n': _regex_add_range(set, '\n', '\n'); return true;
+        case 'r': _regex_add_range(set, '\r', '\r'); return true;
+        case 't': _regex_add_range(set, '\t', '\t'); return true;
+        case 'f': _regex_add_range(set, '\f', '\f'); return true;
+        case 'v': _regex_add_range(set, '\v', '\v'); return true;
+        case 'x': {
+            int hi = _regex_hex(ps->p[0]), lo = hi < 0 ? -1 : _regex_hex(ps->p[1]);
+            if (lo < 0) goto invalid;
+            ps->p += 2;
+            _regex_add_range(set, hi * 16 + lo, hi * 16 + lo);
+            return true;
+        }
+        default:
+            // letters and digits are reserved for escapes
+            if (!c || isalnum((unsigned char) c)) goto invalid;
+            _regex_add_range(set, (unsigned char) c, (unsigned char) c);
+            return true;
+    }
+    bool negate = isupper((unsigned char) c);
+    for (int i = 0; i < 32; ++i) set[i] |= negate ? ~cls[i] : cls[i];
+    return true;
+
+invalid:
+    ps->err = EINVAL;
+    return false;
+}
+
+// parses a set after `[`
+static int _regex_parse_class(_regex_parser *ps) {
+    int n = _regex_set_new(ps);
+    if (n < 0) return -1;
+    uint8_t set[32] = {0};
+    bool negate = *ps->p == '^';
+    if (negate) ++ps->p;
+
+    // a `]` right after the opening bracket is a member
+    for (bool first = true; *ps->p != ']' || first; first = false) {
+        if (!*ps->p) goto invalid;
+        unsigned char lo = (unsigned char) *ps->p++;
+        if (lo == '\\') {
+            uint8_t esc[32] = {0};
+            if (!_regex_escape(ps, esc)) return -1;
+            int count = 0;
+            for (unsigned c = 0; c < 256; ++c) {
+                if (_regex_in(esc, c)) lo = c, ++count;
+            }
+            // a class such as `\d` cannot start a range
+            if (count != 1) {
+                for (int i = 0; i < 32; ++i) set[i] |= esc[i];
+                continue;
+            }
+        }
+        unsigned char hi = lo;
+        if (ps->p[0] == '-' && ps->p[1] && ps->p[1] != ']') {
+            ++ps->p;
+            hi = (unsigned char) *ps->p++;
+            if (hi == '\\') {
+                uint8_t esc[32] = {0};
+                if (!_regex_escape(ps, esc)) return -1;
+                for (unsigned c = 0; c < 256; ++c) {
+                    if (_regex_in(esc, c)) hi = c;
+                }
+            }
+            if (hi < lo) goto invalid;
+        }
+        _regex_add_range(set, lo, hi);
+    }
+    ++ps->p;
+    for (int i = 0; i < 32; ++i) _regex_node_set(ps, n)[i] = negate ? ~set[i] : set[i];
+    return n;
+
+invalid:
+    ps->err = EINVAL;
+    return -1;
+}
+
+static int _regex_parse_alt(_regex_parser *ps);
+
+static int _regex_parse_atom(_regex_parser *ps) {
+    int n;
+    char c = *ps->p++;
+    switch (c) {
+        case '(': {
+            if (++ps->depth > CLZ_REGEX_MAX_DEPTH) goto invalid;
+            bool capture = true;
+            if (ps->p[0] == '?') {
+                if (ps->p[1] != ':') goto invalid;
+                capture = false;
+                ps->p += 2;
+            }
+            size_t group = capture ? ps->re->ngroups++ : 0;
+            int child = _regex_parse_alt(ps);
+            if (child < 0) return -1;
+            if (*ps->p++ != ')') goto invalid;
+            --ps->depth;
+            if (!capture) return child;
+            if ((n = _regex_node_new(ps, _REGEX_N_GROUP)) < 0) return -1;
+            ps->nodes[n].child = child;
+            ps->nodes[n].x = group;
+            return n;
+        }
+        case '[':
+            return _regex_parse_class(ps);
+        case '.':
+            if ((n = _regex_set_new(ps)) < 0) return -1;
+            memset(_regex_node_set(ps, n), 0xFF, 32);
+            _regex_node_set(ps, n)['\n' >> 3] &= ~(1 << ('\n' & 7));
+            return n;
+        case '^':
+            return _regex_node_new(ps, _REGEX_N_BOL);
+        case '$':
+            return _regex_node_new(ps, _REGEX_N_EOL);
+        case '\\':
+            if ((n = _regex_set_new(ps)) < 0) return -1;
+            return _regex_escape(ps, _regex_node_set(ps, n)) ? n : -1;
+        case '*': case '+': case '?':
+            // nothing to repeat
+            goto invalid;
+        default:
+            if ((n = _regex_set_new(ps)) < 0) return -1;
+            _regex_add_range(_regex_node_set(ps, n), (unsigned char) c, (unsigned char) c);
+            return n;
+    }
+
+invalid:
+    ps->err = EINVAL;
+    return -1;
+}
+
+// parses `{n}`, `{n,}` or `{n,m}`, returning false without moving if the brace is a literal
+static bool _regex_parse_count(_regex_parser *ps, int *min, int *max) {
+    const char *p = ps->p + 1;
+    if (!isdigit((unsigned char) *p)) return false;
+    long lo = strtol(p, (char **) &p, 10), hi = lo;
+    if (*p == ',') {
+        ++p;
+        hi = isdigit((unsigned char) *p) ? strtol(p, (char **) &p, 10) : -1;
+    }
+    if (*p != '}') return false;
+    if (lo > CLZ_REGEX_MAX_REPEAT || hi > CLZ_REGEX_MAX_REPEAT || (hi >= 0 && hi < lo)) {
+        ps->err = EINVAL;
+        return false;
+    }
+    *min = (int) lo;
+    *max = (int) hi;
+    ps->p = p + 1;
+    return true;
+}
+
+static int _regex_parse_repeat(_regex_parser *ps) {
+    int n = _regex_parse_atom(ps), min, max;
+    if (n < 0) return -1;
+    char c = *ps->p;
+    if (c == '*') min = 0, max = -1, ++ps->p;
+    else if (c == '+') min = 1, max = -1, ++ps->p;
+    else if (c == '?') min = 0, max = 1, ++ps->p;
+    else if (c != '{' || !_regex_parse_count(ps, &min, &max)) return ps->err ? -1 : n;
+
+    if (++ps->depth > CLZ_REGEX_MAX_DEPTH) {
+        ps->err = EINVAL;
+        return -1;
+    }
+    int r = _regex_node_new(ps, _REGEX_N_REPEAT);
+    if (r < 0) return -1;
+    ps->nodes[r].child = n;
+    ps->nodes[r].min = min;
+    ps->nodes[r].max = max;
+    ps->nodes[r].greedy = *ps->p != '?';
+    if (*ps->p == '?') ++ps->p;
+
+    // a repetition cannot be repeated without a group, as in `a**`
+    _regex_parser peek = *ps;
+    c = *ps->p;
+    if (c == '*' || c == '+' || c == '?' || (c == '{' && _regex_parse_count(&peek, &min, &max))) {
+        ps->err = EINVAL;
+        return -1;
+    }
+    return ps->err ? -1 : r;
+}
+
+static int _regex_parse_cat(_regex_parser *ps) {
+    int cat = _regex_node_new(ps, _REGEX_N_CAT), last = -1;
+    if (cat < 0) return -1;
+    int depth = ps->depth;
+    while (*ps->p && *ps->p != '|' && *ps->p != ')') {
+        int n = _regex_parse_repeat(ps);
+        if (n < 0) return -1;
+        ps->depth = depth;
+        if (last < 0) ps->nodes[cat].child = n;
+        else ps->nodes[last].next = n;
+        last = n;
+    }
+    return cat;
+}
+
+static int _regex_parse_alt(_regex_parser *ps) {
+    int n = _regex_parse_cat(ps);
+    if (n < 0 || *ps->p != '|') return n;
+
+    int alt = _regex_node_new(ps, _REGEX_N_ALT), last = n;
+    if (alt < 0) return -1;
+    ps->nodes[alt].child = n;
+    while (*ps->p == '|') {
+        ++ps->p;
+        if ((n = _regex_parse_cat(ps)) < 0) return -1;
+        ps->nodes[last].next = n;
+        last = n;
+    }
+    return alt;
+}
+
+/*
+ * Compiler, emitting the instructions of the tree
+ */
+
+typedef struct _regex_compiler {
+    regex *re;
+    struct _regex_node *nodes;
+    size_t cap;
+    int err;
+} _regex_compiler;
+
+static uint32_t _regex_inst(_regex_compiler *c, uint8_t op, uint32_t x, uint32_t y) {
+    regex *re = c->re;
+    if (c->err) return 0;
+    if (re->ninst == CLZ_REGEX_MAX_INST) {
+        c->err = EINVAL;
+        return 0;
+    }
+    if (re->ninst == c->cap) {
+        size_t cap = c->cap ? 2 * c->cap : 64;
+        struct _regex_inst *prog = realloc(re->prog, cap * sizeof(struct _regex_inst));
+        if (!prog) {
+            c->err = ENOMEM;
+            return 0;
+        }
+        re->prog = prog;
+        c->cap = cap;
+    }
+    re->prog[re->ninst] = (struct _regex_inst) {op, x, y};
+    return (uint32_t) re->ninst++;
+}
+
+static void _regex_emit(_regex_compiler *c, int node) {
+    struct _regex_node *n = c->nodes + node;
+    regex *re = c->re;
+    switch (n->type) {
+        case _REGEX_N_SET:
+            _regex_inst(c, _REGEX_SET, (uint32_t) n->x, 0);
+            break;
+        case _REGEX_N_BOL:
+            _regex_inst(c, _REGEX_BOL, 0, 0);
+            break;
+        case _REGEX_N_EOL:
+            _regex_inst(c, _REGEX_EOL, 0, 0);
+            break;
+        case _REGEX_N_CAT:
+            for (int i = n->child; i >= 0 && !c->err; i = c->nodes[i].next) _regex_emit(c, i);
+            break;
+        case _REGEX_N_GROUP:
+            _regex_inst(c, _REGEX_SAVE, (uint32_t) (2 * n->x), 0);
+            _regex_emit(c, n->child);
+            _regex_inst(c, _REGEX_SAVE, (uint32_t) (2 * n->x + 1), 0);
+            break;
+        case _REGEX_N_ALT: {
+            // every alternative but the last one jumps to the end, chained through the x of the jumps
+            uint32_t jumps = UINT32_MAX;
+            for (int i = n->child; i >= 0 && !c->err; i = c->nodes[i].next) {
+                if (c->nodes[i].next < 0) {
+                    _regex_emit(c, i);
+                    break;
+                }
+                uint32_t split = _regex_inst(c, _REGEX_SPLIT, 0, 0);
+                _regex_emit(c, i);
+                uint32_t jmp = _regex_inst(c, _REGEX_JMP, jumps, 0);
+                if (c->err) return;
+                jumps = jmp;
+                re->prog[split].x = split + 1;
+                re->prog[split].y = (uint32_t) re->ninst;
+            }
+            while (!c->err && jumps != UINT32_MAX) {
+                uint32_t prev = re->prog[jumps].x;
+                re->prog[jumps].x = (uint32_t) re->ninst;
+                jumps = prev;
+            }
+            break;
+        }
+        case _REGEX_N_REPEAT: {
+            int min = n->min, max = n->max;
+            bool greedy = n->greedy;
+            // x+ loops on its last copy instead of emitting x*
+            for (int i = 0; i < (max < 0 && min ? min - 1 : min) && !c->err; ++i) _regex_emit(c, n->child);
+            if (max < 0 && min) {
+                uint32_t body = (uint32_t) re->ninst;
+                _regex_emit(c, n->child);
+                uint32_t split = _regex_inst(c, _REGEX_SPLIT, 0, 0);
+                if (c->err) return;
+                re->prog[split].x = greedy ? body : split + 1;
+                re->prog[split].y = greedy ? split + 1 : body;
+            } else if (max < 0) {
+                uint32_t split = _regex_inst(c, _REGEX_SPLIT, 0, 0);
+                _regex_emit(c, n->child);
+                _regex_inst(c, _REGEX_JMP, split, 0);
+                if (c->err) return;
+                re->prog[split].x = greedy ? split + 1 : (uint32_t) re->ninst;
+                re->prog[split].y = greedy ? (uint32_t) re->ninst : split + 1;
+            } else {
+                // optional copies, all skipping to the end, chained through the y of the splits
+                uint32_t splits = UINT32_MAX;
+                for (int i = min; i < max && !c->err; ++i) {
+                    uint32_t split = _regex_inst(c, _REGEX_SPLIT, 0, splits);
+                    splits = split;
+                    _regex_emit(c, n->child);
+                }
+                while (!c->err && splits != UINT32_MAX) {
+                    uint32_t prev = re->prog[splits].y;
+                    re->prog[splits].x = greedy ? splits + 1 : (uint32_t) re->ninst;
+                    re->prog[splits].y = greedy ? (uint32_t) re->ninst : splits + 1;
+                    splits = prev;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*
+ * Lazy DFA
+ */
+
+static void _regex_dfa_gen(struct _regex_dfa *d, size_t ninst) {
+    if (++d->gen == 0) {
+        memset(d->mark, 0, ninst * sizeof(uint32_t));
+        d->gen = 1;
+    }
+    d->nwork = 0;
+}
+
+// adds the instructions consuming a byte, matching or waiting for the end, which are reachable from pc
+static void _regex_dfa_closure(regex *re, uint32_t pc, bool bol, bool eol) {
+    struct _regex_dfa *d = re->dfa;
+    size_t n = 0;
+    if (d->mark[pc] == d->gen) return;
+    d->mark[pc] = d->gen;
+    d->stack[n++] = pc;
+    while (n) {
+        pc = d->stack[--n];
+        struct _regex_inst *in = re->prog + pc;
+        uint32_t next[2];
+        int k = 0;
+        switch (in->op) {
+            case _REGEX_JMP: next[k++] = in->x; break;
+            case _REGEX_SPLIT: next[k++] = in->x; next[k++] = in->y; break;
+            case _REGEX_SAVE: next[k++] = pc + 1; break;
+            case _REGEX_BOL: if (bol) next[k++] = pc + 1; break;
+            case _REGEX_EOL:
+                if (eol) next[k++] = pc + 1;
+                else d->work[d->nwork++] = pc;
+                break;
+            default: d->work[d->nwork++] = pc; break;
+        }
+        for (int i = 0; i < k; ++i) {
+            if (d->mark[next[i]] == d->gen) continue;
+            d->mark[next[i]] = d->gen;
+            d->stack[n++] = next[i];
+        }
+    }
+}
+
+static int _regex_cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// finds or adds the state made of the work list, flushing the cache if it is full
+static int32_t _regex_dfa_state(regex *re, bool *flushed) {
+    struct _regex_dfa *d = re->dfa;
+    qsort(d->work, d->nwork, sizeof(uint32_t), _regex_cmp_u32);
+    uint64_t h = CLZ_FNV_OFFSET;
+    for (size_t i = 0; i < d->nwork; ++i) h = (h ^ d->work[i]) * CLZ_FNV_PRIME;
+
+    size_t slot = h % _REGEX_TABLE;
+    for (; d->table[slot] >= 0; slot = (slot + 1) % _REGEX_TABLE) {
+        struct _regex_state *st = d->states + d->table[slot];
+        if (st->n == d->nwork && !memcmp(d->pool + st->off, d->work, d->nwork * sizeof(uint32_t))) {
+            return d->table[slot];
+        }
+    }
+    if (d->nstates == CLZ_REGEX_DFA_STATES) {
+        d->nstates = d->npool = 0;
+        d->start[0] = d->start[1] = -1;
+        for (size_t i = 0; i < _REGEX_TABLE; ++i) d->table[i] = -1;
+        slot = h % _REGEX_TABLE;
+        *flushed = true;
+    }
+    if (d->npool + d->nwork > d->pool_cap) {
+        size_t cap = 2 * d->pool_cap > d->npool + d->nwork ? 2 * d->pool_cap : d->npool + d->nwork;
+        uint32_t *pool = realloc(d->pool, cap * sizeof(uint32_t));
+        if (!pool) return -1;
+        d->pool = pool;
+        d->pool_cap = cap;
+    }
+
+    int32_t s = (int32_t) d->nstates++;
+    struct _regex_state *st = d->states + s;
+    st->off = d->npool;
+    st->n = (uint32_t) d->nwork;
+    st->match = false;
+    for (size_t i = 0; i < d->nwork; ++i) st->match |= re->prog[d->work[i]].op == _REGEX_MATCH;
+    memcpy(d->pool + d->npool, d->work, d->nwork * sizeof(uint32_t));
+    d->npool += d->nwork;
+    for (size_t c = 0; c < d->nclasses; ++c) d->trans[s * d->nclasses + c] = -1;
+    d->table[slot] = s;
+    return s;
+}
+
+static int32_t _regex_dfa_start(regex *re, bool bol) {
+    struct _regex_dfa *d = re->dfa;
+    if (d->start[bol] >= 0) return d->start[bol];
+    _regex_dfa_gen(d, re->ninst);
+    _regex_dfa_closure(re, 0, bol, false);
+    bool flushed = false;
+    return d->start[bol] = _regex_dfa_state(re, &flushed);
+}
+
+static int32_t _regex_dfa_step(regex *re, int32_t s, size_t c) {
+    struct _regex_dfa *d = re->dfa;
+    unsigned char b = d->reps[c];
+    struct _regex_state *st = d->states + s;
+    _regex_dfa_gen(d, re->ninst);
+    for (uint32_t i = 0; i < st->n; ++i) {
+        struct _regex_inst *in = re->prog + d->pool[st->off + i];
+        if (in->op == _REGEX_SET && _regex_in(re->sets[in->x], b)) _regex_dfa_closure(re, d->pool[st->off + i] + 1, false, false);
+    }
+    // a match may start at every position
+    _regex_dfa_closure(re, 0, false, false);
+    bool flushed = false;
+    int32_t t = _regex_dfa_state(re, &flushed);
+    if (t >= 0 && !flushed) d->trans[s * d->nclasses + c] = t;
+    return t;
+}
+
+static bool _regex_dfa_eol(regex *re, int32_t s, bool bol) {
+    struct _regex_dfa *d = re->dfa;
+    struct _regex_state *st = d->states + s;
+    _regex_dfa_gen(d, re->ninst);
+    for (uint32_t i = 0; i < st->n; ++i) {
+        uint32_t pc = d->pool[st->off + i];
+        if (re->prog[pc].op == _REGEX_EOL) _regex_dfa_closure(re, pc + 1, bol, true);
+    }
+    for (size_t i = 0; i < d->nwork; ++i) {
+        if (re->prog[d->work[i]].op == _REGEX_MATCH) return true;
+    }
+    return false;
+}
+
+// 1 with the end of the earliest match, 0 if there is none, -1 if the cache cannot grow
+static int _regex_dfa_search(regex *re, const char *s, size_t len, size_t from, size_t *end) {
+    struct _regex_dfa *d = re->dfa;
+    const unsigned char *p = (const unsigned char *) s;
+    int32_t st = _regex_dfa_start(re, from == 0);
+    if (st < 0) return -1;
+
+    for (size_t pos = from;; ++pos) {
+        struct _regex_state *cur = d->states + st;
+        if (cur->match) {
+            *end = pos;
+            return 1;
+        }
+        if (!cur->n) return 0;
+        if (pos == len) {
+            if (!_regex_dfa_eol(re, st, len == 0)) return 0;
+            *end = len;
+            return 1;
+        }
+        // nothing in progress: skip to the next possible start
+        if (re->prefix_len && st == d->start[0]) {
+            const char *q = strbuf_memmem(s + pos, len - pos, re->prefix, re->prefix_len);
+            if (!q) return 0;
+            pos = q - s;
+        }
+        size_t c = d->classes[p[pos]];
+        int32_t next = d->trans[st * d->nclasses + c];
+        if (next < 0 && (next = _regex_dfa_step(re, st, c)) < 0) return -1;
+        st = next;
+        if (re->prefix_len && d->start[0] < 0 && _regex_dfa_start(re, false) < 0) return -1;
+    }
+}
+
+/*
+ * Pike VM
+ */
+
+static void _regex_vm_add(regex *re, int l, uint32_t pc, size_t *caps, size_t pos, size_t len) {
+    struct _regex_vm *vm = re->vm;
+    size_t nslots = 2 * re->ngroups, n = 0;
+    vm->stack[n++] = (struct _regex_frame) {pc, false, 0, 0};
+    while (n) {
+        struct _regex_frame f = vm->stack[--n];
+        if (f.restore) {
+            caps[f.slot] = f.val;
+            continue;
+        }
+        pc = f.pc;
+        uint32_t i = vm->sparse[l][pc];
+        if (i < vm->n[l] && vm->dense[l][i] == pc) continue;
+        i = (uint32_t) vm->n[l]++;
+        vm->sparse[l][pc] = i;
+        vm->dense[l][i] = pc;
+
+        // the frames are pushed in reverse order of priority
+        struct _regex_inst *in = re->prog + pc;
+        switch (in->op) {
+            case _REGEX_JMP:
+                vm->stack[n++] = (struct _regex_frame) {in->x, false, 0, 0};
+                break;
+            case _REGEX_SPLIT:
+                vm->stack[n++] = (struct _regex_frame) {in->y, false, 0, 0};
+                vm->stack[n++] = (struct _regex_frame) {in->x, false, 0, 0};
+                break;
+            case _REGEX_SAVE:
+                vm->stack[n++] = (struct _regex_frame) {0, true, in->x, caps[in->x]};
+                caps[in->x] = pos;
+                vm->stack[n++] = (struct _regex_frame) {pc + 1, false, 0, 0};
+                break;
+            case _REGEX_BOL:
+                if (pos == 0) vm->stack[n++] = (struct _regex_frame) {pc + 1, false, 0, 0};
+                break;
+            case _REGEX_EOL:
+                if (pos == len) vm->stack[n++] = (struct _regex_frame) {pc + 1, false, 0, 0};
+                break;
+            default:
+                memcpy(vm->caps[l] + i * nslots, caps, nslots * sizeof(size_t));
+                break;
+        }
+    }
+}
+
+// finds the leftmost-first match starting between from and last_start, storing its captures in vm->best
+static bool _regex_vm_run(regex *re, const char *s, size_t len, size_t from, size_t last_start) {
+    struct _regex_vm *vm = re->vm;
+    const unsigned char *p = (const unsigned char *) s;
+    size_t nslots = 2 * re->ngroups;
+    bool matched = false;
+    int cur = 0;
+    vm->n[cur] = 0;
+
+    for (size_t pos = from;; ++pos) {
+        if (!matched && pos <= last_start && (pos == from || !re->anchored)) {
+            if (!vm->n[cur] && re->prefix_len && !re->anchored) {
+                const char *q = strbuf_memmem(s + pos, len - pos, re->prefix, re->prefix_len);
+                if (!q || (size_t) (q - s) > last_start) break;
+                pos = q - s;
+            }
+            for (size_t i = 0; i < nslots; ++i) vm->tmp[i] = _REGEX_UNSET;
+            // lowest priority, after the threads that started earlier
+            _regex_vm_add(re, cur, 0, vm->tmp, pos, len);
+        }
+        if (!vm->n[cur]) break;
+
+        int next = !cur;
+        vm->n[next] = 0;
+        for (size_t i = 0; i < vm->n[cur]; ++i) {
+            struct _regex_inst *in = re->prog + vm->dense[cur][i];
+            size_t *caps = vm->caps[cur] + i * nslots;
+            if (in->op == _REGEX_MATCH) {
+                // the threads with lower priority are cut
+                matched = true;
+                memcpy(vm->best, caps, nslots * sizeof(size_t));
+                break;
+            }
+            if (in->op == _REGEX_SET && pos < len && _regex_in(re->sets[in->x], p[pos])) {
+                _regex_vm_add(re, next, vm->dense[cur][i] + 1, caps, pos + 1, len);
+            }
+        }
+        cur = next;
+        if (pos == len) break;
+    }
+    return matched;
+}
+
+/*
+ * Setup
+ */
+
+static bool _regex_setup(regex *re) {
+    size_t n = re->ninst, nslots = 2 * re->ngroups;
+    struct _regex_vm *vm = re->vm = calloc(1, sizeof(struct _regex_vm));
+    struct _regex_dfa *d = re->dfa = calloc(1, sizeof(struct _regex_dfa));
+    if (!vm || !d) return false;
+    for (int l = 0; l < 2; ++l) {
+        vm->dense[l] = malloc(n * sizeof(uint32_t));
+        vm->sparse[l] = calloc(n, sizeof(uint32_t));
+        vm->caps[l] = malloc(n * nslots * sizeof(size_t));
+        if (!vm->dense[l] || !vm->sparse[l] || !vm->caps[l]) return false;
+    }
+    vm->stack = malloc((2 * n + 2) * sizeof(struct _regex_frame));
+    vm->tmp = malloc(nslots * sizeof(size_t));
+    vm->best = malloc(nslots * sizeof(size_t));
+
+    // bytes belonging to the same sets are one class
+    d->nclasses = 1;
+    for (size_t i = 0; i < re->nsets; ++i) {
+        int16_t map[256][2];
+        uint8_t classes[256];
+        size_t count = 0;
+        memset(map, 0xFF, sizeof(map));
+        for (unsigned c = 0; c < 256; ++c) {
+            bool in = _regex_in(re->sets[i], (unsigned char) c);
+            if (map[d->classes[c]][in] < 0) map[d->classes[c]][in] = (int16_t) count++;
+            classes[c] = (uint8_t) map[d->classes[c]][in];
+        }
+        memcpy(d->classes, classes, 256);
+        d->nclasses = count;
+    }
+    for (unsigned c = 256; c-- > 0;) d->reps[d->classes[c]] = (unsigned char) c;
+
+    d->states = malloc(CLZ_REGEX_DFA_STATES * sizeof(struct _regex_state));
+    d->trans = malloc(CLZ_REGEX_DFA_STATES * d->nclasses * sizeof(int32_t));
+    d->table = malloc(_REGEX_TABLE * sizeof(int32_t));
+    d->pool_cap = 4 * n;
+    d->pool = malloc(d->pool_cap * sizeof(uint32_t));
+    d->mark = calloc(n, sizeof(uint32_t));
+    d->work = malloc(n * sizeof(uint32_t));
+    d->stack = malloc(n * sizeof(uint32_t));
+    if (!vm->stack || !vm->tmp || !vm->best || !d->states || !d->trans || !d->table || !d->pool || !d->mark
+        || !d->work || !d->stack) return false;
+    for (size_t i = 0; i < _REGEX_TABLE; ++i) d->table[i] = -1;
+    d->start[0] = d->start[1] = -1;
+
+    // without `^`, the first instructions are reachable at any position
+    _regex_dfa_gen(d, n);
+    _regex_dfa_closure(re, 0, false, false);
+    re->anchored = d->nwork == 0;
+
+    // the literal bytes before the first branch
+    re->prefix = malloc(n);
+    if (!re->prefix) return false;
+    for (uint32_t pc = 0; pc < n && re->prefix_len < n;) {
+        struct _regex_inst *in = re->prog + pc;
+        if (in->op == _REGEX_SAVE) {
+            ++pc;
+            continue;
+        }
+        if (in->op == _REGEX_JMP) {
+            pc = in->x;
+            continue;
+        }
+        if (in->op != _REGEX_SET) break;
+        int count = 0;
+        unsigned char byte = 0;
+        for (unsigned c = 0; c < 256 && count < 2; ++c) {
+            if (_regex_in(re->sets[in->x], (unsigned char) c)) byte = (unsigned char) c, ++count;
+        }
+        if (count != 1) break;
+        re->prefix[re->prefix_len++] = (char) byte;
+        ++pc;
+    }
+    return true;
+}
+
+bool regex_compile(regex *re, const char *pattern) {
+    memset(re, 0, sizeof(regex));
+    re->ngroups = 1;
+    _regex_parser ps = {.p = pattern, .re = re};
+    int root = _regex_parse_alt(&ps);
+    // an unmatched `)`
+    if (root >= 0 && *ps.p) {
+        ps.err = EINVAL;
+        root = -1;
+    }
+
+    _regex_compiler c = {.re = re, .nodes = ps.nodes, .err = ps.err};
+    if (root >= 0) {
+        _regex_inst(&c, _REGEX_SAVE, 0, 0);
+        _regex_emit(&c, root);
+        _regex_inst(&c, _REGEX_SAVE, 1, 0);
+        _regex_inst(&c, _REGEX_MATCH, 0, 0);
+    }
+    free(ps.nodes);
+    if (!c.err && !_regex_setup(re)) c.err = ENOMEM;
+    if (c.err) {
+        regex_free(re);
+        errno = c.err;
+        return false;
+    }
+    return true;
+}
+
+void regex_free(regex *re) {
+    struct _regex_vm *vm = re->vm;
+    struct _regex_dfa *d = re->dfa;
+    if (vm) {
+        for (int l = 0; l < 2; ++l) {
+            free(vm->dense[l]);
+            free(vm->sparse[l]);
+            free(vm->caps[l]);
+        }
+        free(vm->stack);
+        free(vm->tmp);
+        free(vm->best);
+        free(vm);
+    }
+    if (d) {
+        free(d->states);
+        free(d->trans);
+        free(d->table);
+        free(d->pool);
+        free(d->mark);
+        free(d->work);
+        free(d->stack);
+        free(d);
+    }
+    free(re->prog);
+    free(re->sets);
+    free(re->prefix);
+    memset(re, 0, sizeof(regex));
+}
+
+bool regex_test(regex *re, const char *s, size_t len) {
+    return regex_search(re, s, len, 0, NULL, 0);
+}
+
+bool regex_search(regex *re, const char *s, size_t len, size_t from, clz_view *caps, size_t ncaps) {
+    if (from > len) return false;
+    size_t end = len;
+    int found = _regex_dfa_search(re, s, len, from, &end);
+    if (!found) return false;
+    if (!ncaps && found > 0) return true;
+
+    // a match starts no later than the end of the earliest one
+    if (!_regex_vm_run(re, s, len, from, found > 0 ? end : len)) return false;
+    for (size_t i = 0; i < ncaps; ++i) {
+        size_t a = i < re->ngroups ? re->vm->best[2 * i] : _REGEX_UNSET;
+        size_t b = i < re->ngroups ? re->vm->best[2 * i + 1] : _REGEX_UNSET;
+        caps[i].ptr = a == _REGEX_UNSET || b == _REGEX_UNSET ? NULL : s + a;
+        caps[i].len = caps[i].ptr ? b - a : 0;
+    }
+    return true;
+}
+
+// writes the replacement of a match to out if not NULL, returning its length
+static size_t _regex_expand(const char *replacement, const char *s, const size_t *spans, size_t ngroups, char *out) {
+    size_t n = 0;
+    for (const char *r = replacement; *r; ++r) {
+        if (r[0] == '$' && r[1] == '$') {
+            if (out) out[n] = '$';
+            ++n;
+            ++r;
+        } else if (r[0] == '$' && isdigit((unsigned char) r[1])) {
+            size_t g = r[1] - '0';
+            ++r;
+            if (g >= ngroups || spans[2 * g] == _REGEX_UNSET) continue;
+            size_t glen = spans[2 * g + 1] - spans[2 * g];
+            if (out) memcpy(out + n, s + spans[2 * g], glen);
+            n += glen;
+        } else {
+            if (out) out[n] = *r;
+            ++n;
+        }
+    }
+    return n;
+}
+
+size_t strbuf_regex_replace_all(char **destbuf, regex *re, const char *replacement) {
+    size_t len = strbuf_length(*destbuf), ngroups = 1;
+    // only the groups used by the replacement are kept
+    for (const char *r = replacement; *r; ++r) {
+        if (r[0] == '$' && isdigit((unsigned char) r[1]) && (size_t) (r[1] - '0') + 1 > ngroups) {
+            ngroups = r[1] - '0' + 1;
+        }
+        if (r[0] == '$' && r[1]) ++r;
+    }
+    if (ngroups > re->ngroups) ngroups = re->ngroups;
+
+    size_t *spans = NULL, count = 0, cap = 0, outlen = len, pos = 0, last_end = _REGEX_UNSET;
+    clz_view caps[10];
+    while (pos <= len && regex_search(re, *destbuf, len, pos, caps, ngroups)) {
+        size_t start = caps[0].ptr - *destbuf, end = start + caps[0].len;
+        if (start == end && start == last_end) {
+            pos = start + 1;
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? 2 * cap : 16;
+            size_t *newspans = realloc(spans, cap * 2 * ngroups * sizeof(size_t));
+            if (!newspans) goto fail;
+            spans = newspans;
+        }
+        size_t *m = spans + count++ * 2 * ngroups;
+        for (size_t g = 0; g < ngroups; ++g) {
+            m[2 * g] = caps[g].ptr ? (size_t) (caps[g].ptr - *destbuf) : _REGEX_UNSET;
+            m[2 * g + 1] = caps[g].ptr ? m[2 * g] + caps[g].len : _REGEX_UNSET;
+        }
+        outlen += _regex_expand(replacement, *destbuf, m, ngroups, NULL) - (end - start);
+        last_end = end;
+        pos = end > start ? end : end + 1;
+    }
+    if (!count) return 0;
+
+    char *newbuf = strbuf_new_size(outlen + 1);
+    if (!newbuf) goto fail;
+    if (strbuf_is_binary(*destbuf)) strbuf_make_binary(&newbuf);
+    char *out = newbuf;
+    const char *in = *destbuf;
+    for (size_t i = 0; i < count; ++i) {
+        size_t *m = spans + i * 2 * ngroups;
+        memcpy(out, in, *destbuf + m[0] - in);
+        out += *destbuf + m[0] - in;
+        out += _regex_expand(replacement, *destbuf, m, ngroups, out);
+        in = *destbuf + m[1];
+    }
+    memcpy(out, in, *destbuf + len - in);
+    strbuf_set_length(&newbuf, outlen);
+
+    free(spans);
+    strbuf_free(*destbuf);
+    *destbuf = newbuf;
+    return count;
+
+fail:
+    free(spans);
+    errno = ENOMEM;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,480 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * A @ref screen is a double-buffered grid of character cells meant for programs that redraw a full
+ * terminal screen periodically, such as live dashboards. The program draws every frame from scratch into
+ * the back buffer with @ref screen_put_str, without caring about what was drawn before. When the frame is
+ * complete, @ref screen_flush compares it with the previous frame and sends only the cells that changed,
+ * together with the cursor movements and color sequences (see @ref color.h) needed to get there, in a
+ * single `write`. For mostly static screens this is a small fraction of a full redraw.
+ *
+ * Example:
+ *
+ * @code
+ *     screen *scr = screen_new(24, 80);
+ *     for (;;) {
+ *         screen_clear(scr);
+ *         screen_put_str(scr, 0, 0, SCREEN_BOLD_GREEN, "Status");
+ *         screen_put_str(scr, 1, 0, SCREEN_DEFAULT, current_status);
+ *         screen_flush(scr, STDOUT_FILENO);
+ *         usleep(100000);
+ *     }
+ *     screen_free(scr);
+ * @endcode
+ *
+ * Every cell holds exactly one UTF-8 encoded code point and is assumed to occupy one terminal column.
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_SCREEN_IMPL` is defined beforehand. @ref screen_render
+ * requires the implementation of @ref strbuf.h to be included as well.
+ *
+ * @file screen.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a terminal screen buffer with differential redraw
+ *
+ */
+
+#ifndef _CLZ_SCREEN_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_SCREEN_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+#include "color.h"
+#include "strbuf.h"
+
+/**
+ * @brief Definition of enum representing the style of a cell
+ *
+ * Every value corresponds to one of the color sequences defined in @ref color.h, `SCREEN_DEFAULT`
+ * corresponding to @ref COL_RESET.
+ */
+enum screen_style {
+    SCREEN_DEFAULT,
+    SCREEN_RED, SCREEN_BOLD_RED,
+    SCREEN_GREEN, SCREEN_BOLD_GREEN,
+    SCREEN_YELLOW, SCREEN_BOLD_YELLOW,
+    SCREEN_BLUE, SCREEN_BOLD_BLUE,
+    SCREEN_MAGENTA, SCREEN_BOLD_MAGENTA,
+    SCREEN_CYAN, SCREEN_BOLD_CYAN
+};
+
+/**
+ * @brief Definition of structure representing a single character cell
+ */
+typedef struct screen_cell {
+    /**
+     * @brief The UTF-8 bytes of the code point, packed little end first. `0` is a blank cell.
+     */
+    uint32_t ch;
+    /**
+     * @brief The style of the cell, see @ref screen_style
+     */
+    unsigned char style;
+} screen_cell;
+
+/**
+ * @brief Definition of structure representing a terminal screen buffer
+ *
+ * **Notes**
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ * Use the provided API instead!
+ *
+ * @see screen_new, screen_put_str, screen_flush
+ */
+typedef struct screen {
+    /**
+     * @brief The number of rows
+     */
+    size_t rows;
+    /**
+     * @brief The number of columns
+     */
+    size_t cols;
+    /**
+     * @brief The frame currently shown by the terminal
+     */
+    screen_cell *front;
+    /**
+     * @brief The frame being drawn
+     */
+    screen_cell *back;
+    /**
+     * @brief Internal output buffer, reused across frames
+     */
+    char *out;
+    /**
+     * @brief Length of the contents of @ref out
+     */
+    size_t out_len;
+    /**
+     * @brief Allocation size of @ref out
+     */
+    size_t out_alloc;
+    /**
+     * @brief The row of the terminal cursor, `SIZE_MAX` if unknown
+     */
+    size_t cur_row;
+    /**
+     * @brief The column of the terminal cursor
+     */
+    size_t cur_col;
+    /**
+     * @brief Whether the next frame has to be drawn from scratch
+     */
+    bool invalid;
+} screen;
+
+/**
+ * @brief Allocates a new screen buffer with the given dimensions
+ *
+ * Both frames start out blank. The first frame rendered clears the terminal and is drawn in full. Either dimension
+ * may be `0`, e.g. when the size of the terminal cannot be determined, which gives an empty screen where nothing
+ * is drawn.
+ *
+ * This function makes use of dynamic allocation (see `malloc` family). As such, it could _fail_
+ * if heap allocation fails. In this case, `NULL` is returned.
+ *
+ * **Notes**
+ *
+ * Use @ref screen_free on screens returned by this function after done using.
+ *
+ * @param rows The number of rows
+ * @param cols The number of columns
+ * @return The pointer to the screen if successful, `NULL` otherwise
+ *
+ * @see screen_free, screen_resize
+ */
+screen *screen_new(size_t rows, size_t cols);
+/**
+ * @brief Frees the screen buffer
+ *
+ * @param scr The screen
+ *
+ * @see screen_new
+ */
+void screen_free(screen *scr);
+/**
+ * @brief Changes the dimensions of the screen
+ *
+ * This function should be called when the terminal is resized (`SIGWINCH`). Both frames are reset to blank
+ * and the next frame is drawn from scratch. Either dimension may be `0`, see @ref screen_new. If heap allocation
+ * fails, or `rows * cols` overflows, the screen is left unchanged, `false` is returned and `errno` is set to
+ * `ENOMEM`.
+ *
+ * @param scr The screen
+ * @param rows The new number of rows
+ * @param cols The new number of columns
+ * @return `true` if successful
+ *
+ * @see screen_invalidate
+ */
+bool screen_resize(screen *scr, size_t rows, size_t cols);
+/**
+ * @brief Forces the next frame to be drawn from scratch
+ *
+ * This function should be called when something other than the screen has written to the terminal.
+ *
+ * @param scr The screen
+ */
+void screen_invalidate(screen *scr);
+/**
+ * @brief Blanks the frame being drawn
+ *
+ * @param scr The screen
+ */
+void screen_clear(screen *scr);
+/**
+ * @brief Writes a string into the frame being drawn
+ *
+ * This function decodes `s` as UTF-8 and stores one code point per cell, starting at the given position and
+ * moving to the right. Characters that fall outside of the screen are discarded. Control characters and
+ * invalid bytes are stored as `'?'`. If `style` is not one of the values of @ref screen_style, nothing is written.
+ *
+ * @param scr The screen
+ * @param row The row
+ * @param col The column of the first character
+ * @param style The style of the cells
+ * @param s The string
+ * @return The number of cells written
+ *
+ * @see screen_clear, screen_flush
+ */
+size_t screen_put_str(screen *scr, size_t row, size_t col, enum screen_style style, char *s);
+/**
+ * @brief Appends the sequence turning the previous frame into the current one to a strbuf
+ *
+ * This function compares the frame being drawn with the frame the terminal shows and appends the
+ * minimal cursor movements, color sequences and characters to `destbuf`. Afterwards the terminal is
+ * assumed to show the frame being drawn, which is kept as is so that the next frame can be drawn on top of it.
+ *
+ * Short gaps of unchanged cells are rewritten instead of skipped when this is cheaper than moving the cursor.
+ * The terminal style is always reset at the end of the sequence.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and the next frame is
+ * drawn from scratch.
+ *
+ * @param scr The screen
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ *
+ * @see screen_flush
+ */
+bool screen_render(screen *scr, char **destbuf);
+/**
+ * @brief Sends the changes of the current frame to a file descriptor
+ *
+ * This function behaves like @ref screen_render, but writes the sequence to `fd` with a single `write`
+ * (retried only on partial writes and `EINTR`). Nothing is written if nothing changed.
+ *
+ * @param scr The screen
+ * @param fd The file descriptor of the terminal, typically `STDOUT_FILENO`
+ * @return `true` if successful
+ *
+ * @see screen_render
+ */
+bool screen_flush(screen *scr, int fd);
+
+#endif
+
+#ifdef CLZ_SCREEN_IMPL
+#undef CLZ_SCREEN_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+static const char *_screen_style_seq[] = {
+    COL_RESET,
+    COL_RED, COL_BOLD_RED,
+    COL_GREEN, COL_BOLD_GREEN,
+    COL_YELLOW, COL_BOLD_YELLOW,
+    COL_BLUE, COL_BOLD_BLUE,
+    COL_MAGENTA, COL_BOLD_MAGENTA,
+    COL_CYAN, COL_BOLD_CYAN
+};
+
+screen *screen_new(size_t rows, size_t cols) {
+    screen *scr = calloc(1, sizeof(screen));
+    if (scr == NULL) return NULL;
+    if (!screen_resize(scr, rows, cols)) {
+        free(scr);
+        return NULL;
+    }
+    return scr;
+}
+
+void screen_free(screen *scr) {
+    free(scr->front);
+    free(scr->back);
+    free(scr->out);
+    free(scr);
+}
+
+bool screen_resize(screen *scr, size_t rows, size_t cols) {
+    if (cols && rows > SIZE_MAX / cols) {
+        errno = ENOMEM;
+        return false;
+    }
+    // an empty screen still gets a cell, since calloc may return NULL for zero bytes
+    size_t cells = rows && cols ? rows * cols : 1;
+    screen_cell *front = calloc(cells, sizeof(screen_cell));
+    screen_cell *back = calloc(cells, sizeof(screen_cell));
+    if (front == NULL || back == NULL) {
+        free(front);
+        free(back);
+        errno = ENOMEM;
+        return false;
+    }
+    free(scr->front);
+    free(scr->back);
+    scr->front = front;
+    scr->back = back;
+    scr->rows = rows;
+    scr->cols = cols;
+    screen_invalidate(scr);
+    return true;
+}
+
+void screen_invalidate(screen *scr) {
+    scr->invalid = true;
+    scr->cur_row = SIZE_MAX;
+}
+
+void screen_clear(screen *scr) {
+    memset(scr->back, 0, scr->rows * scr->cols * sizeof(screen_cell));
+}
+
+size_t screen_put_str(screen *scr, size_t row, size_t col, enum screen_style style, char *s) {
+    // the style indexes _screen_style_seq when the frame is drawn
+    if (row >= scr->rows || (size_t) style >= sizeof(_screen_style_seq) / sizeof(_screen_style_seq[0])) return 0;
+    size_t written = 0;
+    const unsigned char *p = (const unsigned char *) s;
+
+    while (*p && col < scr->cols) {
+        size_t n = 1;
+        if (*p >= 0xC0 && *p < 0xF8) n = *p < 0xE0 ? 2 : *p < 0xF0 ? 3 : 4;
+
+        size_t i;
+        for (i = 1; i < n && (p[i] & 0xC0) == 0x80; ++i);
+
+        uint32_t ch;
+        if (i < n || (*p >= 0x80 && n == 1) || *p < 0x20 || *p == 0x7F) {
+            ch = '?';
+            n = 1;
+        } else {
+            ch = 0;
+            for (i = 0; i < n; ++i) ch |= (uint32_t) p[i] << (8 * i);
+        }
+
+        screen_cell *cell = scr->back + row * scr->cols + col;
+        cell->ch = ch;
+        cell->style = style;
+        p += n;
+        ++col;
+        ++written;
+    }
+    return written;
+}
+
+static bool _screen_emit(screen *scr, const char *s, size_t n) {
+    if (scr->out_len + n + 1 > scr->out_alloc) {
+        size_t alloc = scr->out_alloc ? scr->out_alloc : 4096;
+        while (alloc < scr->out_len + n + 1) alloc *= 2;
+        char *out = realloc(scr->out, alloc);
+        if (out == NULL) return false;
+        scr->out = out;
+        scr->out_alloc = alloc;
+    }
+    memcpy(scr->out + scr->out_len, s, n);
+    scr->out_len += n;
+    scr->out[scr->out_len] = '\0';
+    return true;
+}
+
+static size_t _screen_cell_bytes(const screen_cell *cell, char *dest) {
+    if (cell->ch == 0) {
+        *dest = ' ';
+        return 1;
+    }
+    size_t n = 0;
+    for (uint32_t ch = cell->ch; ch; ch >>= 8) dest[n++] = (char) (ch & 0xFF);
+    return n;
+}
+
+static bool _screen_diff(screen *scr) {
+    unsigned char style = SCREEN_DEFAULT;
+    size_t crow = scr->cur_row, ccol = scr->cur_col;
+    char seq[48];
+    bool ok = true;
+
+    scr->out_len = 0;
+    if (scr->invalid) {
+        ok &= _screen_emit(scr, COL_RESET "\033[H\033[2J", strlen(COL_RESET "\033[H\033[2J"));
+        memset(scr->front, 0, scr->rows * scr->cols * sizeof(screen_cell));
+        crow = 0;
+        ccol = 0;
+        scr->invalid = false;
+    }
+
+    for (size_t r = 0; r < scr->rows; ++r) {
+        screen_cell *front = scr->front + r * scr->cols, *back = scr->back + r * scr->cols;
+        for (size_t c = 0; c < scr->cols; ++c) {
+            if (front[c].ch == back[c].ch && front[c].style == back[c].style) continue;
+
+            if (crow != r || ccol != c) {
+                int movelen;
+                if (crow == r && c > ccol) movelen = snprintf(seq, sizeof(seq), "\033[%zuC", c - ccol);
+                else movelen = snprintf(seq, sizeof(seq), "\033[%zu;%zuH", r + 1, c + 1);
+
+                // rewriting a short gap of unchanged cells is cheaper than moving the cursor
+                size_t gaplen = SIZE_MAX;
+                char gap[sizeof(seq) + 4];
+                if (crow == r && c > ccol) {
+                    size_t g;
+                    for (g = ccol, gaplen = 0; g < c && gaplen <= (size_t) movelen; ++g) {
+                        if (back[g].style != style) break;
+                        gaplen += _screen_cell_bytes(back + g, gap + gaplen);
+                    }
+                    if (g < c) gaplen = SIZE_MAX;
+                }
+                if (gaplen <= (size_t) movelen) ok &= _screen_emit(scr, gap, gaplen);
+                else ok &= _screen_emit(scr, seq, movelen);
+            }
+
+            if (back[c].style != style) {
+                style = back[c].style;
+                ok &= _screen_emit(scr, _screen_style_seq[style], strlen(_screen_style_seq[style]));
+            }
+            size_t n = _screen_cell_bytes(back + c, seq);
+            ok &= _screen_emit(scr, seq, n);
+            front[c] = back[c];
+
+            crow = r;
+            ccol = c + 1;
+            // the cursor position after writing the last column depends on the terminal
+            if (ccol == scr->cols) crow = SIZE_MAX;
+        }
+    }
+
+    if (style != SCREEN_DEFAULT) ok &= _screen_emit(scr, COL_RESET, strlen(COL_RESET));
+    scr->cur_row = crow;
+    scr->cur_col = ccol;
+    if (!ok) screen_invalidate(scr);
+    return ok;
+}
+
+bool screen_render(screen *scr, char **destbuf) {
+    if (!_screen_diff(scr)) return false;
+    if (scr->out_len == 0) return true;
+    if (!strbuf_append_strn(destbuf, scr->out, scr->out_len)) {
+        screen_invalidate(scr);
+        return false;
+    }
+    return true;
+}
+
+bool screen_flush(screen *scr, int fd) {
+    if (!_screen_diff(scr)) return false;
+
+    size_t done = 0;
+    while (done < scr->out_len) {
+        ssize_t n = write(fd, scr->out + done, scr->out_len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            screen_invalidate(scr);
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains the declarations of the operation counters of the library. If the macro `CLZ_STATS`
+ * is defined (typically with `-DCLZ_STATS` for the whole program), every public function of @ref strbuf.h,
+ * @ref dynarray.h and @ref logger.h keeps track of
+ *  - how many times it was called,
+ *  - how many heap allocations it made and how many bytes they requested,
+ *  - how many bytes it copied,
+ *  - how many times it grew a buffer and how much time was spent doing so.
+ *
+ * Allocations, copies and resizes are attributed to the function that performs them, not to the function the
+ * program called: `strbuf_insert_int` shows up as one call, while the allocations it causes are found under
+ * `strbuf_new_size` and `strbuf_resize`.
+ *
+ * The counters are kept per thread and are never synchronized, so they cost a few increments per call. If
+ * `CLZ_STATS` is not defined, the counting macros expand to nothing and the functions declared below report
+ * zeros.
+ *
+ * Example:
+ *
+ * @code
+ *     clz_stats before, after, diff;
+ *     clz_stats_snapshot(&before);
+ *     build_report();
+ *     clz_stats_snapshot(&after);
+ *     clz_stats_diff(&after, &before, &diff);
+ *
+ *     char *out = strbuf_new();
+ *     clz_stats_dump(&diff, &out, false);
+ *     fputs(out, stderr);
+ *     strbuf_free(out);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_STATS_IMPL` is defined beforehand. It has to be included
+ * exactly once in a program that defines `CLZ_STATS`, since it holds the thread-local counters.
+ *
+ * @file stats.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for the opt-in operation counters of the library
+ *
+ */
+
+#ifndef _CLZ_STATS_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_STATS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief List of the functions that are counted, as an X-macro.
+ */
+#define CLZ_STATS_FUNCTIONS(X) \
+    X(strbuf_new) X(strbuf_new_size) X(strbuf_new_str) X(strbuf_free) X(strbuf_clone) \
+    X(strbuf_alloc_size) X(strbuf_footprint) X(strbuf_resize) X(strbuf_compress) \
+    X(strbuf_length) X(strbuf_set_length) X(strbuf_is_binary) X(strbuf_make_binary) \
+    X(strbuf_append_char) X(strbuf_append_str) X(strbuf_append_strn) X(strbuf_append_bytes) \
+    X(strbuf_append_int) X(strbuf_append_uint) X(strbuf_append_long) X(strbuf_append_ulong) \
+    X(strbuf_append_llong) X(strbuf_append_ullong) \
+    X(strbuf_insert_char) X(strbuf_insert_str) X(strbuf_insert_strn) X(strbuf_insert_bytes) \
+    X(strbuf_insert_int) X(strbuf_insert_uint) X(strbuf_insert_long) X(strbuf_insert_ulong) \
+    X(strbuf_insert_llong) X(strbuf_insert_ullong) \
+    X(strbuf_trim_index) X(strbuf_trim_length) X(strbuf_trim_head) X(strbuf_trim_head_char) \
+    X(strbuf_trim_tail) X(strbuf_trim_tail_char) \
+    X(strbuf_padding_head) X(strbuf_padding_tail) \
+    X(strbuf_find_first_char) X(strbuf_find_last_char) X(strbuf_find_first_str) X(strbuf_find_last_str) \
+    X(strbuf_find_bytes) X(strbuf_memmem) \
+    X(strbuf_replace_first_char) X(strbuf_replace_all_char) X(strbuf_replace_first_str) X(strbuf_replace_all_str) \
+    X(strbuf_remove_char) X(strbuf_remove_str) \
+    X(strbuf_to_lowercase) X(strbuf_to_lowercase_l) X(strbuf_to_uppercase) X(strbuf_to_uppercase_l) \
+    X(strbuf_reverse) X(strbuf_strip_ansi) X(strbuf_display_width) X(strbuf_display_width_bytes) \
+    X(strbuf_padding_head_display) X(strbuf_padding_tail_display) X(strbuf_hash) \
+    X(strbuf_append_varint) X(strbuf_append_zigzag) X(strbuf_append_le) X(strbuf_append_be) X(strbuf_append_svb) \
+    X(strbuf_read_varint) X(strbuf_read_zigzag) X(strbuf_read_le) X(strbuf_read_be) X(strbuf_read_svb) \
+    X(dynarray_init) X(dynarray_new) X(dynarray_free) X(dynarray_append) X(dynarray_set) X(dynarray_get) \
+    X(dynarray_remove_first) X(dynarray_remove_all) X(dynarray_remove_index) X(dynarray_clear) \
+    X(dynarray_find_first) X(dynarray_find_next) \
+    X(dynarray_foreach) X(dynarray_foreach_if) X(dynarray_foreach_if_else) X(dynarray_pop) X(dynarray_footprint) \
+    X(logger_default) X(logger_new) X(logger_free) X(logger_log) X(logger_logf) \
+    X(logger_async_start) X(logger_async_stop) X(logger_async_try_log) X(logger_async_try_logn) \
+    X(logger_async_try_logf) X(logger_async_log) X(logger_async_on_space)
+
+#define _CLZ_STATS_ENUM(name) CLZ_STATS_FN_##name,
+
+/**
+ * @brief Definition of enum identifying the counted functions
+ *
+ * Every value is the name of the function prefixed with `CLZ_STATS_FN_`, for example `CLZ_STATS_FN_strbuf_resize`.
+ * `CLZ_STATS_FN_COUNT` is the number of counted functions.
+ */
+enum clz_stats_fn {
+    CLZ_STATS_FUNCTIONS(_CLZ_STATS_ENUM)
+    CLZ_STATS_FN_COUNT
+};
+
+/**
+ * @brief Definition of structure holding the counters of a single function
+ */
+typedef struct clz_stats_counters {
+    /**
+     * @brief Number of calls
+     */
+    uint64_t calls;
+    /**
+     * @brief Number of heap allocations (`malloc`, `calloc`, `realloc` and `strdup`)
+     */
+    uint64_t allocs;
+    /**
+     * @brief Number of bytes requested by the heap allocations
+     */
+    uint64_t bytes_allocated;
+    /**
+     * @brief Number of bytes copied or moved
+     */
+    uint64_t bytes_copied;
+    /**
+     * @brief Number of times a buffer was grown or shrunk
+     */
+    uint64_t resizes;
+    /**
+     * @brief Time spent resizing buffers, in nanoseconds
+     */
+    uint64_t resize_ns;
+} clz_stats_counters;
+
+/**
+ * @brief Definition of structure holding the counters of all the functions
+ *
+ * The counters of a function are found at the index given by @ref clz_stats_fn.
+ */
+typedef struct clz_stats {
+    /**
+     * @brief The counters, indexed by @ref clz_stats_fn
+     */
+    clz_stats_counters fn[CLZ_STATS_FN_COUNT];
+} clz_stats;
+
+/**
+ * @brief Copies the counters of the calling thread.
+ *
+ * @param out The destination
+ *
+ * @see clz_stats_diff, clz_stats_reset
+ */
+void clz_stats_snapshot(clz_stats *out);
+/**
+ * @brief Computes the difference between two snapshots.
+ *
+ * This function stores `after - before` for every counter in `out`, which may be the same as either operand.
+ *
+ * @param after The later snapshot
+ * @param before The earlier snapshot
+ * @param out The destination
+ *
+ * @see clz_stats_snapshot
+ */
+void clz_stats_diff(clz_stats *after, clz_stats *before, clz_stats *out);
+/**
+ * @brief Resets the counters of the calling thread to zero.
+ *
+ * @see clz_stats_snapshot
+ */
+void clz_stats_reset();
+/**
+ * @brief Returns the name of a counted function
+ *
+ * @param fn The function
+ * @return The name, or `"invalid"`
+ */
+const char *clz_stats_name(enum clz_stats_fn fn);
+/**
+ * @brief Appends the counters to a strbuf in human-readable or JSON form.
+ *
+ * Functions whose counters are all zero are omitted. In text form, a header line is followed by one line per
+ * function. In JSON form, a single object maps every function name to an object holding its counters, e.g.
+ *
+ *     {"strbuf_resize":{"calls":2,"allocs":2,"bytes_allocated":208,"bytes_copied":70,"resizes":2,"resize_ns":312}}
+ *
+ * This function requires the implementation of @ref strbuf.h. Since heap allocation is used, failure is possible,
+ * in which case `false` is returned and the buffer may hold a partial dump.
+ *
+ * @param stats The counters
+ * @param destbuf The destination buffer
+ * @param json Whether to emit JSON instead of text
+ * @return `true` if successful
+ */
+bool clz_stats_dump(clz_stats *stats, char **destbuf, bool json);
+
+/**
+ * @brief The counters of the calling thread. Use the API above instead of accessing this directly.
+ */
+#ifdef __cplusplus
+extern thread_local clz_stats _clz_stats_tls;
+#else
+extern _Thread_local clz_stats _clz_stats_tls;
+#endif
+
+uint64_t _clz_stats_now();
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef CLZ_STATS
+
+/**
+ * @brief Counts a call of the function `name`
+ */
+#define CLZ_STATS_CALL(name) (_clz_stats_tls.fn[CLZ_STATS_FN_##name].calls++)
+/**
+ * @brief Counts a heap allocation of `n` bytes made by the function `name`
+ */
+#define CLZ_STATS_ALLOC(name, n) \
+    (_clz_stats_tls.fn[CLZ_STATS_FN_##name].allocs++, \
+     _clz_stats_tls.fn[CLZ_STATS_FN_##name].bytes_allocated += (n))
+/**
+ * @brief Counts `n` bytes copied by the function `name`
+ */
+#define CLZ_STATS_COPY(name, n) (_clz_stats_tls.fn[CLZ_STATS_FN_##name].bytes_copied += (n))
+/**
+ * @brief Starts timing a resize. Must be followed by @ref CLZ_STATS_RESIZE_END in the same block.
+ */
+#define CLZ_STATS_RESIZE_BEGIN(name) uint64_t _clz_stats_t0_##name = _clz_stats_now()
+/**
+ * @brief Counts a resize made by the function `name`, timed since @ref CLZ_STATS_RESIZE_BEGIN
+ */
+#define CLZ_STATS_RESIZE_END(name) \
+    (_clz_stats_tls.fn[CLZ_STATS_FN_##name].resizes++, \
+     _clz_stats_tls.fn[CLZ_STATS_FN_##name].resize_ns += _clz_stats_now() - _clz_stats_t0_##name)
+
+#else
+
+#define CLZ_STATS_CALL(name) ((void) 0)
+#define CLZ_STATS_ALLOC(name, n) ((void) 0)
+#define CLZ_STATS_COPY(name, n) ((void) 0)
+#define CLZ_STATS_RESIZE_BEGIN(name) ((void) 0)
+#define CLZ_STATS_RESIZE_END(name) ((void) 0)
+
+#endif
+
+#endif
+
+#ifdef CLZ_STATS_IMPL
+#undef CLZ_STATS_IMPL
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// the implementation of strbuf.h depends on both headers
+#include "footprint.h"
+#include "strbuf.h"
+
+_Thread_local clz_stats _clz_stats_tls;
+
+#define _CLZ_STATS_NAME(name) #name,
+
+static const char *_clz_stats_names[] = {
+    CLZ_STATS_FUNCTIONS(_CLZ_STATS_NAME)
+};
+
+uint64_t _clz_stats_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void clz_stats_snapshot(clz_stats *out) {
+    *out = _clz_stats_tls;
+}
+
+void clz_stats_diff(clz_stats *after, clz_stats *before, clz_stats *out) {
+    for (size_t i = 0; i < CLZ_STATS_FN_COUNT; ++i) {
+        out->fn[i].calls = after->fn[i].calls - before->fn[i].calls;
+        out->fn[i].allocs = after->fn[i].allocs - before->fn[i].allocs;
+        out->fn[i].bytes_allocated = after->fn[i].bytes_allocated - before->fn[i].bytes_allocated;
+        out->fn[i].bytes_copied = after->fn[i].bytes_copied - before->fn[i].bytes_copied;
+        out->fn[i].resizes = after->fn[i].resizes - before->fn[i].resizes;
+        out->fn[i].resize_ns = after->fn[i].resize_ns - before->fn[i].resize_ns;
+    }
+}
+
+void clz_stats_reset() {
+    memset(&_clz_stats_tls, 0, sizeof(_clz_stats_tls));
+}
+
+const char *clz_stats_name(enum clz_stats_fn fn) {
+    if ((size_t) fn >= CLZ_STATS_FN_COUNT) return "invalid";
+    return _clz_stats_names[fn];
+}
+
+bool clz_stats_dump(clz_stats *stats, char **destbuf, bool json) {
+    // the counters are copied first so that dumping the live counters does not count itself
+    clz_stats cpy = *stats;
+    char line[256];
+    bool first = true, ok = true;
+
+    if (json) ok &= strbuf_append_char(destbuf, '{');
+    else {
+        snprintf(line, sizeof(line), "%-30s %12s %12s %16s %16s %10s %14s\n",
+                 "function", "calls", "allocs", "bytes_allocated", "bytes_copied", "resizes", "resize_ns");
+        ok &= strbuf_append_str(destbuf, line);
+    }
+
+    for (size_t i = 0; i < CLZ_STATS_FN_COUNT; ++i) {
+        clz_stats_counters *c = cpy.fn + i;
+        if (!(c->calls || c->allocs || c->bytes_allocated || c->bytes_copied || c->resizes || c->resize_ns))
+            continue;
+
+        if (json) {
+            snprintf(line, sizeof(line), "%s\"%s\":{\"calls\":%llu,\"allocs\":%llu,\"bytes_allocated\":%llu,"
+                     "\"bytes_copied\":%llu,\"resizes\":%llu,\"resize_ns\":%llu}",
+                     first ? "" : ",", _clz_stats_names[i],
+                     (unsigned long long) c->calls, (unsigned long long) c->allocs,
+                     (unsigned long long) c->bytes_allocated, (unsigned long long) c->bytes_copied,
+                     (unsigned long long) c->resizes, (unsigned long long) c->resize_ns);
+        } else {
+            snprintf(line, sizeof(line), "%-30s %12llu %12llu %16llu %16llu %10llu %14llu\n", _clz_stats_names[i],
+                     (unsigned long long) c->calls, (unsigned long long) c->allocs,
+                     (unsigned long long) c->bytes_allocated, (unsigned long long) c->bytes_copied,
+                     (unsigned long long) c->resizes, (unsigned long long) c->resize_ns);
+        }
+        ok &= strbuf_append_str(destbuf, line);
+        first = false;
+    }
+
+    if (json) ok &= strbuf_append_char(destbuf, '}');
+    return ok;
+}
+
+#endif
@@ -40,17 +40,24 @@
  * the buffer size. While the full buffer size can be checked with @ref strbuf_alloc_size, it is still
  * something that has to be avoided.
  *
+ * A buffer is either in text mode, the default, or in binary mode. In text mode the data ends at the first null byte,
+ * so the buffer may be written to directly like any C-string. In binary mode the length is stored with the buffer,
+ * which makes it safe for data containing null bytes (compressed blocks, protocol buffers, ...) and spares every
+ * function the `strlen`. See @ref strbuf_make_binary and @ref strbuf_append_bytes.
+ *
  * Because of the allcoation and re-allocation being done behind the scene, **any parameter called** `strbuf`,
  * `destbuf` or anything containing the three letters ` buf` **must** be a proper buffer allocated by @ref strbuf_new
  * and/or @ref strbuf_new_size. This rule should be enforced with an iron fist, because strbufs are prefixed
- * with information about the allocation size that regular C-strings do not have. What this implies is that
- * passing such C-strings off as buffers will result in undefined behavior the moment the buffer size is
+ * with information about the allocation size and length that regular C-strings do not have. What this implies
+ * is that passing such C-strings off as buffers will result in undefined behavior the moment the buffer size is
  * supposed to be retrieved or the buffer is meant to be `realloc`'d.
  *
  * **Implementation**
  *
  * The implementation can be included if the macro `CLZ_STRBUF_IMPL` is defined beforehand. Some functionalities
  * are implemented as macros for performance reasons.
+ * If the macro `CLZ_STATIC_INLINE` is defined, the implementation is always included and the functions are
+ * `static inline`, see @ref CLZ_API.
  *
  * @file strbuf.h
  * @author Lorenzo Calza
@@ -68,10 +75,15 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <ctype.h>
 
 #include "clz.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Allocates a new `strbuf` with default size
  *
@@ -94,7 +106,7 @@
  * @return The allocated buffer
  * @see strbuf_new_size, strbuf_free
  */
-char *strbuf_new();
+CLZ_API char *strbuf_new();
 
 /**
  * @brief Allocates a new `strbuf` with the specified minimum size
@@ -120,7 +132,7 @@ char *strbuf_new();
  * @return The allocated buffer
  * @see strbuf_new, strbuf_free
  */
-char *strbuf_new_size(size_t sz);
+CLZ_API char *strbuf_new_size(size_t sz);
 /**
  * @brief Creates a string buffer with the contents of the given C-string.
  *
@@ -136,22 +148,59 @@ char *strbuf_new_size(size_t sz);
  * @param s The string to copy over
  * @return the new buffer
  *
- * @see strbuf_clone, strbuf_free
+ * @see strbuf_clone, strbuf_free, STRBUF_LITERAL
+ */
+CLZ_API char *strbuf_new_str(char *s);
+/**
+ * @brief Creates a read-only string buffer from a string literal, without any allocation
+ *
+ * The buffer, including its hidden header, is built at compile time in static read-only memory, with an allocation
+ * size of `0` marking it as such. It can be passed to all functions of @ref strbuf.h. Functions only reading the
+ * buffer use it directly, while functions modifying it first copy it to the heap and update the pointer, as
+ * @ref strbuf_resize does. @ref strbuf_free does nothing on such a buffer, so a variable holding either a literal
+ * or a modified copy can always be freed.
+ *
+ * This makes constant keys and default values free, where @ref strbuf_new_str would allocate and copy each one.
+ *
+ * @code
+ * char *name = STRBUF_LITERAL("anonymous"); // no allocation
+ * if (user) strbuf_append_str(&name, user); // copied to the heap here
+ * strbuf_free(name);
+ * @endcode
+ *
+ * **Notes**
+ *
+ * The argument must be a string literal. With GCC and Clang, the buffer lives as long as the program. With other
+ * compilers, it is a compound literal which lives until the end of the enclosing block.
+ *
+ * @param s The string literal
+ * @return The read-only buffer
+ *
+ * @see strbuf_new_str, strbuf_free
  */
-char *strbuf_new_str(char *s);
+#if defined(__GNUC__) || defined(__clang__)
+#define STRBUF_LITERAL(s) (__extension__ ({                                                       \
+    static const struct { size_t len; size_t alloc; char data[sizeof(s)]; } _strbuf_literal = \
+        {(size_t) -1, 0, s};                                                                  \
+    (char *) _strbuf_literal.data;                                                            \
+}))
+#else
+#define STRBUF_LITERAL(s) \
+    ((char *) (const struct { size_t len; size_t alloc; char data[sizeof(s)]; }) {(size_t) -1, 0, s}.data)
+#endif
 /**
  * @brief Frees previously allocated `strbuf`.
  *
  * This function frees a buffer previously allocated with @ref strbuf_new or @ref strbuf_new_size.
  * Attempts to free regular pointers with this function will fail and crash the program (standard behavior
- * for attempts call `free(...)` on invalid pointers.
+ * for attempts call `free(...)` on invalid pointers. Buffers made with @ref STRBUF_LITERAL are left as they are.
  *
  * Should the dynamic allocation fail, then `NULL` is returned.
  *
  * @return the allocated buffer
  * @see strbuf_new_size, strbuf_free
  */
-void strbuf_free(char *strbuf);
+CLZ_API void strbuf_free(char *strbuf);
 /**
  * @brief Clones a buffer
  *
@@ -185,7 +234,7 @@ void strbuf_free(char *strbuf);
  *
  * @see strbuf_new, strbuf_free, strbuf_alloc_size, strbuf_new_str
  */
-char *strbuf_clone(char *strbuf, bool bufsz);
+CLZ_API char *strbuf_clone(char *strbuf, bool bufsz);
 
 /**
  * @brief Returns buffer size
@@ -197,10 +246,76 @@ char *strbuf_clone(char *strbuf, bool bufsz);
  * a mistake, but still one of the (few) exceptions and the programmer should be mindful not to pass a
  * double pointer by mistake. Nevertheless, `strbuf` **must** be a proper buffer and not just a regular C-string.
  *
+ * The size of a buffer made with @ref STRBUF_LITERAL is `0`.
+ *
  * @param strbuf The buffer
  * @return The buffer size
  */
-size_t strbuf_alloc_size(char *strbuf);
+CLZ_API CLZ_HOT size_t strbuf_alloc_size(char *strbuf);
+/**
+ * @brief Returns the heap memory held by the buffer
+ *
+ * The reserved bytes are the allocation size plus the hidden header holding it, the used bytes are the string
+ * length plus the null-terminator and the header. As with @ref strbuf_alloc_size, `strbuf` **must** be a proper
+ * buffer and not just a regular C-string. A buffer made with @ref STRBUF_LITERAL holds no heap memory.
+ *
+ * @param strbuf The buffer
+ * @return The footprint of the buffer
+ *
+ * @see strbuf_alloc_size, clz_footprint
+ */
+CLZ_API clz_footprint strbuf_footprint(char *strbuf);
+/**
+ * @brief Returns the length of the string or binary data
+ *
+ * In binary mode, the stored length is returned, otherwise `strlen(strbuf)`. As with @ref strbuf_alloc_size,
+ * this function takes a `char *strbuf` and `strbuf` **must** be a proper buffer.
+ *
+ * @param strbuf The buffer
+ * @return The number of bytes in the buffer, not counting the null-terminator
+ *
+ * @see strbuf_set_length, strbuf_make_binary
+ */
+CLZ_API CLZ_HOT size_t strbuf_length(char *strbuf);
+/**
+ * @brief Sets the length of the data and writes the null-terminator after it.
+ *
+ * This function is meant for code that writes to the buffer directly, e.g. with `read(2)` or `sprintf`. In binary
+ * mode the length is stored, in text mode only the null-terminator is written. If `len` does not leave room for
+ * the null-terminator within @ref strbuf_alloc_size, nothing happens and `false` is returned.
+ *
+ * @param destbuf The buffer
+ * @param len The new length
+ * @return `true` if successful
+ *
+ * @see strbuf_length, strbuf_make_binary
+ */
+CLZ_API bool strbuf_set_length(char **destbuf, size_t len);
+/**
+ * @brief Returns whether the buffer is in binary mode, see @ref strbuf_make_binary
+ *
+ * @param strbuf The buffer
+ * @return `true` if the length of the buffer is stored
+ */
+CLZ_API bool strbuf_is_binary(char *strbuf);
+/**
+ * @brief Switches the buffer to binary mode.
+ *
+ * A new buffer is in text mode: its data ends at the first null byte and every function measures it with `strlen`.
+ * In binary mode, the length is stored in the header of the buffer, the data may contain null bytes and no
+ * function scans for the null-terminator anymore, which also saves the `strlen` of every append. A null-terminator
+ * is still kept after the data, so a buffer holding text can be used as a C-string in either mode.
+ *
+ * The current length is taken with `strlen`. If the buffer is already in binary mode, nothing happens. There is no
+ * way back: code writing to a binary buffer directly has to call @ref strbuf_set_length afterwards, or the
+ * new data is ignored by all other functions. The binary functions, such as @ref strbuf_append_bytes or
+ * @ref strbuf_append_varint, switch the buffer to binary mode themselves. @ref strbuf_clone keeps the mode.
+ *
+ * @param destbuf The buffer
+ *
+ * @see strbuf_is_binary, strbuf_length, strbuf_set_length
+ */
+CLZ_API void strbuf_make_binary(char **destbuf);
 /**
  * @brief Resizes buffer using `realloc`
  *
@@ -217,9 +332,12 @@ size_t strbuf_alloc_size(char *strbuf);
  *
  * Additionally, it should be noted that `minsize` should be greater than or equal to @ref CLZ_ALLOC_SIZE. If
  * it is smaller than that, `minsize` will be redefined to @ref CLZ_STRBUF_ALLOC in order to ensure consistency
- * with @ref strbuf_new_size. If `strlen(strbuf) + 1 > minsize` (aka. the min. size is too small to hold the string)
+ * with @ref strbuf_new_size. If `strbuf_length(strbuf) + 1 > minsize` (aka. the min. size is too small to hold the string)
  * `minsize` is silently reassigned to `strlen(strbuf) + 1`.
  *
+ * A buffer made with @ref STRBUF_LITERAL is copied to the heap and left in place, which is how all functions
+ * modifying a buffer copy it on their first write.
+ *
  * **Notes**
  *
  * Since use of `realloc` is made, it is possible that the dynamic allocation fails. In this case, the buffer
@@ -231,7 +349,7 @@ size_t strbuf_alloc_size(char *strbuf);
  *
  * @see strbuf_compress, strbuf_alloc_size, strbuf_trim_length
  */
-bool strbuf_resize(char **dest, size_t minsize);
+CLZ_API bool strbuf_resize(char **dest, size_t minsize);
 /**
  * @brief Resizes buffer to its minimum size
  *
@@ -249,7 +367,7 @@ bool strbuf_resize(char **dest, size_t minsize);
  *
  * @see strbuf_resize, strbuf_alloc_size, strbuf_trim_length
  */
-bool strbuf_compress(char **dest);
+CLZ_API CLZ_COLD bool strbuf_compress(char **dest);
 
 /**
  * @brief Appends a `char` to a strbuf
@@ -264,7 +382,7 @@ bool strbuf_compress(char **dest);
  *
  * @see strbuf_append_str
  */
-bool strbuf_append_char(char **destbuf, char c);
+CLZ_API CLZ_HOT bool strbuf_append_char(char **destbuf, char c);
 /**
  * @brief Appends a string to a strbuf
  *
@@ -281,7 +399,7 @@ bool strbuf_append_char(char **destbuf, char c);
  *
  * @see strbuf_append_char, strbuf_append_strn
  */
-bool strbuf_append_str(char **destbuf, char *src);
+CLZ_API CLZ_HOT bool strbuf_append_str(char **destbuf, char *src);
 /**
  * @brief Appends at most the first `n` characters of a string to a strbuf
  *
@@ -301,7 +419,25 @@ bool strbuf_append_str(char **destbuf, char *src);
  *
  * @see strbuf_append_char, strbuf_append_str
  */
-bool strbuf_append_strn(char **destbuf, char *src, size_t n);
+CLZ_API CLZ_HOT bool strbuf_append_strn(char **destbuf, char *src, size_t n);
+/**
+ * @brief Appends `n` bytes to a strbuf
+ *
+ * This function copies `n` bytes from `src` after the end of the buffer with `memcpy`, null bytes included, and
+ * switches the buffer to binary mode (see @ref strbuf_make_binary). Neither the buffer nor `src` are scanned for
+ * a null-terminator.
+ *
+ * If the buffer is too small, it will be `realloc`'d. In case the heap allocation fails, `false` is returned,
+ * otherwise `true`. `src` must not point into the buffer itself.
+ *
+ * @param destbuf The destination buffer
+ * @param src The bytes to append
+ * @param n The number of bytes
+ * @return `true` if successful
+ *
+ * @see strbuf_insert_bytes, strbuf_find_bytes
+ */
+CLZ_API CLZ_HOT bool strbuf_append_bytes(char **destbuf, const void *src, size_t n);
 /**
  * @brief Appends an `int` to a strbuf in decimal notation
  *
@@ -316,7 +452,7 @@ bool strbuf_append_strn(char **destbuf, char *src, size_t n);
  *
  * @see strbuf_append_char, strbuf_append_uint, strbuf_append_long
  */
-bool strbuf_append_int(char **destbuf, int i);
+CLZ_API bool strbuf_append_int(char **destbuf, int i);
 /**
  * @brief Appends an `unsigned int` to a strbuf in decimal notation
  *
@@ -331,7 +467,7 @@ bool strbuf_append_int(char **destbuf, int i);
  *
  * @see strbuf_append_char, strbuf_append_int, strbuf_append_long
  */
-bool strbuf_append_uint(char **destbuf, unsigned int i);
+CLZ_API bool strbuf_append_uint(char **destbuf, unsigned int i);
 /**
  * @brief Appends a `long` to a strbuf in decimal notation
  *
@@ -346,7 +482,7 @@ bool strbuf_append_uint(char **destbuf, unsigned int i);
  *
  * @see strbuf_append_int, strbuf_append_ulong, strbuf_append_llong, strbuf_append_ullong
  */
-bool strbuf_append_long(char **destbuf, long l);
+CLZ_API bool strbuf_append_long(char **destbuf, long l);
 /**
  * @brief Appends an `unsigned long` to a strbuf in decimal notation
  *
@@ -361,7 +497,7 @@ bool strbuf_append_long(char **destbuf, long l);
  *
  * @see strbuf_append_int, strbuf_append_long, strbuf_append_llong, strbuf_append_ullong
  */
-bool strbuf_append_ulong(char **destbuf, unsigned long l);
+CLZ_API bool strbuf_append_ulong(char **destbuf, unsigned long l);
 /**
  * @brief Appends a `long long` to a strbuf in decimal notation
  *
@@ -376,7 +512,7 @@ bool strbuf_append_ulong(char **destbuf, unsigned long l);
  *
  * @see strbuf_append_int, strbuf_append_long, strbuf_append_ullong
  */
-bool strbuf_append_llong(char **destbuf, long  long l);
+CLZ_API bool strbuf_append_llong(char **destbuf, long  long l);
 /**
  * @brief Appends a `unsigned long long` to a strbuf in decimal notation
  *
@@ -391,7 +527,7 @@ bool strbuf_append_llong(char **destbuf, long  long l);
  *
  * @see strbuf_append_int, strbuf_append_ulong, strbuf_append_llong
  */
-bool strbuf_append_ullong(char **destbuf, unsigned long long l);
+CLZ_API bool strbuf_append_ullong(char **destbuf, unsigned long long l);
 
 /**
  * @brief Inserts a `char` at the given position.
@@ -414,7 +550,7 @@ bool strbuf_append_ullong(char **destbuf, unsigned long long l);
  *
  * @see strbuf_insert_str
  */
-bool strbuf_insert_char(char **destbuf, char c, size_t index);
+CLZ_API bool strbuf_insert_char(char **destbuf, char c, size_t index);
 /**
  * @brief Inserts a string at the given position.
  *
@@ -443,7 +579,7 @@ bool strbuf_insert_char(char **destbuf, char c, size_t index);
  *
  * @see strbuf_insert_char, strbuf_insert_strn
  */
-bool strbuf_insert_str(char **destbuf, char *s, size_t index);
+CLZ_API bool strbuf_insert_str(char **destbuf, char *s, size_t index);
 /**
  * @brief Inserts at most the first `maxlen` characters of a string at the given position.
  *
@@ -476,7 +612,26 @@ bool strbuf_insert_str(char **destbuf, char *s, size_t index);
  *
  * @see strbuf_insert_char, strbuf_insert_str
  */
-bool strbuf_insert_strn(char **destbuf, char *s, size_t index, size_t maxlen);
+CLZ_API bool strbuf_insert_strn(char **destbuf, char *s, size_t index, size_t maxlen);
+/**
+ * @brief Inserts `n` bytes into a strbuf at the given index
+ *
+ * This function moves the data from `index` on back by `n` bytes with `memmove` and copies `n` bytes from `src`
+ * into the gap, null bytes included. Like @ref strbuf_append_bytes, it switches the buffer to binary mode.
+ *
+ * If `index` is greater than @ref strbuf_length, nothing will happen and `false` will be returned. `false` is also
+ * returned if the heap allocation fails, check `errno` for `ENOMEM` to tell the two apart. `src` must not point
+ * into the buffer itself.
+ *
+ * @param destbuf The destination buffer
+ * @param src The bytes to insert
+ * @param index The position of the insertion
+ * @param n The number of bytes
+ * @return `true` if successful
+ *
+ * @see strbuf_append_bytes, strbuf_insert_strn
+ */
+CLZ_API bool strbuf_insert_bytes(char **destbuf, const void *src, size_t index, size_t n);
 /**
  * @brief Inserts an `int` at the given position.
  *
@@ -498,7 +653,7 @@ bool strbuf_insert_strn(char **destbuf, char *s, size_t index, size_t maxlen);
  *
  * @see strbuf_insert_uint, strbuf_insert_long
  */
-bool strbuf_insert_int(char **destbuf, int i, size_t index);
+CLZ_API bool strbuf_insert_int(char **destbuf, int i, size_t index);
 /**
  * @brief Inserts an `unsigned int` at the given position.
  *
@@ -520,7 +675,7 @@ bool strbuf_insert_int(char **destbuf, int i, size_t index);
  *
  * @see strbuf_insert_int, strbuf_insert_ulong
  */
-bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index);
+CLZ_API bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index);
 /**
  * @brief Inserts an `long` at the given position.
  *
@@ -542,7 +697,7 @@ bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index);
  *
  * @see strbuf_insert_int, strbuf_insert_ulong
  */
-bool strbuf_insert_long(char **destbuf, long l, size_t index);
+CLZ_API bool strbuf_insert_long(char **destbuf, long l, size_t index);
 /**
  * @brief Inserts an `unsigned long` at the given position.
  *
@@ -564,7 +719,7 @@ bool strbuf_insert_long(char **destbuf, long l, size_t index);
  *
  * @see strbuf_insert_long, strbuf_insert_ullong
  */
-bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index);
+CLZ_API bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index);
 /**
  * @brief Inserts an `long long` at the given position.
  *
@@ -586,7 +741,7 @@ bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index);
  *
  * @see strbuf_insert_long, strbuf_insert_ullong
  */
-bool strbuf_insert_llong(char **destbuf, long long l, size_t index);
+CLZ_API bool strbuf_insert_llong(char **destbuf, long long l, size_t index);
 /**
  * @brief Inserts an `unsigned long long` at the given position.
  *
@@ -608,7 +763,7 @@ bool strbuf_insert_llong(char **destbuf, long long l, size_t index);
  *
  * @see strbuf_insert_ulong, strbuf_insert_llong
  */
-bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index);
+CLZ_API bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index);
 
 /**
  * @brief Trims head and tail of the string within the buffer
@@ -633,7 +788,7 @@ bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index);
  *
  * @see strbuf_trim_length, strbuf_compress, strbuf_remove_str
  */
-void strbuf_trim_index(char **destbuf, size_t start, size_t end);
+CLZ_API void strbuf_trim_index(char **destbuf, size_t start, size_t end);
 /**
  * @brief Trims the contents past a certain length.
  *
@@ -653,7 +808,7 @@ void strbuf_trim_index(char **destbuf, size_t start, size_t end);
  *
  * @see strbuf_trim_index, strbuf_compress
  */
-void strbuf_trim_length(char **destbuf, size_t length);
+CLZ_API void strbuf_trim_length(char **destbuf, size_t length);
 /**
  * @brief Trim leading spaces.
  *
@@ -671,7 +826,7 @@ void strbuf_trim_length(char **destbuf, size_t length);
  *
  * @see strbuf_trim_head_char, strbuf_trim_tail, strbuf_compress
  */
-void strbuf_trim_head(char **destbuf);
+CLZ_API void strbuf_trim_head(char **destbuf);
 /**
  * @brief Trim leading instances of a given `char`.
  *
@@ -685,7 +840,7 @@ void strbuf_trim_head(char **destbuf);
  *
  * @see strbuf_trim_head, strbuf_trim_tail_char, strbuf_compress
  */
-void strbuf_trim_head_char(char **destbuf, char c);
+CLZ_API void strbuf_trim_head_char(char **destbuf, char c);
 /**
  * @brief Trim trailing spaces.
  *
@@ -703,7 +858,7 @@ void strbuf_trim_head_char(char **destbuf, char c);
  *
  * @see strbuf_trim_tail_char, strbuf_trim_head, strbuf_compress
  */
-void strbuf_trim_tail(char **destbuf);
+CLZ_API void strbuf_trim_tail(char **destbuf);
 /**
  * @brief Trim trailing instances of a given `char`.
  *
@@ -717,7 +872,7 @@ void strbuf_trim_tail(char **destbuf);
  *
  * @see strbuf_trim_tail, strbuf_trim_head_char, strbuf_compress
  */
-void strbuf_trim_tail_char(char **destbuf, char c);
+CLZ_API void strbuf_trim_tail_char(char **destbuf, char c);
 
 /**
  * @brief Pads the head of the string with a given `char`.
@@ -736,7 +891,7 @@ void strbuf_trim_tail_char(char **destbuf, char c);
  *
  * @see strbuf_padding_tail
  */
-bool strbuf_padding_head(char **destbuf, char c, size_t sz);
+CLZ_API bool strbuf_padding_head(char **destbuf, char c, size_t sz);
 /**
  * @brief Pads the tail of the string with a given `char`.
  *
@@ -756,7 +911,7 @@ bool strbuf_padding_head(char **destbuf, char c, size_t sz);
  *
  * @see strbuf_padding_head
  */
-bool strbuf_padding_tail(char **destbuf, char c, size_t sz);
+CLZ_API bool strbuf_padding_tail(char **destbuf, char c, size_t sz);
 
 /**
  * @brief Finds the first instance of the given `char`.
@@ -772,7 +927,7 @@ bool strbuf_padding_tail(char **destbuf, char c, size_t sz);
  *
  * @see strbuf_find_last_char
  */
-int strbuf_find_first_char(char **destbuf, char c);
+CLZ_API int strbuf_find_first_char(char **destbuf, char c);
 
 /**
  * @brief Finds the last instance of the given `char`.
@@ -788,7 +943,7 @@ int strbuf_find_first_char(char **destbuf, char c);
  *
  * @see strbuf_find_first_char
  */
-int strbuf_find_last_char(char **destbuf, char c);
+CLZ_API int strbuf_find_last_char(char **destbuf, char c);
 /**
  * @brief Finds the first instance of the given substring.
  *
@@ -803,7 +958,7 @@ int strbuf_find_last_char(char **destbuf, char c);
  *
  * @see strbuf_find_last_str
  */
-int strbuf_find_first_str(char **destbuf, char *s);
+CLZ_API int strbuf_find_first_str(char **destbuf, char *s);
 /**
  * @brief Finds the last instance of the given substring.
  *
@@ -818,7 +973,40 @@ int strbuf_find_first_str(char **destbuf, char *s);
  *
  * @see strbuf_find_first_str
  */
-int strbuf_find_last_str(char **destbuf, char *s);
+CLZ_API int strbuf_find_last_str(char **destbuf, char *s);
+/**
+ * @brief Finds the first instance of `n` bytes at or after the position `from`.
+ *
+ * The needle may contain null bytes and the buffer is searched up to @ref strbuf_length with @ref strbuf_memmem.
+ * An empty needle is found at `from`. If the needle is not found or `from` lies beyond the end of the data,
+ * @ref CLZ_NOT_FOUND is returned.
+ *
+ * @param destbuf The destination buffer (haystack)
+ * @param needle The bytes to find
+ * @param n The number of bytes in the needle
+ * @param from The position to start searching at
+ * @return the position if found
+ *
+ * @see strbuf_find_first_str, strbuf_append_bytes
+ */
+CLZ_API int strbuf_find_bytes(char **destbuf, const void *needle, size_t n, size_t from);
+/**
+ * @brief Finds the first instance of `n` bytes in a byte array.
+ *
+ * This is the substring search used by @ref strbuf_find_bytes, for data that is not a strbuf (a view, a memory
+ * mapped file, ...). On x86 processors, candidate positions are found 16 at a time by comparing both the first and
+ * the last byte of the needle with SSE2, and then compared with `memcmp`. Otherwise, the search skips to candidate
+ * positions with `memchr`. An empty needle is found at the start of the haystack.
+ *
+ * @param haystack The bytes to search
+ * @param hlen The number of bytes in the haystack
+ * @param needle The bytes to find
+ * @param n The number of bytes in the needle
+ * @return a pointer to the first instance within the haystack, or `NULL` if not found
+ *
+ * @see strbuf_find_bytes
+ */
+CLZ_API CLZ_HOT const char *strbuf_memmem(const void *haystack, size_t hlen, const void *needle, size_t n);
 
 /**
  * @brief Replaces the first instance of a `char`.
@@ -836,7 +1024,7 @@ int strbuf_find_last_str(char **destbuf, char *s);
  *
  * @see strbuf_replace_all_char, strbuf_replace_first_str
  */
-int strbuf_replace_first_char(char **destbuf, char c, char v);
+CLZ_API int strbuf_replace_first_char(char **destbuf, char c, char v);
 /**
  * @brief Replaces all instances of a `char`.
  *
@@ -850,7 +1038,7 @@ int strbuf_replace_first_char(char **destbuf, char c, char v);
  *
  * @see strbuf_replace_first_char, strbuf_replace_all_str
  */
-size_t strbuf_replace_all_char(char **destbuf, char c, char v);
+CLZ_API size_t strbuf_replace_all_char(char **destbuf, char c, char v);
 /**
  * @brief Replaces the given substring once.
  *
@@ -865,7 +1053,7 @@ size_t strbuf_replace_all_char(char **destbuf, char c, char v);
  *
  * @see strbuf_replace_all_str, strbuf_replace_first_char
  */
-int strbuf_replace_first_str(char **destbuf, char *s, char *t);
+CLZ_API int strbuf_replace_first_str(char **destbuf, char *s, char *t);
 /**
  * @brief Replaces all instances of a substring.
  *
@@ -879,7 +1067,7 @@ int strbuf_replace_first_str(char **destbuf, char *s, char *t);
  *
  * @see strbuf_replace_first_str, strbuf_replace_all_char
  */
-size_t strbuf_replace_all_str(char **destbuf, char *s, char *t);
+CLZ_API size_t strbuf_replace_all_str(char **destbuf, char *s, char *t);
 
 //size_t strbuf_split_char(char **destbuf, char **ptr, char c);
 
@@ -899,7 +1087,7 @@ size_t strbuf_replace_all_str(char **destbuf, char *s, char *t);
  *
  * @see strbuf_remove_str
  */
-bool strbuf_remove_char(char **destbuf, size_t index);
+CLZ_API bool strbuf_remove_char(char **destbuf, size_t index);
 /**
  * @brief Removes the given substring.
  *
@@ -922,7 +1110,7 @@ bool strbuf_remove_char(char **destbuf, size_t index);
  *
  * @see strbuf_remove_char, strbuf_trim_index
  */
-bool strbuf_remove_str(char **destbuf, size_t start, size_t end);
+CLZ_API bool strbuf_remove_str(char **destbuf, size_t start, size_t end);
 
 /**
  * @brief Reduces all alpha characters to lowercase.
@@ -934,7 +1122,7 @@ bool strbuf_remove_str(char **destbuf, size_t start, size_t end);
  *
  * @see strbuf_to_lowercase_l, strbuf_to_uppercase
  */
-void strbuf_to_lowercase(char **destbuf);
+CLZ_API void strbuf_to_lowercase(char **destbuf);
 /**
  * @brief Reduces all alpha characters to lowercase according to the given locale.
  *
@@ -946,7 +1134,7 @@ void strbuf_to_lowercase(char **destbuf);
  *
  * @see strbuf_to_lowercase_l, strbuf_to_uppercase
  */
-void strbuf_to_lowercase_l(char **destbuf, locale_t locale);
+CLZ_API void strbuf_to_lowercase_l(char **destbuf, locale_t locale);
 /**
  * @brief Reduces all alpha characters to uppercase.
  *
@@ -957,7 +1145,7 @@ void strbuf_to_lowercase_l(char **destbuf, locale_t locale);
  *
  * @see strbuf_to_uppercase_l, strbuf_to_lowercase
  */
-void strbuf_to_uppercase(char **destbuf);
+CLZ_API void strbuf_to_uppercase(char **destbuf);
 /**
  * @brief Reduces all alpha characters to uppercase according to the given locale.
  *
@@ -969,7 +1157,7 @@ void strbuf_to_uppercase(char **destbuf);
  *
  * @see strbuf_to_uppercase_l, strbuf_to_lowercase
  */
-void strbuf_to_uppercase_l(char **destbuf, locale_t locale);
+CLZ_API void strbuf_to_uppercase_l(char **destbuf, locale_t locale);
 /**
  * @brief Inverts the string.
  *
@@ -980,7 +1168,256 @@ void strbuf_to_uppercase_l(char **destbuf, locale_t locale);
  * @param destbuf The destination buffer
  * @return `true` on success
  */
-bool strbuf_reverse(char **destbuf);
+CLZ_API bool strbuf_reverse(char **destbuf);
+
+/**
+ * @brief Removes all ANSI escape sequences from the string.
+ *
+ * This function removes, in place, every escape sequence introduced by the `ESC` byte (see @ref COL_ESC),
+ * such as the color sequences defined in @ref color.h (`CSI` sequences like `"\033[0;31m"`), operating system
+ * commands terminated by `BEL` or `ESC \` and plain two-byte escapes. Everything else is left untouched.
+ *
+ * The search for the `ESC` byte is delegated to `memchr`, which is vectorized by the C library, so strings
+ * without (or with only a few) escape sequences are processed at memory speed. The buffer is never `realloc`'d.
+ *
+ * If an escape sequence is truncated by the end of the string, everything from the `ESC` byte onwards is removed.
+ *
+ * @param destbuf The destination buffer
+ * @return The number of bytes removed
+ *
+ * @see strbuf_display_width
+ */
+CLZ_API size_t strbuf_strip_ansi(char **destbuf);
+/**
+ * @brief Computes the width of the string as displayed by a terminal.
+ *
+ * This function returns the number of terminal columns the string occupies. Unlike `strlen`, it
+ *  - skips ANSI escape sequences entirely (see @ref strbuf_strip_ansi),
+ *  - decodes UTF-8 and counts each code point once,
+ *  - counts East Asian wide and fullwidth characters (CJK, Hangul, most emoji) as two columns,
+ *  - counts combining marks, zero-width characters and control characters as zero columns.
+ *
+ * Invalid UTF-8 bytes are counted as one column each, like the replacement character a terminal would show.
+ * Runs of printable ASCII are counted 8 bytes at a time.
+ *
+ * @param destbuf The destination buffer
+ * @return The display width in columns
+ *
+ * @see strbuf_strip_ansi, strbuf_padding_head_display, strbuf_padding_tail_display
+ */
+CLZ_API size_t strbuf_display_width(char **destbuf);
+/**
+ * @brief Computes the width of a range of bytes as displayed by a terminal.
+ *
+ * This function behaves like @ref strbuf_display_width, for bytes which need not belong to a strbuf, such as
+ * a @ref clz_view.
+ *
+ * @param s The bytes, which need not be null-terminated
+ * @param n The number of bytes
+ * @return The display width in columns
+ *
+ * @see strbuf_display_width
+ */
+CLZ_API size_t strbuf_display_width_bytes(const char *s, size_t n);
+/**
+ * @brief Pads the head of the string with a given `char` up to the given display width.
+ *
+ * This function behaves like @ref strbuf_padding_head, except that the width of the string is measured
+ * with @ref strbuf_display_width instead of `strlen`. This way colored strings and strings containing
+ * multi-byte or wide characters are aligned as they appear on the terminal. `c` is assumed to occupy
+ * a single column.
+ *
+ * If the display width is already greater than `width`, nothing will happen and `false` is returned.
+ * The buffer is `realloc`'d at most once. Since heap allocation is used, `false` can also indicate failure
+ * in that regard. Check `errno` for `ENOMEM` to account for that possibility.
+ *
+ * @param destbuf The destination buffer
+ * @param c The character to pad `destbuf` with
+ * @param width The final display width
+ * @return `true` if successful
+ *
+ * @see strbuf_padding_tail_display, strbuf_padding_head, strbuf_display_width
+ */
+CLZ_API bool strbuf_padding_head_display(char **destbuf, char c, size_t width);
+/**
+ * @brief Pads the tail of the string with a given `char` up to the given display width.
+ *
+ * This function behaves like @ref strbuf_padding_tail, except that the width of the string is measured
+ * with @ref strbuf_display_width instead of `strlen`. `c` is assumed to occupy a single column.
+ *
+ * If the display width is already greater than `width`, nothing will happen and `false` is returned.
+ * The buffer is `realloc`'d at most once. Since heap allocation is used, `false` can also indicate failure
+ * in that regard. Check `errno` for `ENOMEM` to account for that possibility.
+ *
+ * @param destbuf The destination buffer
+ * @param c The character to pad `destbuf` with
+ * @param width The final display width
+ * @return `true` if successful
+ *
+ * @see strbuf_padding_head_display, strbuf_padding_tail, strbuf_display_width
+ */
+CLZ_API bool strbuf_padding_tail_display(char **destbuf, char c, size_t width);
+/**
+ * @brief Computes the 64-bit FNV-1a hash of the string.
+ *
+ * The hash depends only on the bytes of the string, not on the buffer size, so equal strings always have equal
+ * hashes. It is cheap to compute but not collision resistant: do not use it on untrusted input where collisions
+ * could be provoked. The C++ function `clz::hash` in @ref clz.hpp computes the same value at compile time.
+ *
+ * @param destbuf The buffer
+ * @return The hash
+ *
+ * @see CLZ_FNV_OFFSET, CLZ_FNV_PRIME
+ */
+CLZ_API CLZ_HOT uint64_t strbuf_hash(char **destbuf);
+/**
+ * @brief Appends an unsigned integer in LEB128 varint encoding.
+ *
+ * Binary data may contain zero bytes, so the buffer is switched to binary mode first, see @ref strbuf_make_binary.
+ *
+ * Values are encoded in groups of 7 bits, least significant first, the high bit of every byte marking that
+ * another byte follows. Values below 128 take a single byte, 64-bit values up to 10 bytes.
+ *
+ * Since heap allocation may be used, failure is possible. In this case, `false` is returned and `errno` is set
+ * to `ENOMEM`.
+ *
+ * @param destbuf The destination buffer
+ * @param v The value
+ * @return `true` if successful
+ *
+ * @see strbuf_read_varint, strbuf_append_zigzag
+ */
+CLZ_API bool strbuf_append_varint(char **destbuf, uint64_t v);
+/**
+ * @brief Appends a signed integer in zigzag varint encoding.
+ *
+ * The value is mapped to an unsigned one with @ref strbuf_zigzag_encode, so that small negative values take as
+ * few bytes as small positive ones, and appended with @ref strbuf_append_varint.
+ *
+ * @param destbuf The destination buffer
+ * @param v The value
+ * @return `true` if successful
+ *
+ * @see strbuf_read_zigzag, strbuf_append_varint
+ */
+CLZ_API bool strbuf_append_zigzag(char **destbuf, int64_t v);
+/**
+ * @brief Appends the lowest `width` bytes of an integer in little-endian byte order.
+ *
+ * See @ref strbuf_append_varint on how binary data is appended. `width` must be between 1 and 8.
+ *
+ * @param destbuf The destination buffer
+ * @param v The value
+ * @param width The number of bytes
+ * @return `true` if successful, `false` if `width` is invalid or heap allocation failed
+ *
+ * @see strbuf_read_le, strbuf_append_be
+ */
+CLZ_API bool strbuf_append_le(char **destbuf, uint64_t v, size_t width);
+/**
+ * @brief Appends the lowest `width` bytes of an integer in big-endian (network) byte order.
+ *
+ * See @ref strbuf_append_varint on how binary data is appended. `width` must be between 1 and 8.
+ *
+ * @param destbuf The destination buffer
+ * @param v The value
+ * @param width The number of bytes
+ * @return `true` if successful, `false` if `width` is invalid or heap allocation failed
+ *
+ * @see strbuf_read_be, strbuf_append_le
+ */
+CLZ_API bool strbuf_append_be(char **destbuf, uint64_t v, size_t width);
+/**
+ * @brief Appends an array of 32-bit integers in Stream VByte encoding.
+ *
+ * The encoding consists of `(n + 3) / 4` control bytes, holding the byte length (1 to 4) of every value in 2 bits,
+ * followed by the values with their leading zero bytes stripped. Unlike LEB128, the lengths of four values are
+ * known from a single control byte, which lets @ref strbuf_read_svb decode four values with one shuffle instruction.
+ * The number of values is not stored and has to be known by the reader.
+ *
+ * See @ref strbuf_append_varint on how binary data is appended.
+ *
+ * @param destbuf The destination buffer
+ * @param values The values
+ * @param n The number of values
+ * @return `true` if successful
+ *
+ * @see strbuf_read_svb
+ */
+CLZ_API bool strbuf_append_svb(char **destbuf, const uint32_t *values, size_t n);
+/**
+ * @brief Reads an unsigned LEB128 varint.
+ *
+ * The varint is read at `*pos`, which is advanced past it. If the data ends before the varint does, or the varint
+ * is longer than 10 bytes or does not fit into 64 bits, `false` is returned and `*pos` is left untouched.
+ *
+ * @param destbuf The buffer
+ * @param pos The position to read at, advanced by the function
+ * @param out The destination of the value
+ * @return `true` if successful
+ *
+ * @see strbuf_append_varint
+ */
+CLZ_API bool strbuf_read_varint(char **destbuf, size_t *pos, uint64_t *out);
+/**
+ * @brief Reads a zigzag varint.
+ *
+ * Same as @ref strbuf_read_varint, followed by @ref strbuf_zigzag_decode.
+ *
+ * @param destbuf The buffer
+ * @param pos The position to read at, advanced by the function
+ * @param out The destination of the value
+ * @return `true` if successful
+ *
+ * @see strbuf_append_zigzag
+ */
+CLZ_API bool strbuf_read_zigzag(char **destbuf, size_t *pos, int64_t *out);
+/**
+ * @brief Reads a little-endian integer of `width` bytes.
+ *
+ * If `width` is not between 1 and 8 or the data ends before the integer does, `false` is returned and `*pos` is
+ * left untouched.
+ *
+ * @param destbuf The buffer
+ * @param pos The position to read at, advanced by the function
+ * @param width The number of bytes
+ * @param out The destination of the value
+ * @return `true` if successful
+ *
+ * @see strbuf_append_le
+ */
+CLZ_API bool strbuf_read_le(char **destbuf, size_t *pos, size_t width, uint64_t *out);
+/**
+ * @brief Reads a big-endian integer of `width` bytes.
+ *
+ * If `width` is not between 1 and 8 or the data ends before the integer does, `false` is returned and `*pos` is
+ * left untouched.
+ *
+ * @param destbuf The buffer
+ * @param pos The position to read at, advanced by the function
+ * @param width The number of bytes
+ * @param out The destination of the value
+ * @return `true` if successful
+ *
+ * @see strbuf_append_be
+ */
+CLZ_API bool strbuf_read_be(char **destbuf, size_t *pos, size_t width, uint64_t *out);
+/**
+ * @brief Reads `n` 32-bit integers in Stream VByte encoding.
+ *
+ * On x86 processors supporting SSSE3 (detected at runtime), four values are decoded at a time with a single
+ * `pshufb`, otherwise one at a time. If the data ends before the last value, `false` is returned and `*pos`
+ * is left untouched.
+ *
+ * @param destbuf The buffer
+ * @param pos The position to read at, advanced by the function
+ * @param out The destination of the values, at least `n` elements
+ * @param n The number of values
+ * @return `true` if successful
+ *
+ * @see strbuf_append_svb
+ */
+CLZ_API CLZ_HOT bool strbuf_read_svb(char **destbuf, size_t *pos, uint32_t *out, size_t n);
 
 /**
  * Macro defining the default (starting) size for a string buffer.
@@ -988,141 +1425,320 @@ bool strbuf_reverse(char **destbuf);
  */
 #define CLZ_STRBUF_ALLOC 32
 
+/**
+ * @brief Offset basis of the 64-bit FNV-1a hash, see @ref strbuf_hash
+ */
+#define CLZ_FNV_OFFSET 0xcbf29ce484222325ULL
+/**
+ * @brief Prime of the 64-bit FNV-1a hash, see @ref strbuf_hash
+ */
+#define CLZ_FNV_PRIME 0x100000001b3ULL
+
+/**
+ * @brief Maps a signed 64-bit integer to an unsigned one so that values of small magnitude stay small
+ *
+ * `0, -1, 1, -2, 2, ...` are mapped to `0, 1, 2, 3, 4, ...`.
+ */
+#define strbuf_zigzag_encode(v) (((uint64_t) (v) << 1) ^ (uint64_t) ((int64_t) (v) >> 63))
+/**
+ * @brief Inverse of @ref strbuf_zigzag_encode
+ */
+#define strbuf_zigzag_decode(u) ((int64_t) ((uint64_t) (u) >> 1) ^ -(int64_t) ((uint64_t) (u) & 1))
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "usdt.h"
+// included last, since the implementation of stats.h depends on the declarations above
+#include "stats.h"
+#include "footprint.h"
+
 #endif
 
-#ifdef CLZ_STRBUF_IMPL
+#if (defined(CLZ_STRBUF_IMPL) || defined(CLZ_STATIC_INLINE)) && !defined(_CLZ_STRBUF_IMPL_DONE)
 #undef CLZ_STRBUF_IMPL
+#define _CLZ_STRBUF_IMPL_DONE
 
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * The header in front of the data holds the stored length (or _STRBUF_TEXT in text mode) and the allocation size.
+ */
+#define _STRBUF_HEADER (2 * sizeof(size_t))
+#define _STRBUF_TEXT ((size_t) -1)
+#define _strbuf_stored_len(s) (((size_t *) (s))[-2])
+// buffers made with STRBUF_LITERAL have an allocation size of 0
+#define _strbuf_is_literal(s) (!((size_t *) (s))[-1])
+
+static inline size_t _strbuf_len(char *s) {
+    size_t len = _strbuf_stored_len(s);
+    return len == _STRBUF_TEXT ? strlen(s) : len;
+}
+
+static inline void _strbuf_set_len(char *s, size_t len) {
+    size_t *stored = (size_t *) s - 2;
+    if (*stored != _STRBUF_TEXT) {
+        CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_STRBUF, 0, 0, (int64_t) len - (int64_t) *stored);
+        *stored = len;
+    }
+    s[len] = '\0';
+}
+
+static inline void _strbuf_track(char *s, size_t len) {
+    // switches a buffer in text mode to binary mode, moving it to the totals that know its length
+    _strbuf_stored_len(s) = len;
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_STRBUF_TEXT, -1, -(int64_t) (strbuf_alloc_size(s) + _STRBUF_HEADER), 0);
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_STRBUF, 1, strbuf_alloc_size(s) + _STRBUF_HEADER, len + 1 + _STRBUF_HEADER);
+}
+
+static inline size_t _strbuf_binary(char *s) {
+    if (_strbuf_stored_len(s) == _STRBUF_TEXT) _strbuf_track(s, strlen(s));
+    return _strbuf_stored_len(s);
+}
+
+// copies a literal to the heap before its first modification
+static inline bool _strbuf_own(char **dest) {
+    return !_strbuf_is_literal(*dest) || strbuf_resize(dest, _strbuf_len(*dest) + 1);
+}
+
+static inline bool _strbuf_reserve(char **dest, size_t minsize) {
+    return strbuf_alloc_size(*dest) >= minsize || strbuf_resize(dest, minsize);
+}
+
+static bool _strbuf_append(char **dest, const void *src, size_t n) {
+    size_t len = _strbuf_len(*dest);
+    if (!_strbuf_reserve(dest, len + n + 1)) return false;
+    memcpy(*dest + len, src, n);
+    _strbuf_set_len(*dest, len + n);
+    return true;
+}
+
+static bool _strbuf_insert(char **dest, const void *src, size_t n, size_t index) {
+    size_t len = _strbuf_len(*dest);
+    if (index > len || !_strbuf_reserve(dest, len + n + 1)) return false;
+    memmove(*dest + index + n, *dest + index, len - index);
+    memcpy(*dest + index, src, n);
+    _strbuf_set_len(*dest, len + n);
+    return true;
+}
+
+static char *_strbuf_new_like(char *strbuf) {
+    // empty buffer of the same size and mode
+    char *newbuf = strbuf_new_size(strbuf_alloc_size(strbuf));
+    if (newbuf && _strbuf_stored_len(strbuf) != _STRBUF_TEXT) _strbuf_track(newbuf, 0);
+    return newbuf;
+}
+
+static const char *_strbuf_memmem(const char *h, size_t hlen, const char *n, size_t nlen) {
+    if (!nlen) return h;
+    if (nlen > hlen) return NULL;
+    if (nlen == 1) return memchr(h, n[0], hlen);
+    size_t last = hlen - nlen, i = 0;
+
+#ifdef __SSE2__
+    // positions where both the first and the last byte of the needle match
+    const __m128i first = _mm_set1_epi8(n[0]), end = _mm_set1_epi8(n[nlen - 1]);
+    for (; i + 16 <= last + 1; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (h + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (h + i + nlen - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, end)));
+        for (; mask; mask &= mask - 1) {
+            const char *p = h + i + __builtin_ctz(mask);
+            if (!memcmp(p + 1, n + 1, nlen - 2)) return p;
+        }
+    }
+#endif
+    for (const char *p = h + i, *lastp = h + last; p <= lastp; ++p) {
+        p = memchr(p, n[0], lastp - p + 1);
+        if (!p) return NULL;
+        if (p[nlen - 1] == n[nlen - 1] && !memcmp(p + 1, n + 1, nlen - 2)) return p;
+    }
+    return NULL;
+}
 
-size_t strbuf_alloc_size(char *strbuf) {
+CLZ_API size_t strbuf_alloc_size(char *strbuf) {
+    CLZ_STATS_CALL(strbuf_alloc_size);
     return *(((size_t *) strbuf) - 1);
 }
-char *strbuf_new() {
+
+CLZ_API size_t strbuf_length(char *strbuf) {
+    CLZ_STATS_CALL(strbuf_length);
+    return _strbuf_len(strbuf);
+}
+
+CLZ_API bool strbuf_set_length(char **destbuf, size_t len) {
+    CLZ_STATS_CALL(strbuf_set_length);
+    if (!_strbuf_own(destbuf) || len >= strbuf_alloc_size(*destbuf)) return false;
+    _strbuf_set_len(*destbuf, len);
+    return true;
+}
+
+CLZ_API bool strbuf_is_binary(char *strbuf) {
+    CLZ_STATS_CALL(strbuf_is_binary);
+    return _strbuf_stored_len(strbuf) != _STRBUF_TEXT;
+}
+
+CLZ_API void strbuf_make_binary(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_make_binary);
+    if (_strbuf_own(destbuf)) _strbuf_binary(*destbuf);
+}
+
+CLZ_API clz_footprint strbuf_footprint(char *strbuf) {
+    CLZ_STATS_CALL(strbuf_footprint);
+    if (_strbuf_is_literal(strbuf)) return (clz_footprint) {0, 0};
+    clz_footprint fp = {
+        .used = _strbuf_len(strbuf) + 1 + _STRBUF_HEADER,
+        .reserved = strbuf_alloc_size(strbuf) + _STRBUF_HEADER
+    };
+    return fp;
+}
+
+CLZ_API char *strbuf_new() {
+    CLZ_STATS_CALL(strbuf_new);
     return strbuf_new_size(CLZ_STRBUF_ALLOC);
 }
 
-char *strbuf_new_size(size_t sz) {
+CLZ_API char *strbuf_new_size(size_t sz) {
+    CLZ_STATS_CALL(strbuf_new_size);
     size_t actualsz = 2;
     while (actualsz < sz || actualsz < CLZ_STRBUF_ALLOC) actualsz <<= 1;
-    size_t *sb = malloc(actualsz * sizeof(char) + sizeof(size_t));
+    size_t *sb = malloc(actualsz * sizeof(char) + _STRBUF_HEADER);
     if (sb == NULL) return NULL;
-    *sb = actualsz;
-    return (char *) (sb + 1);
+    CLZ_STATS_ALLOC(strbuf_new_size, actualsz * sizeof(char) + _STRBUF_HEADER);
+    // buffers start in text mode, whose used bytes are unknown
+    CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_STRBUF_TEXT, 1, actualsz + _STRBUF_HEADER, 0);
+    sb[0] = _STRBUF_TEXT;
+    sb[1] = actualsz;
+    *((char *) (sb + 2)) = '\0';
+    return (char *) (sb + 2);
 }
 
-char *strbuf_new_str(char *s) {
-    return strbuf_clone(s, false);
+CLZ_API char *strbuf_new_str(char *s) {
+    CLZ_STATS_CALL(strbuf_new_str);
+    size_t len = strlen(s);
+    char *newbuf = strbuf_new_size(len + 1);
+    if (!newbuf) return NULL;
+    memcpy(newbuf, s, len + 1);
+    CLZ_STATS_COPY(strbuf_new_str, len + 1);
+    return newbuf;
 }
 
-void strbuf_free(char *strbuf) {
-    free(((size_t *) strbuf) - 1);
+CLZ_API void strbuf_free(char *strbuf) {
+    CLZ_STATS_CALL(strbuf_free);
+    if (_strbuf_is_literal(strbuf)) return;
+    CLZ_FOOTPRINT_ADD(strbuf_is_binary(strbuf) ? CLZ_FOOTPRINT_STRBUF : CLZ_FOOTPRINT_STRBUF_TEXT, -1,
+                      -(int64_t) (strbuf_alloc_size(strbuf) + _STRBUF_HEADER),
+                      strbuf_is_binary(strbuf) ? -(int64_t) (_strbuf_stored_len(strbuf) + 1 + _STRBUF_HEADER) : 0);
+    free(((size_t *) strbuf) - 2);
 }
 
-bool strbuf_append_char(char **destbuf, char c) {
-    char s[2] = {c, 0};
-    return strbuf_append_strn(destbuf, s, 1);
+CLZ_API bool strbuf_append_char(char **destbuf, char c) {
+    CLZ_STATS_CALL(strbuf_append_char);
+    return _strbuf_append(destbuf, &c, 1);
 }
 
-bool strbuf_append_str(char **dest, char *src) {
-    return strbuf_append_strn(dest, src, strlen(src));
+CLZ_API bool strbuf_append_str(char **dest, char *src) {
+    CLZ_STATS_CALL(strbuf_append_str);
+    size_t n = strlen(src);
+    CLZ_STATS_COPY(strbuf_append_str, n);
+    return _strbuf_append(dest, src, n);
 }
 
-bool strbuf_append_strn(char **dest, char *src, size_t n) {
-    size_t orig_len = strlen(*dest);
-    size_t src_len  = strlen(src);
-    size_t minsize  = orig_len + src_len + 1;
-
-    if (strbuf_alloc_size(*dest) < minsize) {
-        if (!strbuf_resize(dest, minsize)) {
-            return false;
-        }
-    } // "" => "Hello, World!"
+CLZ_API bool strbuf_append_strn(char **dest, char *src, size_t n) {
+    CLZ_STATS_CALL(strbuf_append_strn);
+    n = strnlen(src, n);
+    CLZ_STATS_COPY(strbuf_append_strn, n);
+    return _strbuf_append(dest, src, n);
+}
 
-    strncpy(*dest + orig_len, src, n);
-    if (src_len >= n)
-        *(*dest + orig_len + n) = '\0';
-    return true;
+CLZ_API bool strbuf_append_bytes(char **destbuf, const void *src, size_t n) {
+    CLZ_STATS_CALL(strbuf_append_bytes);
+    if (!_strbuf_own(destbuf)) return false;
+    _strbuf_binary(*destbuf);
+    CLZ_STATS_COPY(strbuf_append_bytes, n);
+    return _strbuf_append(destbuf, src, n);
 }
 
-bool strbuf_append_int(char **destbuf, int i) {
+CLZ_API bool strbuf_append_int(char **destbuf, int i) {
+    CLZ_STATS_CALL(strbuf_append_int);
     char val[12]; // max int has 10 digits plus one potential sign and null-terminator
     sprintf(val, "%d", i);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_append_uint(char **destbuf, unsigned int i) {
+CLZ_API bool strbuf_append_uint(char **destbuf, unsigned int i) {
+    CLZ_STATS_CALL(strbuf_append_uint);
     char val[11]; // max uint has 10 digits plus null-terminator
     sprintf(val, "%u", i);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_append_long(char **destbuf, long l) {
+CLZ_API bool strbuf_append_long(char **destbuf, long l) {
+    CLZ_STATS_CALL(strbuf_append_long);
     char val[21]; // max long has 19 digits plus one potential sign and null-terminator
     sprintf(val, "%ld", l);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_append_ulong(char **destbuf, unsigned long l) {
+CLZ_API bool strbuf_append_ulong(char **destbuf, unsigned long l) {
+    CLZ_STATS_CALL(strbuf_append_ulong);
     char val[21]; // max long has 20 digits plus null-terminator
     sprintf(val, "%lu", l);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_append_llong(char **destbuf, long long l) {
+CLZ_API bool strbuf_append_llong(char **destbuf, long long l) {
+    CLZ_STATS_CALL(strbuf_append_llong);
     char val[21]; // max long has 19 digits plus one potential sign and null-terminator
     sprintf(val, "%lld", l);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_append_ullong(char **destbuf, unsigned long long l) {
+CLZ_API bool strbuf_append_ullong(char **destbuf, unsigned long long l) {
+    CLZ_STATS_CALL(strbuf_append_ullong);
     char val[21]; // max long has 20 digits plus null-terminator
     sprintf(val, "%llu", l);
     return strbuf_append_str(destbuf, val);
 }
 
-bool strbuf_insert_char(char **destbuf, char c, size_t index) {
-    if (index > strlen(*destbuf)) return false;
-    char *bufnew = strbuf_new_size(strbuf_alloc_size(*destbuf) + 1);
-    if (!bufnew) return false;
-    bool ret = strbuf_append_strn(&bufnew, *destbuf, index)
-            && strbuf_append_char(&bufnew, c)
-            && strbuf_append_str(&bufnew, *destbuf + index);
-    if (!ret) {
-        strbuf_free(bufnew);
-        return false;
-    }
-    strbuf_free(*destbuf);
-    *destbuf = bufnew;
-    return true;
+CLZ_API bool strbuf_insert_char(char **destbuf, char c, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_char);
+    return _strbuf_insert(destbuf, &c, 1, index);
 }
 
-bool strbuf_insert_str(char **destbuf, char *s, size_t index) {
-    return strbuf_insert_strn(destbuf, s, index, strlen(s));
+CLZ_API bool strbuf_insert_str(char **destbuf, char *s, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_str);
+    size_t n = strlen(s);
+    CLZ_STATS_COPY(strbuf_insert_str, n);
+    return _strbuf_insert(destbuf, s, n, index);
 }
 
-bool strbuf_insert_strn(char **destbuf, char *s, size_t index, size_t maxlen) {
-    if (index > strlen(*destbuf)) return false;
-    size_t len_s = strlen(s);
-    if (maxlen > len_s) maxlen = len_s;
-    char *bufnew = strbuf_new_size(strbuf_alloc_size(*destbuf) + maxlen);
-    if (!bufnew) return false;
-    bool ret = strbuf_append_strn(&bufnew, *destbuf, index)
-            && strbuf_append_strn(&bufnew, s, maxlen)
-            && strbuf_append_str(&bufnew, *destbuf + index);
-    if (!ret) {
-        strbuf_free(bufnew);
-        return false;
-    }
-    strbuf_free(*destbuf);
-    *destbuf = bufnew;
-    return true;
+CLZ_API bool strbuf_insert_strn(char **destbuf, char *s, size_t index, size_t maxlen) {
+    CLZ_STATS_CALL(strbuf_insert_strn);
+    maxlen = strnlen(s, maxlen);
+    CLZ_STATS_COPY(strbuf_insert_strn, maxlen);
+    return _strbuf_insert(destbuf, s, maxlen, index);
 }
 
-bool strbuf_insert_int(char **destbuf, int i, size_t index) {
+CLZ_API bool strbuf_insert_bytes(char **destbuf, const void *src, size_t index, size_t n) {
+    CLZ_STATS_CALL(strbuf_insert_bytes);
+    if (!_strbuf_own(destbuf)) return false;
+    _strbuf_binary(*destbuf);
+    CLZ_STATS_COPY(strbuf_insert_bytes, n);
+    return _strbuf_insert(destbuf, src, n, index);
+}
+
+CLZ_API bool strbuf_insert_int(char **destbuf, int i, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_int);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_int(&intbuf, i)
@@ -1131,7 +1747,8 @@ bool strbuf_insert_int(char **destbuf, int i, size_t index) {
     return ret;
 }
 
-bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index) {
+CLZ_API bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_uint);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_uint(&intbuf, i)
@@ -1140,7 +1757,8 @@ bool strbuf_insert_uint(char **destbuf, unsigned int i, size_t index) {
     return ret;
 }
 
-bool strbuf_insert_long(char **destbuf, long l, size_t index) {
+CLZ_API bool strbuf_insert_long(char **destbuf, long l, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_long);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_long(&intbuf, l)
@@ -1149,7 +1767,8 @@ bool strbuf_insert_long(char **destbuf, long l, size_t index) {
     return ret;
 }
 
-bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index) {
+CLZ_API bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_ulong);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_ulong(&intbuf, l)
@@ -1158,7 +1777,8 @@ bool strbuf_insert_ulong(char **destbuf, unsigned long l, size_t index) {
     return ret;
 }
 
-bool strbuf_insert_llong(char **destbuf, long long l, size_t index) {
+CLZ_API bool strbuf_insert_llong(char **destbuf, long long l, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_llong);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_llong(&intbuf, l)
@@ -1167,7 +1787,8 @@ bool strbuf_insert_llong(char **destbuf, long long l, size_t index) {
     return ret;
 }
 
-bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index) {
+CLZ_API bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index) {
+    CLZ_STATS_CALL(strbuf_insert_ullong);
     char *intbuf = strbuf_new();
     if (!intbuf) return false;
     bool ret = strbuf_append_ullong(&intbuf, l) &&
@@ -1177,138 +1798,153 @@ bool strbuf_insert_ullong(char **destbuf, unsigned long long l, size_t index) {
 }
 
 // TODO: short circuit cases docs
-bool strbuf_resize(char **dest, size_t minsize) {
+CLZ_API bool strbuf_resize(char **dest, size_t minsize) {
+    CLZ_STATS_CALL(strbuf_resize);
     if (minsize < CLZ_STRBUF_ALLOC)
         return strbuf_resize(dest, CLZ_STRBUF_ALLOC);
 
-    size_t sz, len = strlen(*dest);
+    size_t sz, len = _strbuf_len(*dest);
     if (len + 1 > minsize) minsize = len + 1;
 
     for (sz = 1; sz < minsize || sz < len + 1; sz *= 2);
 
-    char *newbuf = malloc(sz + sizeof(size_t));
+    CLZ_STATS_RESIZE_BEGIN(strbuf_resize);
+    CLZ_USDT_TIMER(t0);
+    size_t *newbuf = malloc(sz + _STRBUF_HEADER);
     if (!newbuf) return false;
-
-    *((size_t *) newbuf) = sz;
-    strcpy(newbuf + sizeof(size_t), *dest);
-    free(((size_t *)*dest) - 1);
-    *dest = newbuf + sizeof(size_t);
+    CLZ_STATS_ALLOC(strbuf_resize, sz + _STRBUF_HEADER);
+
+    newbuf[0] = _strbuf_stored_len(*dest);
+    newbuf[1] = sz;
+    memcpy(newbuf + 2, *dest, len + 1);
+    CLZ_PROBE3(strbuf_resize, strbuf_alloc_size(*dest), sz, CLZ_USDT_ELAPSED(t0));
+    if (_strbuf_is_literal(*dest)) {
+        CLZ_FOOTPRINT_ADD(CLZ_FOOTPRINT_STRBUF_TEXT, 1, sz + _STRBUF_HEADER, 0);
+    } else {
+        CLZ_FOOTPRINT_ADD(strbuf_is_binary(*dest) ? CLZ_FOOTPRINT_STRBUF : CLZ_FOOTPRINT_STRBUF_TEXT, 0,
+                          (int64_t) sz - (int64_t) strbuf_alloc_size(*dest), 0);
+        free(((size_t *)*dest) - 2);
+    }
+    *dest = (char *) (newbuf + 2);
+    CLZ_STATS_COPY(strbuf_resize, len + 1);
+    CLZ_STATS_RESIZE_END(strbuf_resize);
     return true;
 }
 
-bool strbuf_compress(char **dest) {
-    return strbuf_resize(dest, strlen(*dest));
+CLZ_API bool strbuf_compress(char **dest) {
+    CLZ_STATS_CALL(strbuf_compress);
+    if (_strbuf_is_literal(*dest)) return true;
+    return strbuf_resize(dest, _strbuf_len(*dest));
 }
 
-void strbuf_trim_index(char **destbuf, size_t start, size_t end) {
-    if (end > strlen(*destbuf)) {
-        end = strlen(*destbuf);
+CLZ_API void strbuf_trim_index(char **destbuf, size_t start, size_t end) {
+    CLZ_STATS_CALL(strbuf_trim_index);
+    if (!_strbuf_own(destbuf)) return;
+    size_t len = _strbuf_len(*destbuf);
+    if (end > len) {
+        end = len;
     }
     // not else
-    if (start >= strlen(*destbuf) || start >= end) {
-        **destbuf = 0;
+    if (start >= len || start >= end) {
+        _strbuf_set_len(*destbuf, 0);
         return;
     }
-    else if (end == 0) return;
 
-    char *cpy = malloc(end - start + 1);
-    if (!cpy) return;
-    strncpy(cpy, *destbuf + start, end - start);
-    strcpy(*destbuf, cpy);
-    free(cpy);
+    memmove(*destbuf, *destbuf + start, end - start);
+    CLZ_STATS_COPY(strbuf_trim_index, end - start);
+    _strbuf_set_len(*destbuf, end - start);
 }
 
-void strbuf_trim_length(char **destbuf, size_t length) {
+CLZ_API void strbuf_trim_length(char **destbuf, size_t length) {
+    CLZ_STATS_CALL(strbuf_trim_length);
     strbuf_trim_index(destbuf, 0, length);
 }
 
-void strbuf_trim_head(char **destbuf) {
+CLZ_API void strbuf_trim_head(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_trim_head);
     strbuf_trim_head_char(destbuf, ' ');
 }
 
-void strbuf_trim_head_char(char **dest, char c) {
-    char *head = *dest;
-    for (; *head != 0 && *head == c; ++head);
-    char *cpy = strdup(head);
-    if (!cpy) return;
-    strcpy(*dest, head);
-    free(cpy);
+CLZ_API void strbuf_trim_head_char(char **dest, char c) {
+    CLZ_STATS_CALL(strbuf_trim_head_char);
+    if (!_strbuf_own(dest)) return;
+    size_t len = _strbuf_len(*dest), head = 0;
+    for (; head < len && (*dest)[head] == c; ++head);
+    memmove(*dest, *dest + head, len - head);
+    CLZ_STATS_COPY(strbuf_trim_head_char, len - head);
+    _strbuf_set_len(*dest, len - head);
 }
 
-void strbuf_trim_tail(char **destbuf) {
+CLZ_API void strbuf_trim_tail(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_trim_tail);
     strbuf_trim_tail_char(destbuf, ' ');
 }
 
-void strbuf_trim_tail_char(char **dest, char c) {
-    char *tail = *dest + strlen(*dest) - 1;
-    for (; tail != *dest - 1 && *tail == c; --tail) {
-    }
-    *++tail = 0;
+CLZ_API void strbuf_trim_tail_char(char **dest, char c) {
+    CLZ_STATS_CALL(strbuf_trim_tail_char);
+    if (!_strbuf_own(dest)) return;
+    size_t len = _strbuf_len(*dest);
+    for (; len > 0 && (*dest)[len - 1] == c; --len);
+    _strbuf_set_len(*dest, len);
 }
 
-bool strbuf_padding_head(char **destbuf, char c, size_t sz) {
-    size_t len = strlen(*destbuf);
+CLZ_API bool strbuf_padding_head(char **destbuf, char c, size_t sz) {
+    CLZ_STATS_CALL(strbuf_padding_head);
+    size_t len = _strbuf_len(*destbuf);
     if (len > sz) return false;
     else if (len == sz) return true;
     size_t padlen = sz - len;
-    char *padbuf = malloc(padlen + 1);
-    if (!padbuf) return false;
-    memset(padbuf, c, padlen);
-    bool ret = strbuf_insert_str(destbuf, padbuf, 0);
-    free(padbuf);
-    return ret;
+    if (!_strbuf_reserve(destbuf, sz + 1)) return false;
+    memmove(*destbuf + padlen, *destbuf, len);
+    CLZ_STATS_COPY(strbuf_padding_head, len);
+    memset(*destbuf, c, padlen);
+    _strbuf_set_len(*destbuf, sz);
+    return true;
 }
 
-bool strbuf_padding_tail(char **destbuf, char c, size_t sz) {
-    size_t len = strlen(*destbuf);
+CLZ_API bool strbuf_padding_tail(char **destbuf, char c, size_t sz) {
+    CLZ_STATS_CALL(strbuf_padding_tail);
+    size_t len = _strbuf_len(*destbuf);
     if (len > sz) return false;
     else if (len == sz) return true;
-    size_t padlen = sz - len;
-    char *padbuf = malloc(padlen + 1);
-    if (!padbuf) return false;
-    memset(padbuf, c, padlen);
-    bool ret = strbuf_append_str(destbuf, padbuf);
-    free(padbuf);
-    return ret;
+    if (!_strbuf_reserve(destbuf, sz + 1)) return false;
+    memset(*destbuf + len, c, sz - len);
+    _strbuf_set_len(*destbuf, sz);
+    return true;
 }
 
-char *strbuf_clone(char *strbuf, bool bufsz) {
-    char *newbuf;
-    if (bufsz) {
-        newbuf = strbuf_new_size(strbuf_alloc_size(strbuf));
-    } else {
-        size_t s = 2;
-        while (s <= strlen(strbuf) || s < CLZ_STRBUF_ALLOC) {
-            s <<= 1;
-        }
-        newbuf = strbuf_new_size(s);
-    }
-
+CLZ_API char *strbuf_clone(char *strbuf, bool bufsz) {
+    CLZ_STATS_CALL(strbuf_clone);
+    size_t len = _strbuf_len(strbuf);
+    char *newbuf = strbuf_new_size(bufsz && !_strbuf_is_literal(strbuf) ? strbuf_alloc_size(strbuf) : len + 1);
     if (!newbuf) return NULL;
-    else if (!strbuf_append_str(&newbuf, strbuf)) {
-        strbuf_free(newbuf);
-        return NULL;
-    }
+
+    memcpy(newbuf, strbuf, len + 1);
+    CLZ_STATS_COPY(strbuf_clone, len + 1);
+    if (strbuf_is_binary(strbuf)) _strbuf_track(newbuf, len);
     return newbuf;
 }
 
-int strbuf_find_first_char(char **destbuf, char c) {
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
-        if ((*destbuf)[i] == c) return i;
-    }
-    return CLZ_NOT_FOUND;
+CLZ_API int strbuf_find_first_char(char **destbuf, char c) {
+    CLZ_STATS_CALL(strbuf_find_first_char);
+    char *p = memchr(*destbuf, c, _strbuf_len(*destbuf));
+    return p ? p - *destbuf : CLZ_NOT_FOUND;
 }
 
-int strbuf_replace_first_char(char **destbuf, char c, char v) {
+CLZ_API int strbuf_replace_first_char(char **destbuf, char c, char v) {
+    CLZ_STATS_CALL(strbuf_replace_first_char);
     int i = strbuf_find_first_char(destbuf, c);
     if (i == CLZ_NOT_FOUND) return CLZ_NOT_FOUND;
+    if (!_strbuf_own(destbuf)) return CLZ_GENERAL_FAIL;
     (*destbuf)[i] = v;
     return i;
 }
 
-size_t strbuf_replace_all_char(char **destbuf, char c, char v) {
+CLZ_API size_t strbuf_replace_all_char(char **destbuf, char c, char v) {
+    CLZ_STATS_CALL(strbuf_replace_all_char);
     size_t count = 0;
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
+    if (!memchr(*destbuf, c, _strbuf_len(*destbuf)) || !_strbuf_own(destbuf)) return 0;
+    for (size_t i = 0, len = _strbuf_len(*destbuf); i < len; ++i) {
         if ((*destbuf)[i] == c) {
             (*destbuf)[i] = v;
             ++count;
@@ -1318,7 +1954,7 @@ size_t strbuf_replace_all_char(char **destbuf, char c, char v) {
 }
 
 /*
-size_t strbuf_split_char(char **destbuf, char **ptr, char c) {
+CLZ_API size_t strbuf_split_char(char **destbuf, char **ptr, char c) {
     size_t arrlen = 0;
     for (size_t i = 1; i < strlen(*destbuf); ++i) {
         if (((*destbuf)[i]) == c) {
@@ -1341,142 +1977,568 @@ size_t strbuf_split_char(char **destbuf, char **ptr, char c) {
     }
 }*/
 
-int strbuf_find_last_char(char **destbuf, char c) {
-    for (int i = strlen(*destbuf) - 1; i >= 0; --i) {
+CLZ_API int strbuf_find_last_char(char **destbuf, char c) {
+    CLZ_STATS_CALL(strbuf_find_last_char);
+    for (int i = _strbuf_len(*destbuf) - 1; i >= 0; --i) {
         if ((*destbuf)[i] == c) return i;
     }
     return CLZ_NOT_FOUND;
 }
 
-int strbuf_find_first_str(char **destbuf, char *s) {
-    size_t len = strlen(s);
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
-        if (!strncmp(*destbuf + i, s, len)) return i;
-    }
-    return CLZ_NOT_FOUND;
+CLZ_API int strbuf_find_first_str(char **destbuf, char *s) {
+    CLZ_STATS_CALL(strbuf_find_first_str);
+    return strbuf_find_bytes(destbuf, s, strlen(s), 0);
 }
 
-int strbuf_find_last_str(char **destbuf, char *s) {
-    for (int i = strlen(*destbuf) - 1; i >= 0; --i) {
-        if (!strncmp(*destbuf + i, s, strlen(s))) return i;
+CLZ_API int strbuf_find_last_str(char **destbuf, char *s) {
+    CLZ_STATS_CALL(strbuf_find_last_str);
+    size_t len = _strbuf_len(*destbuf), n = strlen(s);
+    if (n > len) return CLZ_NOT_FOUND;
+    for (int i = len - n; i >= 0; --i) {
+        if (!memcmp(*destbuf + i, s, n)) return i;
     }
     return CLZ_NOT_FOUND;
 }
 
-int strbuf_replace_first_str(char **destbuf, char *s, char *t) {
+CLZ_API int strbuf_find_bytes(char **destbuf, const void *needle, size_t n, size_t from) {
+    CLZ_STATS_CALL(strbuf_find_bytes);
+    size_t len = _strbuf_len(*destbuf);
+    if (from > len) return CLZ_NOT_FOUND;
+    const char *p = _strbuf_memmem(*destbuf + from, len - from, needle, n);
+    return p ? p - *destbuf : CLZ_NOT_FOUND;
+}
+
+CLZ_API const char *strbuf_memmem(const void *haystack, size_t hlen, const void *needle, size_t n) {
+    CLZ_STATS_CALL(strbuf_memmem);
+    return _strbuf_memmem(haystack, hlen, needle, n);
+}
+
+CLZ_API int strbuf_replace_first_str(char **destbuf, char *s, char *t) {
+    CLZ_STATS_CALL(strbuf_replace_first_str);
     int ind = strbuf_find_first_str(destbuf, s);
     if (ind == CLZ_NOT_FOUND) return CLZ_NOT_FOUND;
 
-    char *start = strbuf_clone(*destbuf, false);
-    strbuf_trim_index(&start, 0, ind);
-    char *end = strbuf_clone(*destbuf, false);
-    strbuf_trim_index(&end, ind + strlen(s), strlen(*destbuf));
-
-    char *buf = malloc(strlen(*destbuf) + strlen(t) - strlen(s) + 1);
-    if (!buf) return CLZ_GENERAL_FAIL;
-    sprintf(buf, "%s%s%s", start, t, end);
-    size_t len = strlen(buf);
-    if (len >= strbuf_alloc_size(*destbuf)) {
-        strbuf_resize(destbuf, len + 1);
-    }
-
-    strcpy(*destbuf, buf);
-    free(buf);
+    size_t len = _strbuf_len(*destbuf), lens = strlen(s), lent = strlen(t);
+    if (!_strbuf_reserve(destbuf, len - lens + lent + 1)) return CLZ_GENERAL_FAIL;
+    memmove(*destbuf + ind + lent, *destbuf + ind + lens, len - ind - lens);
+    memcpy(*destbuf + ind, t, lent);
+    CLZ_STATS_COPY(strbuf_replace_first_str, len - ind - lens + lent);
+    _strbuf_set_len(*destbuf, len - lens + lent);
     return ind;
 }
 
-size_t strbuf_replace_all_str(char **destbuf, char *s, char *t) {
-    size_t count = 0, lenneedle = strlen(s);
+CLZ_API size_t strbuf_replace_all_str(char **destbuf, char *s, char *t) {
+    CLZ_STATS_CALL(strbuf_replace_all_str);
+    size_t count = 0, lenneedle = strlen(s), lent = strlen(t), len = _strbuf_len(*destbuf), pos = 0;
     int head;
-    char *newbuf = strbuf_new_size(strbuf_alloc_size(*destbuf));
-    char *haystack = *destbuf;
-
-    while ((head = strbuf_find_first_str(&haystack, s)) != CLZ_NOT_FOUND) {
-        strbuf_append_strn(&newbuf, haystack, head);
-        strbuf_append_str(&newbuf, t);
-        haystack += head + lenneedle;
+    if (!lenneedle) return 0;
+    char *newbuf = _strbuf_new_like(*destbuf);
+    if (!newbuf) return 0;
+
+    bool ret = true;
+    while (ret && (head = strbuf_find_bytes(destbuf, s, lenneedle, pos)) != CLZ_NOT_FOUND) {
+        ret = _strbuf_append(&newbuf, *destbuf + pos, head - pos)
+                && _strbuf_append(&newbuf, t, lent);
+        pos = head + lenneedle;
         ++count;
     }
-    strbuf_append_str(&newbuf, haystack);
+    if (!ret || !_strbuf_append(&newbuf, *destbuf + pos, len - pos)) {
+        strbuf_free(newbuf);
+        return 0;
+    }
+    CLZ_STATS_COPY(strbuf_replace_all_str, _strbuf_len(newbuf));
     strbuf_free(*destbuf);
     *destbuf = newbuf;
     return count;
 }
 
-bool strbuf_remove_char(char **destbuf, size_t index) {
-    if (index >= strlen(*destbuf)) return false;
-    char *newbuf = strbuf_new_size(strbuf_alloc_size(*destbuf));
+CLZ_API bool strbuf_remove_char(char **destbuf, size_t index) {
+    CLZ_STATS_CALL(strbuf_remove_char);
+    size_t len = _strbuf_len(*destbuf);
+    if (index >= len) return false;
+    CLZ_USDT_TIMER(t0);
+    char *newbuf = _strbuf_new_like(*destbuf);
     if (!newbuf) return false;
-    bool ret  = strbuf_append_strn(&newbuf, *destbuf, index)
-            && strbuf_append_str(&newbuf, *destbuf + index + 1);
+    bool ret  = _strbuf_append(&newbuf, *destbuf, index)
+            && _strbuf_append(&newbuf, *destbuf + index + 1, len - index - 1);
     if (!ret) {
         strbuf_free(newbuf);
         return false;
     }
+    CLZ_PROBE3(strbuf_remove_realloc, len, len - 1, CLZ_USDT_ELAPSED(t0));
     strbuf_free(*destbuf);
     *destbuf = newbuf;
     return true;
 }
 
-bool strbuf_remove_str(char **destbuf, size_t start, size_t end) {
+CLZ_API bool strbuf_remove_str(char **destbuf, size_t start, size_t end) {
+    CLZ_STATS_CALL(strbuf_remove_str);
     if (start >= end) return false;
-    size_t len = strlen(*destbuf);
+    size_t len = _strbuf_len(*destbuf);
     if (start >= len) return false;
     else if (end >= len) end = len;
 
-    char *newbuf = strbuf_new_size(strbuf_alloc_size(*destbuf));
+    CLZ_USDT_TIMER(t0);
+    char *newbuf = _strbuf_new_like(*destbuf);
     if (!newbuf) return false;
-    bool ret = strbuf_append_strn(&newbuf, *destbuf, start)
-            && strbuf_append_str(&newbuf, *destbuf + end);
+    bool ret = _strbuf_append(&newbuf, *destbuf, start)
+            && _strbuf_append(&newbuf, *destbuf + end, len - end);
     if (!ret) {
         strbuf_free(newbuf);
         return false;
     }
+    CLZ_PROBE3(strbuf_remove_realloc, len, len - (end - start), CLZ_USDT_ELAPSED(t0));
     strbuf_free(*destbuf);
     *destbuf = newbuf;
     return true;
 }
 
-void strbuf_to_lowercase(char **destbuf) {
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
+CLZ_API void strbuf_to_lowercase(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_to_lowercase);
+    if (!_strbuf_own(destbuf)) return;
+    for (size_t i = 0, len = _strbuf_len(*destbuf); i < len; ++i) {
         if (isupper((*destbuf)[i])) {
             (*destbuf)[i] = tolower((*destbuf)[i]);
         }
     }
 }
 
-void strbuf_to_lowercase_l(char **destbuf, locale_t locale) {
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
+CLZ_API void strbuf_to_lowercase_l(char **destbuf, locale_t locale) {
+    CLZ_STATS_CALL(strbuf_to_lowercase_l);
+    if (!_strbuf_own(destbuf)) return;
+    for (size_t i = 0, len = _strbuf_len(*destbuf); i < len; ++i) {
         if (isupper_l((*destbuf)[i], locale)) {
             (*destbuf)[i] = tolower_l((*destbuf)[i], locale);
         }
     }
 }
 
-void strbuf_to_uppercase(char **destbuf) {
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
+CLZ_API void strbuf_to_uppercase(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_to_uppercase);
+    if (!_strbuf_own(destbuf)) return;
+    for (size_t i = 0, len = _strbuf_len(*destbuf); i < len; ++i) {
         if (islower((*destbuf)[i])) {
             (*destbuf)[i] = toupper((*destbuf)[i]);
         }
     }
 }
 
-void strbuf_to_uppercase_l(char **destbuf, locale_t locale) {
-    for (size_t i = 0; i < strlen(*destbuf); ++i) {
+CLZ_API void strbuf_to_uppercase_l(char **destbuf, locale_t locale) {
+    CLZ_STATS_CALL(strbuf_to_uppercase_l);
+    if (!_strbuf_own(destbuf)) return;
+    for (size_t i = 0, len = _strbuf_len(*destbuf); i < len; ++i) {
         if (islower_l((*destbuf)[i], locale)) {
             (*destbuf)[i] = toupper_l((*destbuf)[i], locale);
         }
     }
 }
 
-bool strbuf_reverse(char **destbuf) {
-    char *cpy = strdup(*destbuf);
-    if (!cpy) return false;
-    size_t len = strlen(*destbuf);
-    for (size_t i = 0; i < len; ++i) {
-        (*destbuf)[i] = cpy[len - 1 - i];
+CLZ_API bool strbuf_reverse(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_reverse);
+    if (!_strbuf_own(destbuf)) return false;
+    char *s = *destbuf;
+    for (size_t i = 0, j = _strbuf_len(s); i + 1 < j; ++i, --j) {
+        char tmp = s[i];
+        s[i] = s[j - 1];
+        s[j - 1] = tmp;
+    }
+    return true;
+}
+
+static size_t _strbuf_ansi_seq_len(const char *s, const char *end) {
+    // s[0] is ESC, the sequence stops at a null byte or at end
+    size_t i = 1, n = end - s;
+    if (n < 2 || s[1] == '\0') return 1;
+    unsigned char c = s[1];
+    if (c == '[') {
+        // CSI: parameter bytes, intermediate bytes, final byte
+        for (i = 2; i < n && s[i] != '\0'; ++i) {
+            c = s[i];
+            if (c >= 0x40 && c <= 0x7E) return i + 1;
+            if (c < 0x20 || c > 0x3F) return i;
+        }
+        return i;
+    }
+    if (c == ']' || c == 'P' || c == 'X' || c == '^' || c == '_') {
+        // OSC, DCS, SOS, PM, APC: string terminated by ST (ESC \), OSC also by BEL
+        for (i = 2; i < n && s[i] != '\0'; ++i) {
+            if (s[i] == '\a' && c == ']') return i + 1;
+            if (s[i] == '\033' && i + 1 < n && s[i + 1] == '\\') return i + 2;
+        }
+        return i;
+    }
+    // nF escape: intermediate bytes followed by a final byte
+    for (; i < n && s[i] != '\0'; ++i) {
+        c = s[i];
+        if (c >= 0x30 && c <= 0x7E) return i + 1;
+        if (c < 0x20 || c > 0x2F) return i;
+    }
+    return i;
+}
+
+CLZ_API size_t strbuf_strip_ansi(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_strip_ansi);
+    size_t len = _strbuf_len(*destbuf);
+    char *esc = memchr(*destbuf, '\033', len);
+    if (!esc) return 0;
+    size_t off = esc - *destbuf;
+    if (!_strbuf_own(destbuf)) return 0;
+    char *s = *destbuf;
+    esc = s + off;
+
+    char *end = s + len, *out = esc, *in = esc;
+    while (in < end) {
+        in += _strbuf_ansi_seq_len(in, end);
+        char *next = memchr(in, '\033', end - in);
+        if (!next) next = end;
+        memmove(out, in, next - in);
+        CLZ_STATS_COPY(strbuf_strip_ansi, next - in);
+        out += next - in;
+        in = next;
+    }
+    _strbuf_set_len(s, out - s);
+    return end - out;
+}
+
+/*
+ * Sorted, non-overlapping ranges of code points occupying two columns (East Asian Wide and Fullwidth).
+ */
+static const uint32_t _strbuf_wide_ranges[][2] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+    {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+    {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+    {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+    {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF},
+    {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+    {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}
+};
+
+/*
+ * Sorted, non-overlapping ranges of code points occupying no columns (combining marks and zero-width characters).
+ */
+static const uint32_t _strbuf_zero_ranges[][2] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A}, {0x064B, 0x065F},
+    {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1160, 0x11FF}, {0x1AB0, 0x1AFF},
+    {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF},
+    {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0x1F3FB, 0x1F3FF}, {0xE0000, 0xE0FFF}
+};
+
+static bool _strbuf_in_ranges(uint32_t cp, const uint32_t ranges[][2], size_t n) {
+    size_t lo = 0, hi = n;
+    if (cp < ranges[0][0] || cp > ranges[n - 1][1]) return false;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp > ranges[mid][1]) lo = mid + 1;
+        else if (cp < ranges[mid][0]) hi = mid;
+        else return true;
+    }
+    return false;
+}
+
+static size_t _strbuf_codepoint_width(uint32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (cp < 0x300) return 1;
+    if (_strbuf_in_ranges(cp, _strbuf_zero_ranges, sizeof(_strbuf_zero_ranges) / sizeof(*_strbuf_zero_ranges)))
+        return 0;
+    if (_strbuf_in_ranges(cp, _strbuf_wide_ranges, sizeof(_strbuf_wide_ranges) / sizeof(*_strbuf_wide_ranges)))
+        return 2;
+    return 1;
+}
+
+static size_t _strbuf_display_width(const char *str, size_t len) {
+    const unsigned char *s = (const unsigned char *) str;
+    const unsigned char *end = s + len;
+    size_t width = 0;
+
+    while (s < end) {
+        // fast path: 8 bytes of printable ASCII (no high bit, no control char, no DEL)
+        if (end - s >= 8) {
+            uint64_t w;
+            memcpy(&w, s, sizeof(w));
+            if (!(w & 0x8080808080808080ULL)
+                    && !((w - 0x2020202020202020ULL) & ~w & 0x8080808080808080ULL)
+                    && !((w + 0x0101010101010101ULL) & 0x8080808080808080ULL)) {
+                width += 8;
+                s += 8;
+                continue;
+            }
+        }
+
+        unsigned char c = *s;
+        if (c == '\033') {
+            s += _strbuf_ansi_seq_len((const char *) s, (const char *) end);
+            continue;
+        }
+        if (c < 0x80) {
+            width += (c >= 0x20 && c != 0x7F);
+            ++s;
+            continue;
+        }
+
+        uint32_t cp;
+        size_t n;
+        if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; n = 2; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; n = 3; }
+        else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; n = 4; }
+        else { ++width; ++s; continue; } // stray continuation or invalid lead byte
+
+        size_t i;
+        for (i = 1; i < n && s + i < end && (s[i] & 0xC0) == 0x80; ++i) {
+            cp = (cp << 6) | (s[i] & 0x3F);
+        }
+        if (i < n) { ++width; ++s; continue; } // truncated sequence
+
+        width += _strbuf_codepoint_width(cp);
+        s += n;
     }
-    free(cpy);
+    return width;
+}
+
+CLZ_API size_t strbuf_display_width(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_display_width);
+    return _strbuf_display_width(*destbuf, _strbuf_len(*destbuf));
+}
+
+CLZ_API size_t strbuf_display_width_bytes(const char *s, size_t n) {
+    CLZ_STATS_CALL(strbuf_display_width_bytes);
+    return _strbuf_display_width(s, n);
+}
+
+CLZ_API bool strbuf_padding_head_display(char **destbuf, char c, size_t width) {
+    CLZ_STATS_CALL(strbuf_padding_head_display);
+    size_t dwidth = strbuf_display_width(destbuf);
+    if (dwidth > width) return false;
+    else if (dwidth == width) return true;
+
+    size_t padlen = width - dwidth, len = _strbuf_len(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + padlen + 1)) return false;
+    memmove(*destbuf + padlen, *destbuf, len);
+    CLZ_STATS_COPY(strbuf_padding_head_display, len);
+    memset(*destbuf, c, padlen);
+    _strbuf_set_len(*destbuf, len + padlen);
+    return true;
+}
+
+CLZ_API bool strbuf_padding_tail_display(char **destbuf, char c, size_t width) {
+    CLZ_STATS_CALL(strbuf_padding_tail_display);
+    size_t dwidth = strbuf_display_width(destbuf);
+    if (dwidth > width) return false;
+    else if (dwidth == width) return true;
+
+    size_t padlen = width - dwidth, len = _strbuf_len(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + padlen + 1)) return false;
+    memset(*destbuf + len, c, padlen);
+    _strbuf_set_len(*destbuf, len + padlen);
+    return true;
+}
+
+CLZ_API uint64_t strbuf_hash(char **destbuf) {
+    CLZ_STATS_CALL(strbuf_hash);
+    uint64_t h = CLZ_FNV_OFFSET;
+    const unsigned char *s = (const unsigned char *) *destbuf, *end = s + _strbuf_len(*destbuf);
+    for (; s < end; ++s) {
+        h ^= *s;
+        h *= CLZ_FNV_PRIME;
+    }
+    return h;
+}
+
+CLZ_API bool strbuf_append_varint(char **destbuf, uint64_t v) {
+    CLZ_STATS_CALL(strbuf_append_varint);
+    if (!_strbuf_own(destbuf)) return false;
+    size_t len = _strbuf_binary(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + 11)) return false;
+    unsigned char *p = (unsigned char *) *destbuf + len;
+    while (v >= 0x80) {
+        *p++ = (unsigned char) v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (unsigned char) v;
+    _strbuf_set_len(*destbuf, (char *) p - *destbuf);
+    return true;
+}
+
+CLZ_API bool strbuf_append_zigzag(char **destbuf, int64_t v) {
+    CLZ_STATS_CALL(strbuf_append_zigzag);
+    return strbuf_append_varint(destbuf, strbuf_zigzag_encode(v));
+}
+
+CLZ_API bool strbuf_append_le(char **destbuf, uint64_t v, size_t width) {
+    CLZ_STATS_CALL(strbuf_append_le);
+    if (width < 1 || width > 8 || !_strbuf_own(destbuf)) return false;
+    size_t len = _strbuf_binary(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + width + 1)) return false;
+    unsigned char *p = (unsigned char *) *destbuf + len;
+    for (size_t i = 0; i < width; ++i) p[i] = (unsigned char) (v >> (8 * i));
+    _strbuf_set_len(*destbuf, len + width);
+    return true;
+}
+
+CLZ_API bool strbuf_append_be(char **destbuf, uint64_t v, size_t width) {
+    CLZ_STATS_CALL(strbuf_append_be);
+    if (width < 1 || width > 8 || !_strbuf_own(destbuf)) return false;
+    size_t len = _strbuf_binary(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + width + 1)) return false;
+    unsigned char *p = (unsigned char *) *destbuf + len;
+    for (size_t i = 0; i < width; ++i) p[i] = (unsigned char) (v >> (8 * (width - 1 - i)));
+    _strbuf_set_len(*destbuf, len + width);
+    return true;
+}
+
+CLZ_API bool strbuf_append_svb(char **destbuf, const uint32_t *values, size_t n) {
+    CLZ_STATS_CALL(strbuf_append_svb);
+    if (!_strbuf_own(destbuf)) return false;
+    size_t nctrl = (n + 3) / 4, len = _strbuf_binary(*destbuf);
+    if (!_strbuf_reserve(destbuf, len + nctrl + 4 * n + 1)) return false;
+
+    unsigned char *ctrl = (unsigned char *) *destbuf + len, *data = ctrl + nctrl;
+    memset(ctrl, 0, nctrl);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t v = values[i];
+        unsigned code = (v > 0xff) + (v > 0xffff) + (v > 0xffffff);
+        ctrl[i / 4] |= code << (2 * (i % 4));
+        for (unsigned b = 0; b <= code; ++b) *data++ = (unsigned char) (v >> (8 * b));
+    }
+    _strbuf_set_len(*destbuf, (char *) data - *destbuf);
+    return true;
+}
+
+CLZ_API bool strbuf_read_varint(char **destbuf, size_t *pos, uint64_t *out) {
+    CLZ_STATS_CALL(strbuf_read_varint);
+    const unsigned char *p = (const unsigned char *) *destbuf;
+    uint64_t v = 0;
+    for (size_t i = *pos, len = _strbuf_len(*destbuf), shift = 0; i < len && shift < 70; ++i, shift += 7) {
+        uint64_t b = p[i];
+        // the 10th byte may only hold the highest bit of a 64-bit value
+        if (shift == 63 && b > 1) return false;
+        v |= (b & 0x7f) << shift;
+        if (b < 0x80) {
+            *out = v;
+            *pos = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+CLZ_API bool strbuf_read_zigzag(char **destbuf, size_t *pos, int64_t *out) {
+    CLZ_STATS_CALL(strbuf_read_zigzag);
+    uint64_t u;
+    if (!strbuf_read_varint(destbuf, pos, &u)) return false;
+    *out = strbuf_zigzag_decode(u);
+    return true;
+}
+
+CLZ_API bool strbuf_read_le(char **destbuf, size_t *pos, size_t width, uint64_t *out) {
+    CLZ_STATS_CALL(strbuf_read_le);
+    size_t len = _strbuf_len(*destbuf);
+    if (width < 1 || width > 8 || *pos > len || len - *pos < width) return false;
+    const unsigned char *p = (const unsigned char *) *destbuf + *pos;
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; ++i) v |= (uint64_t) p[i] << (8 * i);
+    *out = v;
+    *pos += width;
+    return true;
+}
+
+CLZ_API bool strbuf_read_be(char **destbuf, size_t *pos, size_t width, uint64_t *out) {
+    CLZ_STATS_CALL(strbuf_read_be);
+    size_t len = _strbuf_len(*destbuf);
+    if (width < 1 || width > 8 || *pos > len || len - *pos < width) return false;
+    const unsigned char *p = (const unsigned char *) *destbuf + *pos;
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; ++i) v = (v << 8) | p[i];
+    *out = v;
+    *pos += width;
+    return true;
+}
+
+// number of data bytes described by a full control byte
+#define _SVB_LEN(c, i) ((((c) >> (2 * (i))) & 3) + 1)
+#define _SVB_GROUP_LEN(c) (_SVB_LEN(c, 0) + _SVB_LEN(c, 1) + _SVB_LEN(c, 2) + _SVB_LEN(c, 3))
+#define _SVB_GL4(c) _SVB_GROUP_LEN(c), _SVB_GROUP_LEN((c) + 1), _SVB_GROUP_LEN((c) + 2), _SVB_GROUP_LEN((c) + 3)
+#define _SVB_GL16(c) _SVB_GL4(c), _SVB_GL4((c) + 4), _SVB_GL4((c) + 8), _SVB_GL4((c) + 12)
+#define _SVB_GL64(c) _SVB_GL16(c), _SVB_GL16((c) + 16), _SVB_GL16((c) + 32), _SVB_GL16((c) + 48)
+
+static const unsigned char _strbuf_svb_group_len[256] = {
+    _SVB_GL64(0), _SVB_GL64(64), _SVB_GL64(128), _SVB_GL64(192)
+};
+
+static size_t _strbuf_svb_scalar(const unsigned char *ctrl, const unsigned char *data, uint32_t *out,
+                                 size_t from, size_t n) {
+    const unsigned char *start = data;
+    for (size_t i = from; i < n; ++i) {
+        unsigned l = _SVB_LEN(ctrl[i / 4], i % 4);
+        uint32_t v = 0;
+        for (unsigned b = 0; b < l; ++b) v |= (uint32_t) data[b] << (8 * b);
+        out[i] = v;
+        data += l;
+    }
+    return data - start;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+// shuffle mask moving the bytes of four values described by control byte c into four 32-bit lanes
+#define _SVB_OFF(c, i) ((i) == 0 ? 0 : (i) == 1 ? _SVB_LEN(c, 0) : (i) == 2 ? _SVB_LEN(c, 0) + _SVB_LEN(c, 1) \
+                        : _SVB_LEN(c, 0) + _SVB_LEN(c, 1) + _SVB_LEN(c, 2))
+#define _SVB_B(c, i, j) ((j) < _SVB_LEN(c, i) ? _SVB_OFF(c, i) + (j) : 0xff)
+#define _SVB_ROW(c) {_SVB_B(c, 0, 0), _SVB_B(c, 0, 1), _SVB_B(c, 0, 2), _SVB_B(c, 0, 3), \
+                     _SVB_B(c, 1, 0), _SVB_B(c, 1, 1), _SVB_B(c, 1, 2), _SVB_B(c, 1, 3), \
+                     _SVB_B(c, 2, 0), _SVB_B(c, 2, 1), _SVB_B(c, 2, 2), _SVB_B(c, 2, 3), \
+                     _SVB_B(c, 3, 0), _SVB_B(c, 3, 1), _SVB_B(c, 3, 2), _SVB_B(c, 3, 3)}
+#define _SVB_ROW4(c) _SVB_ROW(c), _SVB_ROW((c) + 1), _SVB_ROW((c) + 2), _SVB_ROW((c) + 3)
+#define _SVB_ROW16(c) _SVB_ROW4(c), _SVB_ROW4((c) + 4), _SVB_ROW4((c) + 8), _SVB_ROW4((c) + 12)
+#define _SVB_ROW64(c) _SVB_ROW16(c), _SVB_ROW16((c) + 16), _SVB_ROW16((c) + 32), _SVB_ROW16((c) + 48)
+
+static const unsigned char _strbuf_svb_shuffle[256][16] = {
+    _SVB_ROW64(0), _SVB_ROW64(64), _SVB_ROW64(128), _SVB_ROW64(192)
+};
+
+__attribute__((target("ssse3")))
+static size_t _strbuf_svb_ssse3(const unsigned char *ctrl, const unsigned char *data, size_t avail, uint32_t *out,
+                                size_t groups, size_t *used) {
+    size_t g = 0, off = 0;
+    // every load reads 16 bytes, so the last groups are left to the scalar decoder
+    for (; g < groups && off + 16 <= avail; ++g) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + off));
+        v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *) _strbuf_svb_shuffle[ctrl[g]]));
+        _mm_storeu_si128((__m128i *) (out + 4 * g), v);
+        off += _strbuf_svb_group_len[ctrl[g]];
+    }
+    *used = off;
+    return g;
+}
+#endif
+
+CLZ_API bool strbuf_read_svb(char **destbuf, size_t *pos, uint32_t *out, size_t n) {
+    CLZ_STATS_CALL(strbuf_read_svb);
+    size_t nctrl = (n + 3) / 4, len = _strbuf_len(*destbuf);
+    if (*pos > len || len - *pos < nctrl) return false;
+    const unsigned char *ctrl = (const unsigned char *) *destbuf + *pos, *data = ctrl + nctrl;
+
+    // the control bytes determine the size of the data, which is checked once up front
+    size_t total = 0;
+    for (size_t g = 0; g < n / 4; ++g) total += _strbuf_svb_group_len[ctrl[g]];
+    for (size_t i = n & ~(size_t) 3; i < n; ++i) total += _SVB_LEN(ctrl[i / 4], i % 4);
+    size_t avail = len - *pos - nctrl;
+    if (total > avail) return false;
+
+    size_t done = 0, used = 0;
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("ssse3")) {
+        done = 4 * _strbuf_svb_ssse3(ctrl, data, avail, out, n / 4, &used);
+    }
+#endif
+    used += _strbuf_svb_scalar(ctrl, data + used, out, done, n);
+    *pos += nctrl + used;
     return true;
 }
 
@@ -0,0 +1,390 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains multi-threaded variants of the search and replace functions of @ref strbuf.h for
+ * very large buffers, where a single core is limited by its memory bandwidth long before the machine is.
+ *
+ * The buffer is split into one chunk per thread. Every thread searches for the matches starting within its chunk,
+ * reading up to `strlen(needle) - 1` bytes into the next chunk so that no match on a boundary is lost. The
+ * matches of all chunks are then merged in order. As with @ref strbuf_replace_all_str, matches do not overlap and
+ * are taken from left to right: if a match reaches into the next chunk, that chunk is searched again from the end
+ * of the match, sequentially, until its matches agree with the ones found in parallel. This only happens with
+ * needles that can overlap themselves, such as `"aa"`.
+ *
+ * For replacing, the size of the output of every chunk follows from its number of matches, so a prefix sum yields
+ * where every chunk starts in the new buffer and all chunks are copied in parallel.
+ *
+ * The results are identical to those of the single-threaded functions. Buffers in binary mode are supported.
+ * Buffers smaller than @ref CLZ_STRBUF_PARALLEL_MIN bytes per thread are searched with fewer threads, down to a
+ * single one, which is the calling thread.
+ *
+ * Example:
+ *
+ * @code
+ *     char *log = read_whole_file("access.log"); // 1 GiB
+ *     size_t n = strbuf_replace_all_str_parallel(&log, "GET /old/", "GET /new/", 0); // 0: one thread per core
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_STRBUF_PARALLEL_IMPL` is defined beforehand. It requires
+ * POSIX threads and the implementation of @ref strbuf.h.
+ *
+ * @file strbuf_parallel.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for multi-threaded search and replace on strbufs
+ *
+ */
+
+#ifndef _CLZ_STRBUF_PARALLEL_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_STRBUF_PARALLEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "clz.h"
+#include "strbuf.h"
+
+/**
+ * Macro defining the minimum number of bytes searched by each thread.
+ * Starting a thread costs in the order of tens of microseconds, in which a core searches a few hundred KiB.
+ */
+#ifndef CLZ_STRBUF_PARALLEL_MIN
+#define CLZ_STRBUF_PARALLEL_MIN (1 << 20)
+#endif
+
+/**
+ * @brief Finds the first instance of the given substring using several threads.
+ *
+ * Same as @ref strbuf_find_first_str. The buffer is handed out to the threads in pieces in ascending order, and
+ * pieces after one that holds a match are skipped, so a match near the beginning is found quickly.
+ *
+ * Unlike @ref strbuf_find_first_str, the position is returned as an `ssize_t`, so that matches beyond 2 GiB are
+ * reported correctly.
+ *
+ * @param destbuf The destination buffer (haystack)
+ * @param s The needle
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return the position if found, otherwise @ref CLZ_NOT_FOUND
+ *
+ * @see strbuf_find_all_str_parallel
+ */
+ssize_t strbuf_find_first_str_parallel(char **destbuf, char *s, size_t threads);
+/**
+ * @brief Finds all non-overlapping instances of the given substring using several threads.
+ *
+ * The positions of the matches are stored in ascending order in an array allocated with `malloc`, which the caller
+ * has to `free`. If there is no match, `*offsets` is set to `NULL`. If the heap allocation fails, `0` is returned,
+ * `*offsets` is set to `NULL` and `errno` is set to `ENOMEM`.
+ *
+ * @param destbuf The destination buffer (haystack)
+ * @param s The needle, which must not be empty
+ * @param offsets The destination of the array of positions
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return the number of matches
+ *
+ * @see strbuf_find_first_str_parallel, strbuf_replace_all_str_parallel
+ */
+size_t strbuf_find_all_str_parallel(char **destbuf, char *s, size_t **offsets, size_t threads);
+/**
+ * @brief Replaces all instances of the given substring using several threads.
+ *
+ * Same as @ref strbuf_replace_all_str: the buffer is replaced by a new one holding the result, unless nothing was
+ * found. If the heap allocation fails, the buffer is left unchanged, `0` is returned and `errno` is set to
+ * `ENOMEM`.
+ *
+ * @param destbuf The destination buffer
+ * @param s The substring to replace, which must not be empty
+ * @param t The replacement
+ * @param threads The maximum number of threads, or `0` for the number of online processors
+ * @return the number of replacements
+ *
+ * @see strbuf_find_all_str_parallel
+ */
+size_t strbuf_replace_all_str_parallel(char **destbuf, char *s, char *t, size_t threads);
+
+#endif
+
+#ifdef CLZ_STRBUF_PARALLEL_IMPL
+#undef CLZ_STRBUF_PARALLEL_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "parallel.h"
+
+typedef struct _strbuf_par_chunk {
+    const char *buf;
+    size_t len;
+    const char *needle;
+    size_t n;
+    // the chunk holds the matches starting in [begin, end)
+    size_t begin;
+    size_t end;
+    size_t *matches;
+    size_t count;
+    size_t cap;
+    bool failed;
+    // output of a replacement
+    const char *t;
+    size_t lent;
+    size_t in_begin;
+    size_t in_end;
+    char *out;
+} _strbuf_par_chunk;
+
+// finds the next match at or after pos that starts before the end of the chunk
+static bool _strbuf_par_next(_strbuf_par_chunk *c, size_t pos, size_t *match) {
+    size_t limit = c->end + c->n - 1 < c->len ? c->end + c->n - 1 : c->len;
+    if (pos >= limit) return false;
+    const char *p = strbuf_memmem(c->buf + pos, limit - pos, c->needle, c->n);
+    if (!p || (size_t) (p - c->buf) >= c->end) return false;
+    *match = p - c->buf;
+    return true;
+}
+
+static bool _strbuf_par_push(_strbuf_par_chunk *c, size_t match) {
+    if (c->count == c->cap) {
+        size_t cap = c->cap ? 2 * c->cap : 64;
+        size_t *m = realloc(c->matches, cap * sizeof(size_t));
+        if (!m) return false;
+        c->matches = m;
+        c->cap = cap;
+    }
+    c->matches[c->count++] = match;
+    return true;
+}
+
+static void *_strbuf_par_find_chunk(void *arg) {
+    _strbuf_par_chunk *c = arg;
+    size_t pos = c->begin, match;
+    while (_strbuf_par_next(c, pos, &match)) {
+        if (!_strbuf_par_push(c, match)) {
+            c->failed = true;
+            break;
+        }
+        pos = match + c->n;
+    }
+    return NULL;
+}
+
+static void *_strbuf_par_fill_chunk(void *arg) {
+    _strbuf_par_chunk *c = arg;
+    const char *in = c->buf + c->in_begin;
+    char *out = c->out;
+    for (size_t i = 0; i < c->count; ++i) {
+        const char *m = c->buf + c->matches[i];
+        memcpy(out, in, m - in);
+        out += m - in;
+        memcpy(out, c->t, c->lent);
+        out += c->lent;
+        in = m + c->n;
+    }
+    memcpy(out, in, c->buf + c->in_end - in);
+    return NULL;
+}
+
+static size_t _strbuf_par_threads(size_t threads, size_t len, size_t n) {
+    // a match may only reach into the next chunk
+    return _clz_threads(threads, len, n > CLZ_STRBUF_PARALLEL_MIN ? n : CLZ_STRBUF_PARALLEL_MIN);
+}
+
+// searches all chunks in parallel and merges their matches, returns the chunks or NULL
+static _strbuf_par_chunk *_strbuf_par_find(char *buf, const char *s, size_t threads, size_t *nchunks) {
+    size_t len = strbuf_length(buf), n = strlen(s);
+    size_t count = _strbuf_par_threads(threads, len, n);
+    _strbuf_par_chunk *chunks = calloc(count, sizeof(_strbuf_par_chunk));
+    if (!chunks) return NULL;
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].buf = buf;
+        chunks[i].len = len;
+        chunks[i].needle = s;
+        chunks[i].n = n;
+        chunks[i].begin = len / count * i;
+        chunks[i].end = i + 1 == count ? len : len / count * (i + 1);
+    }
+    _clz_run(_strbuf_par_find_chunk, chunks, sizeof(_strbuf_par_chunk), count);
+
+    bool failed = false;
+    size_t last_end = 0;
+    for (size_t i = 0; i < count && !failed; ++i) {
+        _strbuf_par_chunk *c = chunks + i;
+        failed = c->failed;
+        c->in_begin = last_end > c->begin ? last_end : c->begin;
+        if (i) chunks[i - 1].in_end = c->in_begin;
+
+        if (!failed && last_end > c->begin) {
+            // the last match reaches into this chunk: search again from its end until the matches agree
+            _strbuf_par_chunk fixed = *c;
+            fixed.matches = NULL;
+            fixed.count = fixed.cap = 0;
+            size_t pos = last_end, match, j = 0;
+            bool synced = false;
+            while (!failed && _strbuf_par_next(c, pos, &match)) {
+                while (j < c->count && c->matches[j] < match) ++j;
+                if ((synced = j < c->count && c->matches[j] == match)) break;
+                failed = !_strbuf_par_push(&fixed, match);
+                pos = match + n;
+            }
+            for (; synced && !failed && j < c->count; ++j) failed = !_strbuf_par_push(&fixed, c->matches[j]);
+            free(c->matches);
+            c->matches = fixed.matches;
+            c->count = fixed.count;
+            c->cap = fixed.cap;
+        }
+        if (c->count) last_end = c->matches[c->count - 1] + n;
+    }
+    chunks[count - 1].in_end = len;
+
+    if (failed) {
+        for (size_t i = 0; i < count; ++i) free(chunks[i].matches);
+        free(chunks);
+        errno = ENOMEM;
+        return NULL;
+    }
+    *nchunks = count;
+    return chunks;
+}
+
+static void _strbuf_par_free(_strbuf_par_chunk *chunks, size_t count) {
+    for (size_t i = 0; i < count; ++i) free(chunks[i].matches);
+    free(chunks);
+}
+
+typedef struct _strbuf_par_first {
+    const char *buf;
+    size_t len;
+    const char *needle;
+    size_t n;
+    size_t piece;
+    size_t pieces;
+    size_t next;
+    size_t best;
+    size_t *found;
+} _strbuf_par_first;
+
+static void *_strbuf_par_first_worker(void *arg) {
+    _strbuf_par_first *f = arg;
+    for (;;) {
+        size_t i = __atomic_fetch_add(&f->next, 1, __ATOMIC_RELAXED);
+        // pieces are handed out in ascending order, so none after a piece with a match can hold the first one
+        if (i >= f->pieces || i > __atomic_load_n(&f->best, __ATOMIC_RELAXED)) return NULL;
+        size_t begin = i * f->piece, end = begin + f->piece + f->n - 1;
+        if (end > f->len) end = f->len;
+        const char *p = strbuf_memmem(f->buf + begin, end - begin, f->needle, f->n);
+        if (!p) continue;
+
+        f->found[i] = p - f->buf;
+        size_t best = __atomic_load_n(&f->best, __ATOMIC_RELAXED);
+        while (i < best && !__atomic_compare_exchange_n(&f->best, &best, i, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        return NULL;
+    }
+}
+
+static ssize_t _strbuf_par_find_first(const char *buf, size_t len, const char *s, size_t n) {
+    const char *p = strbuf_memmem(buf, len, s, n);
+    return p ? p - buf : CLZ_NOT_FOUND;
+}
+
+ssize_t strbuf_find_first_str_parallel(char **destbuf, char *s, size_t threads) {
+    size_t len = strbuf_length(*destbuf), n = strlen(s);
+    threads = _strbuf_par_threads(threads, len, n);
+    if (threads == 1 || !n) return _strbuf_par_find_first(*destbuf, len, s, n);
+
+    // several pieces per thread, so that the search stops soon after the first match
+    size_t piece = len / (8 * threads), min = CLZ_STRBUF_PARALLEL_MIN / 8;
+    if (piece < min) piece = min;
+    _strbuf_par_first f = {
+        .buf = *destbuf, .len = len, .needle = s, .n = n,
+        .piece = piece ? piece : 1,
+        .best = SIZE_MAX
+    };
+    f.pieces = (len + f.piece - 1) / f.piece;
+    f.found = malloc(f.pieces * sizeof(size_t));
+    if (!f.found) return _strbuf_par_find_first(*destbuf, len, s, n);
+    // all threads share the same state
+    _clz_run(_strbuf_par_first_worker, &f, 0, threads);
+
+    ssize_t ret = f.best == SIZE_MAX ? CLZ_NOT_FOUND : (ssize_t) f.found[f.best];
+    free(f.found);
+    return ret;
+}
+
+size_t strbuf_find_all_str_parallel(char **destbuf, char *s, size_t **offsets, size_t threads) {
+    *offsets = NULL;
+    size_t count, total = 0;
+    if (!*s) return 0;
+    _strbuf_par_chunk *chunks = _strbuf_par_find(*destbuf, s, threads, &count);
+    if (!chunks) return 0;
+
+    for (size_t i = 0; i < count; ++i) total += chunks[i].count;
+    if (total && (*offsets = malloc(total * sizeof(size_t))) == NULL) {
+        _strbuf_par_free(chunks, count);
+        return 0;
+    }
+    for (size_t i = 0, j = 0; i < count; j += chunks[i].count, ++i) {
+        if (chunks[i].count) memcpy(*offsets + j, chunks[i].matches, chunks[i].count * sizeof(size_t));
+    }
+    _strbuf_par_free(chunks, count);
+    return total;
+}
+
+size_t strbuf_replace_all_str_parallel(char **destbuf, char *s, char *t, size_t threads) {
+    size_t count, total = 0, n = strlen(s), lent = strlen(t), outlen = 0;
+    if (!n) return 0;
+    _strbuf_par_chunk *chunks = _strbuf_par_find(*destbuf, s, threads, &count);
+    if (!chunks) return 0;
+
+    for (size_t i = 0; i < count; ++i) total += chunks[i].count;
+    char *newbuf = NULL;
+    if (total) {
+        size_t len = strbuf_length(*destbuf);
+        newbuf = strbuf_new_size(len - total * n + total * lent + 1);
+    }
+    if (!newbuf) {
+        _strbuf_par_free(chunks, count);
+        return 0;
+    }
+    if (strbuf_is_binary(*destbuf)) strbuf_make_binary(&newbuf);
+
+    // prefix sum of the output sizes of the chunks
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].t = t;
+        chunks[i].lent = lent;
+        chunks[i].out = newbuf + outlen;
+        outlen += chunks[i].in_end - chunks[i].in_begin - chunks[i].count * n + chunks[i].count * lent;
+    }
+    _clz_run(_strbuf_par_fill_chunk, chunks, sizeof(_strbuf_par_chunk), count);
+    strbuf_set_length(&newbuf, outlen);
+
+    _strbuf_par_free(chunks, count);
+    strbuf_free(*destbuf);
+    *destbuf = newbuf;
+    return total;
+}
+
+#endif
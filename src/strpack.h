@@ -0,0 +1,393 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a binary file format for lists of strings, typically a @ref dynarray of strbufs, that
+ * can be loaded without parsing: the file is mapped into memory with `mmap` and every entry is available as a
+ * @ref clz_view pointing into the mapping. Loading a pack therefore costs a few system calls regardless of the
+ * number of entries, and pages are only read from disk when the entries on them are accessed.
+ *
+ * The file consists of
+ *  - a header of 32 bytes: the magic `"CLZSPK1"` with its null-terminator, a byte order mark, the number of
+ *    entries `count` and the size of the data section, all as native 32 or 64-bit integers,
+ *  - an offset table of `count + 1` 64-bit offsets into the data section, entry `i` spanning from `offsets[i]`
+ *    to `offsets[i + 1]`,
+ *  - the data section, holding the entries one after another, each followed by a null-terminator.
+ *
+ * Since every entry is null-terminated in the file, the `ptr` of a view returned by @ref strpack_get can also
+ * be used as a regular C-string, as long as the entry contains no null bytes. Binary strbufs are written with
+ * their full length, and their views have the same `len`. Packs can only be loaded on machines with the same
+ * byte order as the writer.
+ *
+ * Example:
+ *
+ * @code
+ *     strpack_write_file("names.pack", names); // names is a dynarray of strbufs
+ *
+ *     strpack *p = strpack_open("names.pack");
+ *     for (size_t i = 0; i < strpack_count(p); ++i) {
+ *         clz_view v = strpack_get(p, i);
+ *         printf("%.*s\n", (int) v.len, v.ptr);
+ *     }
+ *     strpack_close(p);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_STRPACK_IMPL` is defined beforehand. It requires a POSIX
+ * system (`writev` and `mmap`) and the implementation of @ref strbuf.h.
+ *
+ * @file strpack.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a memory-mapped binary format for lists of strings
+ *
+ */
+
+#ifndef _CLZ_STRPACK_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_STRPACK_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * @brief The magic at the beginning of every pack, including its null-terminator
+ */
+#define CLZ_STRPACK_MAGIC "CLZSPK1"
+
+/**
+ * @brief The byte order mark of the header, as written by the machine that created the pack
+ */
+#define CLZ_STRPACK_BOM 0x01020304u
+
+/**
+ * Macro defining the number of entries written by a single `writev` call.
+ */
+#ifndef CLZ_STRPACK_CHUNK
+#define CLZ_STRPACK_CHUNK 512
+#endif
+
+/**
+ * @brief Definition of structure representing the header of a pack file
+ */
+typedef struct strpack_header {
+    /**
+     * @brief @ref CLZ_STRPACK_MAGIC
+     */
+    char magic[8];
+    /**
+     * @brief @ref CLZ_STRPACK_BOM
+     */
+    uint32_t bom;
+    /**
+     * @brief Reserved, `0`
+     */
+    uint32_t flags;
+    /**
+     * @brief The number of entries
+     */
+    uint64_t count;
+    /**
+     * @brief The size of the data section in bytes
+     */
+    uint64_t data_size;
+} strpack_header;
+
+/**
+ * @brief Definition of structure representing a loaded pack
+ *
+ * **Notes**
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ * Use the provided API instead!
+ *
+ * @see strpack_open, strpack_get, strpack_close
+ */
+typedef struct strpack {
+    /**
+     * @brief The mapping of the whole file
+     */
+    const char *map;
+    /**
+     * @brief The size of the mapping
+     */
+    size_t map_size;
+    /**
+     * @brief The number of entries
+     */
+    size_t count;
+    /**
+     * @brief The offset table, `count + 1` entries
+     */
+    const uint64_t *offsets;
+    /**
+     * @brief The data section
+     */
+    const char *data;
+} strpack;
+
+/**
+ * @brief Writes a list of strings in the pack format to a file descriptor
+ *
+ * The elements of `strs` must be strbufs, whose lengths are taken with @ref strbuf_length, so that binary strbufs
+ * are written whole. The header and the offset table are written with a single `writev`, the entries with one
+ * `writev` per @ref CLZ_STRPACK_CHUNK entries, directly from the strings and without copying them.
+ *
+ * Since heap allocation and I/O take place, failure is possible. In this case, `false` is returned and `errno` is
+ * set accordingly. The file may then hold a partial pack, which @ref strpack_open rejects.
+ *
+ * @param fd The file descriptor, positioned where the pack has to start
+ * @param strs The strings
+ * @return `true` if successful
+ *
+ * @see strpack_write_file, strpack_open
+ */
+bool strpack_write(int fd, dynarray *strs);
+/**
+ * @brief Writes a list of strings in the pack format to a file, replacing its contents
+ *
+ * @param path The path of the file
+ * @param strs The strings
+ * @return `true` if successful
+ *
+ * @see strpack_write
+ */
+bool strpack_write_file(const char *path, dynarray *strs);
+/**
+ * @brief Maps a pack file into memory
+ *
+ * The header and the offset table are validated, the data section is only read when its entries are accessed.
+ * If the file cannot be opened or mapped, or is not a valid pack, `NULL` is returned and `errno` is set (`EINVAL`
+ * for invalid packs).
+ *
+ * **Notes**
+ *
+ * Use @ref strpack_close on packs returned by this function after done using. The views returned by
+ * @ref strpack_get are invalidated by it.
+ *
+ * @param path The path of the file
+ * @return The pack if successful, `NULL` otherwise
+ *
+ * @see strpack_get, strpack_close
+ */
+strpack *strpack_open(const char *path);
+/**
+ * @brief Unmaps a pack and frees it
+ *
+ * @param p The pack
+ */
+void strpack_close(strpack *p);
+/**
+ * @brief Returns an entry of a pack without copying it
+ *
+ * The view points into the mapping and its `ptr` is null-terminated. If `index` is out of bounds or the entry is
+ * corrupt, a view with `ptr == NULL` and `len == 0` is returned.
+ *
+ * @param p The pack
+ * @param index The index of the entry
+ * @return The view of the entry
+ */
+clz_view strpack_get(strpack *p, size_t index);
+/**
+ * @brief Appends all entries of a pack to a @ref dynarray as C-strings pointing into the mapping
+ *
+ * No string is copied, so the entries are only valid until @ref strpack_close and must not be modified or freed.
+ * Corrupt entries are appended as `NULL`.
+ *
+ * @param p The pack
+ * @param d The @ref dynarray
+ * @return `true` if successful, `false` if heap allocation failed
+ */
+bool strpack_to_dynarray(strpack *p, dynarray *d);
+
+/**
+ * @brief Returns the number of entries of a pack
+ */
+#define strpack_count(p) ((p)->count)
+
+#endif
+
+#ifdef CLZ_STRPACK_IMPL
+#undef CLZ_STRPACK_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#if defined(IOV_MAX) && IOV_MAX < CLZ_STRPACK_CHUNK
+#define _CLZ_STRPACK_IOV IOV_MAX
+#else
+#define _CLZ_STRPACK_IOV CLZ_STRPACK_CHUNK
+#endif
+
+static bool _strpack_writev_all(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // skip the buffers that were written completely, then the written part of the next one
+        while (iovcnt > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+bool strpack_write(int fd, dynarray *strs) {
+    size_t count = dynarray_length(strs);
+    uint64_t *offsets = malloc((count + 1) * sizeof(uint64_t));
+    if (offsets == NULL) return false;
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i) {
+        offsets[i + 1] = offsets[i] + strbuf_length(dynarray_at(strs, i)) + 1;
+    }
+
+    strpack_header h = {.magic = CLZ_STRPACK_MAGIC, .bom = CLZ_STRPACK_BOM, .flags = 0,
+                        .count = count, .data_size = offsets[count]};
+    struct iovec iov[_CLZ_STRPACK_IOV];
+    iov[0] = (struct iovec) {.iov_base = &h, .iov_len = sizeof(h)};
+    iov[1] = (struct iovec) {.iov_base = offsets, .iov_len = (count + 1) * sizeof(uint64_t)};
+    bool ok = _strpack_writev_all(fd, iov, 2);
+
+    size_t chunk = sizeof(iov) / sizeof(iov[0]);
+    for (size_t i = 0; ok && i < count; i += chunk) {
+        size_t n = count - i < chunk ? count - i : chunk;
+        for (size_t j = 0; j < n; ++j) {
+            // the null-terminator of every string is written as well
+            iov[j].iov_base = dynarray_at(strs, i + j);
+            iov[j].iov_len = offsets[i + j + 1] - offsets[i + j];
+        }
+        ok = _strpack_writev_all(fd, iov, (int) n);
+    }
+
+    int err = errno;
+    free(offsets);
+    errno = err;
+    return ok;
+}
+
+bool strpack_write_file(const char *path, dynarray *strs) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = strpack_write(fd, strs);
+    int err = errno;
+    if (close(fd) != 0 && ok) return false;
+    errno = err;
+    return ok;
+}
+
+strpack *strpack_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if ((size_t) st.st_size < sizeof(strpack_header)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t size = (size_t) st.st_size;
+    const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = err;
+        return NULL;
+    }
+
+    const strpack_header *h = (const strpack_header *) map;
+    size_t table = sizeof(strpack_header);
+    bool valid = memcmp(h->magic, CLZ_STRPACK_MAGIC, sizeof(h->magic)) == 0 && h->bom == CLZ_STRPACK_BOM
+                 && h->count < (size - table) / sizeof(uint64_t)
+                 && h->data_size == size - table - (h->count + 1) * sizeof(uint64_t);
+
+    const uint64_t *offsets = (const uint64_t *) (map + table);
+    for (size_t i = 0; valid && i < h->count; ++i) {
+        valid = offsets[i] < offsets[i + 1];
+    }
+    valid = valid && offsets[0] == 0 && offsets[h->count] == h->data_size;
+
+    strpack *p = valid ? malloc(sizeof(strpack)) : NULL;
+    if (p == NULL) {
+        munmap((void *) map, size);
+        errno = valid ? ENOMEM : EINVAL;
+        return NULL;
+    }
+
+    p->map = map;
+    p->map_size = size;
+    p->count = h->count;
+    p->offsets = offsets;
+    p->data = map + table + (h->count + 1) * sizeof(uint64_t);
+    return p;
+}
+
+void strpack_close(strpack *p) {
+    munmap((void *) p->map, p->map_size);
+    free(p);
+}
+
+clz_view strpack_get(strpack *p, size_t index) {
+    clz_view v = {NULL, 0};
+    if (index >= p->count) return v;
+    const char *start = p->data + p->offsets[index], *end = p->data + p->offsets[index + 1] - 1;
+    if (*end != '\0') return v;
+    v.ptr = start;
+    v.len = end - start;
+    return v;
+}
+
+bool strpack_to_dynarray(strpack *p, dynarray *d) {
+    for (size_t i = 0; i < p->count; ++i) {
+        size_t len = dynarray_length(d);
+        dynarray_append(d, (void *) strpack_get(p, i).ptr);
+        if (dynarray_length(d) == len) return false;
+    }
+    return true;
+}
+
+#endif
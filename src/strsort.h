@@ -0,0 +1,294 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a sort for arrays of strbufs, which reorders the `ptr` array of a @ref dynarray in place.
+ * Two orders are available, neither of which depends on the locale:
+ *
+ * - `STRSORT_BYTES` compares the bytes as unsigned values, a string coming before the longer strings it is a
+ *   prefix of. This is the order of `memcmp`, and of `strcmp` for strings without null bytes.
+ * - `STRSORT_NATURAL` compares runs of decimal digits by their numeric value, so that `"file2"` comes before
+ *   `"file10"`. Other bytes are compared as in `STRSORT_BYTES`.
+ *
+ * Sorting with `qsort` and `strcmp` dereferences two strings per comparison, and most of these reads miss the cache
+ * once the array is large. The byte order is instead sorted with a multikey quicksort on cached prefixes: the next
+ * 8 bytes of every string are loaded once into an array next to its pointer, as a big-endian integer, and the
+ * array is partitioned in three around a pivot prefix. The strings with a smaller or larger prefix are sorted
+ * further at the same depth, while those with an equal prefix move on to the next 8 bytes, so each byte of a
+ * string is read a single time unless it is shared with other strings. Ranges of at most
+ * @ref CLZ_STRSORT_INSERTION strings are finished with an insertion sort.
+ *
+ * The natural order has no such prefix and is sorted with `qsort` on the same array of pointers.
+ *
+ * Example:
+ *
+ * @code
+ *     dynarray files;
+ *     dynarray_init(&files);
+ *     ... // append strbufs
+ *     if (!strsort(&files, STRSORT_NATURAL)) return false;
+ * @endcode
+ *
+ * **Notes**
+ *
+ * The sort is not stable, which only matters for strbufs with the same contents.
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_STRSORT_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h.
+ *
+ * @file strsort.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for sorting arrays of strbufs
+ *
+ */
+
+#ifndef _CLZ_STRSORT_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_STRSORT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * Macro defining the size of the ranges sorted with an insertion sort instead of being partitioned further.
+ */
+#ifndef CLZ_STRSORT_INSERTION
+#define CLZ_STRSORT_INSERTION 16
+#endif
+
+/**
+ * @brief Definition of enum representing the order of a sort
+ *
+ *  - `STRSORT_BYTES` for the order of the bytes as unsigned values
+ *  - `STRSORT_NATURAL` for the same order, except that runs of digits are compared by their numeric value
+ */
+enum strsort_order {
+    STRSORT_BYTES, STRSORT_NATURAL
+};
+
+/**
+ * @brief Sorts a @ref dynarray of strbufs.
+ *
+ * Only the pointers of the array are moved. The strbufs may be binary, see @ref strbuf_make_binary.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned, `errno` is set to `ENOMEM`
+ * and the array is left unchanged.
+ *
+ * @param d The array of strbufs
+ * @param order The order to sort in
+ * @return `true` if successful
+ *
+ * @see strsort_natural_cmp
+ */
+bool strsort(dynarray *d, enum strsort_order order);
+/**
+ * @brief Compares two strings in natural order.
+ *
+ * Runs of decimal digits are compared by their numeric value, ignoring leading zeros, and all other bytes as
+ * unsigned values. Runs of equal value, as `"07"` and `"7"`, are only told apart by their bytes if the strings
+ * are otherwise equal.
+ *
+ * @param a The first string, which may contain null bytes
+ * @param alen The length of the first string
+ * @param b The second string, which may contain null bytes
+ * @param blen The length of the second string
+ * @return A negative value, `0` or a positive value if `a` comes before, is equal to or comes after `b`
+ */
+int strsort_natural_cmp(const char *a, size_t alen, const char *b, size_t blen);
+
+#endif
+
+#ifdef CLZ_STRSORT_IMPL
+#undef CLZ_STRSORT_IMPL
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+struct _strsort_entry {
+    // the 8 bytes at the current depth, big-endian and padded with zeros
+    uint64_t key;
+    char *s;
+    size_t len;
+};
+
+static inline void _strsort_load(struct _strsort_entry *e, size_t n, size_t depth) {
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned char *p = (const unsigned char *) e[i].s + depth;
+        size_t m = e[i].len > depth ? e[i].len - depth : 0;
+        uint64_t key = 0;
+        if (m >= 8) {
+            for (int k = 0; k < 8; ++k) key = key << 8 | p[k];
+        } else {
+            for (size_t k = 0; k < 8; ++k) key = key << 8 | (k < m ? p[k] : 0);
+        }
+        e[i].key = key;
+    }
+}
+
+static inline int _strsort_cmp_bytes(struct _strsort_entry *a, struct _strsort_entry *b, size_t depth) {
+    size_t n = a->len < b->len ? a->len : b->len;
+    int c = n > depth ? memcmp(a->s + depth, b->s + depth, n - depth) : 0;
+    if (c) return c;
+    return a->len < b->len ? -1 : a->len > b->len;
+}
+
+static void _strsort_insertion(struct _strsort_entry *e, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; ++i) {
+        struct _strsort_entry x = e[i];
+        size_t j = i;
+        for (; j > 0 && _strsort_cmp_bytes(e + j - 1, &x, depth) > 0; --j) e[j] = e[j - 1];
+        e[j] = x;
+    }
+}
+
+static inline void _strsort_swap(struct _strsort_entry *a, struct _strsort_entry *b) {
+    struct _strsort_entry t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static inline uint64_t _strsort_median(uint64_t a, uint64_t b, uint64_t c) {
+    if (a < b) return b < c ? b : a < c ? c : a;
+    return a < c ? a : b < c ? c : b;
+}
+
+// sorts entries whose first `depth` bytes are equal and whose keys are loaded at `depth`
+static void _strsort_mkqs(struct _strsort_entry *e, size_t n, size_t depth) {
+    while (n > CLZ_STRSORT_INSERTION) {
+        uint64_t pivot = _strsort_median(e[0].key, e[n / 2].key, e[n - 1].key);
+
+        // [0, lt) < pivot, [lt, i) == pivot, [gt, n) > pivot
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            if (e[i].key < pivot) _strsort_swap(e + lt++, e + i++);
+            else if (e[i].key > pivot) _strsort_swap(e + i, e + --gt);
+            else ++i;
+        }
+
+        // the strings ending within the key are equal to the pivot up to their length, the shorter ones first
+        size_t done = lt;
+        for (size_t j = lt; j < gt; ++j) {
+            if (e[j].len <= depth + 8) _strsort_swap(e + done++, e + j);
+        }
+        // a string ending before the last byte of the key has a zero there, otherwise all have the same length
+        if (!(pivot & 0xFF) && done - lt > 1) {
+            for (size_t k = 0, next = lt; k < 8; ++k) {
+                for (size_t j = next; j < done; ++j) {
+                    if (e[j].len == depth + k) _strsort_swap(e + next++, e + j);
+                }
+            }
+        }
+        struct _strsort_entry *eq = e + done;
+        size_t neq = gt - done;
+        if (neq) _strsort_load(eq, neq, depth + 8);
+
+        // the largest part is sorted in this loop, the two others by recursion, so that the stack stays shallow
+        size_t nlt = lt, ngt = n - gt;
+        if (neq >= nlt && neq >= ngt) {
+            _strsort_mkqs(e, nlt, depth);
+            _strsort_mkqs(e + gt, ngt, depth);
+            e = eq;
+            n = neq;
+            depth += 8;
+        } else if (nlt >= ngt) {
+            _strsort_mkqs(eq, neq, depth + 8);
+            _strsort_mkqs(e + gt, ngt, depth);
+            n = nlt;
+        } else {
+            _strsort_mkqs(e, nlt, depth);
+            _strsort_mkqs(eq, neq, depth + 8);
+            e += gt;
+            n = ngt;
+        }
+    }
+    _strsort_insertion(e, n, depth);
+}
+
+int strsort_natural_cmp(const char *a, size_t alen, const char *b, size_t blen) {
+    const unsigned char *p = (const unsigned char *) a, *q = (const unsigned char *) b;
+    size_t i = 0, j = 0;
+    while (i < alen && j < blen) {
+        bool da = p[i] >= '0' && p[i] <= '9', db = q[j] >= '0' && q[j] <= '9';
+        if (!da || !db) {
+            if (p[i] != q[j]) return p[i] < q[j] ? -1 : 1;
+            ++i;
+            ++j;
+            continue;
+        }
+
+        while (i < alen && p[i] == '0') ++i;
+        while (j < blen && q[j] == '0') ++j;
+        size_t si = i, sj = j;
+        while (i < alen && p[i] >= '0' && p[i] <= '9') ++i;
+        while (j < blen && q[j] >= '0' && q[j] <= '9') ++j;
+        // without leading zeros, the longer run is the larger number
+        if (i - si != j - sj) return i - si < j - sj ? -1 : 1;
+        int c = memcmp(p + si, q + sj, i - si);
+        if (c) return c;
+    }
+    if (i < alen || j < blen) return i < alen ? 1 : -1;
+
+    // equal up to leading zeros
+    size_t n = alen < blen ? alen : blen;
+    int c = memcmp(a, b, n);
+    if (c) return c;
+    return alen < blen ? -1 : alen > blen;
+}
+
+static int _strsort_cmp_natural(const void *x, const void *y) {
+    const struct _strsort_entry *a = x, *b = y;
+    return strsort_natural_cmp(a->s, a->len, b->s, b->len);
+}
+
+bool strsort(dynarray *d, enum strsort_order order) {
+    size_t n = dynarray_length(d);
+    if (n < 2) return true;
+    struct _strsort_entry *e = malloc(n * sizeof(struct _strsort_entry));
+    if (!e) {
+        errno = ENOMEM;
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        e[i].s = dynarray_at(d, i);
+        e[i].len = strbuf_length(e[i].s);
+    }
+
+    if (order == STRSORT_NATURAL) {
+        qsort(e, n, sizeof(struct _strsort_entry), _strsort_cmp_natural);
+    } else {
+        _strsort_load(e, n, 0);
+        _strsort_mkqs(e, n, 0);
+    }
+
+    for (size_t i = 0; i < n; ++i) dynarray_at(d, i) = e[i].s;
+    free(e);
+    return true;
+}
+
+#endif
@@ -0,0 +1,332 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a builder for aligned text tables. Cells are added row by row as views on strings
+ * owned by the caller, which must stay valid until the table is rendered. Each column can be aligned to the left,
+ * to the right or centered, and each cell can be given a style such as @ref COL_BOLD_RED, which is reset after it.
+ *
+ * The display width of a cell is computed once, when it is added (see @ref strbuf_display_width_bytes), and
+ * the width of its column is updated at the same time. Rendering then knows the size of the output before writing
+ * it: the destination strbuf is grown at most once, and the cells and their padding are written into it directly
+ * with `memcpy` and `memset`, with no temporary buffer per cell.
+ *
+ * The last column is not padded when it is aligned to the left, so that lines have no trailing spaces.
+ *
+ * Example:
+ *
+ * @code
+ *     table t;
+ *     if (!table_init(&t, 3, "  ")) return false;
+ *     table_align(&t, 2, TABLE_RIGHT);
+ *     table_add(&t, "host", 4, COL_BOLD_BLUE);
+ *     table_add(&t, "status", 6, COL_BOLD_BLUE);
+ *     table_add(&t, "latency", 7, COL_BOLD_BLUE);
+ *     for (size_t i = 0; i < n; ++i) {
+ *         table_add(&t, hosts[i], strbuf_length(hosts[i]), NULL);
+ *         table_add(&t, up[i] ? "up" : "down", up[i] ? 2 : 4, up[i] ? COL_GREEN : COL_RED);
+ *         table_add(&t, latencies[i], strbuf_length(latencies[i]), NULL);
+ *     }
+ *     table_render(&t, &report);
+ *     table_free(&t);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_TABLE_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h.
+ *
+ * @file table.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a text table formatter
+ *
+ */
+
+#ifndef _CLZ_TABLE_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_TABLE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "clz.h"
+#include "color.h"
+#include "strbuf.h"
+
+/**
+ * @brief Definition of enum representing the alignment of a column
+ *
+ *  - `TABLE_LEFT` pads the cells on the right, the default
+ *  - `TABLE_RIGHT` pads the cells on the left, as is usual for numbers
+ *  - `TABLE_CENTER` pads the cells on both sides, with the extra column on the right
+ */
+enum table_align {
+    TABLE_LEFT, TABLE_RIGHT, TABLE_CENTER
+};
+
+/**
+ * @brief Definition of a text table
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct table {
+    /**
+     * @brief The cells, row by row
+     */
+    struct _table_cell *cells;
+    /**
+     * @brief The number of cells
+     */
+    size_t ncells;
+    /**
+     * @brief The number of cells the array can hold
+     */
+    size_t cap;
+    /**
+     * @brief The number of columns
+     */
+    size_t ncols;
+    /**
+     * @brief The display width of every column
+     */
+    size_t *widths;
+    /**
+     * @brief The alignment of every column
+     */
+    enum table_align *align;
+    /**
+     * @brief The string written between two columns
+     */
+    const char *sep;
+    /**
+     * @brief The length of the separator
+     */
+    size_t seplen;
+} table;
+
+/**
+ * @brief Initializes an empty table.
+ *
+ * All columns are aligned to the left. The separator is not copied and must stay valid as long as the table.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param t The table to initialize
+ * @param ncols The number of columns, at least `1`
+ * @param sep The null-terminated string written between two columns, such as `" | "`
+ * @return `true` if successful
+ *
+ * @see table_free, table_add
+ */
+bool table_init(table *t, size_t ncols, const char *sep);
+/**
+ * @brief Frees the memory held by a table.
+ *
+ * The strings of the cells are not freed, as they belong to the caller.
+ *
+ * @param t The table
+ */
+void table_free(table *t);
+/**
+ * @brief Sets the alignment of a column.
+ *
+ * @param t The table
+ * @param col The index of the column, which must be smaller than the number of columns
+ * @param align The alignment
+ */
+void table_align(table *t, size_t col, enum table_align align);
+/**
+ * @brief Adds a cell to the table.
+ *
+ * Cells fill the rows from left to right, a new row being started once the current one has as many cells as
+ * there are columns. The string is not copied and must stay valid until the table is rendered. It should not
+ * contain newlines.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned and `errno` is set to `ENOMEM`.
+ *
+ * @param t The table
+ * @param s The string of the cell
+ * @param len The length of the string
+ * @param style The null-terminated escape sequence written before the cell, such as @ref COL_RED, or `NULL`
+ * @return `true` if successful
+ */
+bool table_add(table *t, const char *s, size_t len, const char *style);
+/**
+ * @brief Appends the rendered table to a strbuf.
+ *
+ * Every row ends with a newline. If the last row is incomplete, its missing cells are rendered as empty.
+ * Styled cells are followed by @ref COL_RESET, and their padding is left unstyled.
+ *
+ * The buffer is `realloc`'d at most once. Since heap allocation is used, failure is possible. In this case, `false`
+ * is returned, `errno` is set to `ENOMEM` and the buffer is left unchanged.
+ *
+ * @param t The table
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ */
+bool table_render(table *t, char **destbuf);
+
+/**
+ * @brief Returns the number of rows of a table, counting an incomplete last row.
+ */
+#define table_rows(t) (((t)->ncells + (t)->ncols - 1) / (t)->ncols)
+
+#endif
+
+#ifdef CLZ_TABLE_IMPL
+#undef CLZ_TABLE_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+struct _table_cell {
+    clz_view text;
+    const char *style;
+    size_t style_len;
+    size_t width;
+};
+
+bool table_init(table *t, size_t ncols, const char *sep) {
+    t->cells = NULL;
+    t->ncells = t->cap = 0;
+    t->ncols = ncols;
+    t->widths = calloc(ncols, sizeof(size_t));
+    t->align = calloc(ncols, sizeof(enum table_align));
+    t->sep = sep;
+    t->seplen = strlen(sep);
+    if (!t->widths || !t->align) {
+        table_free(t);
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+void table_free(table *t) {
+    free(t->cells);
+    free(t->widths);
+    free(t->align);
+    t->cells = NULL;
+    t->widths = NULL;
+    t->align = NULL;
+    t->ncells = t->cap = 0;
+}
+
+void table_align(table *t, size_t col, enum table_align align) {
+    t->align[col] = align;
+}
+
+bool table_add(table *t, const char *s, size_t len, const char *style) {
+    if (t->ncells == t->cap) {
+        size_t cap = t->cap ? 2 * t->cap : 16 * t->ncols;
+        struct _table_cell *cells = realloc(t->cells, cap * sizeof(struct _table_cell));
+        if (!cells) {
+            errno = ENOMEM;
+            return false;
+        }
+        t->cells = cells;
+        t->cap = cap;
+    }
+    struct _table_cell *c = t->cells + t->ncells;
+    size_t col = t->ncells++ % t->ncols;
+    c->text = (clz_view) {s, len};
+    c->style = style;
+    c->style_len = style ? strlen(style) : 0;
+    c->width = strbuf_display_width_bytes(s, len);
+    if (c->width > t->widths[col]) t->widths[col] = c->width;
+    return true;
+}
+
+// the padding before and after a cell, or an empty cell if c is NULL
+static inline void _table_pad(table *t, struct _table_cell *c, size_t col, size_t *before, size_t *after) {
+    size_t pad = t->widths[col] - (c ? c->width : 0);
+    switch (t->align[col]) {
+        case TABLE_RIGHT:
+            *before = pad;
+            *after = 0;
+            break;
+        case TABLE_CENTER:
+            *before = pad / 2;
+            *after = pad - pad / 2;
+            break;
+        default:
+            *before = 0;
+            *after = pad;
+            break;
+    }
+    if (col == t->ncols - 1 && t->align[col] != TABLE_RIGHT) *after = 0;
+}
+
+bool table_render(table *t, char **destbuf) {
+    size_t rows = table_rows(t), reset_len = strlen(COL_RESET);
+
+    // first pass: the exact size of the output
+    size_t n = rows * ((t->ncols - 1) * t->seplen + 1);
+    for (size_t i = 0; i < rows * t->ncols; ++i) {
+        struct _table_cell *c = i < t->ncells ? t->cells + i : NULL;
+        size_t before, after;
+        _table_pad(t, c, i % t->ncols, &before, &after);
+        n += before + after;
+        if (c) n += c->text.len + (c->style ? c->style_len + reset_len : 0);
+    }
+
+    size_t dlen = strbuf_length(*destbuf);
+    if (strbuf_alloc_size(*destbuf) < dlen + n + 1 && !strbuf_resize(destbuf, dlen + n + 1)) {
+        errno = ENOMEM;
+        return false;
+    }
+
+    // second pass: the cells and their padding
+    char *p = *destbuf + dlen;
+    for (size_t i = 0; i < rows * t->ncols; ++i) {
+        struct _table_cell *c = i < t->ncells ? t->cells + i : NULL;
+        size_t col = i % t->ncols, before, after;
+        _table_pad(t, c, col, &before, &after);
+        memset(p, ' ', before);
+        p += before;
+        if (c && c->style) {
+            memcpy(p, c->style, c->style_len);
+            p += c->style_len;
+        }
+        if (c && c->text.len) {
+            memcpy(p, c->text.ptr, c->text.len);
+            p += c->text.len;
+        }
+        if (c && c->style) {
+            memcpy(p, COL_RESET, reset_len);
+            p += reset_len;
+        }
+        memset(p, ' ', after);
+        p += after;
+        if (col < t->ncols - 1) {
+            memcpy(p, t->sep, t->seplen);
+            p += t->seplen;
+        } else {
+            *p++ = '\n';
+        }
+    }
+    *p = '\0';
+    return strbuf_set_length(destbuf, dlen + n);
+}
+
+#endif
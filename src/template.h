@@ -0,0 +1,443 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a text template engine. A template is compiled once and can then be rendered any
+ * number of times into a strbuf. The following syntax is supported:
+ *
+ * - `{{name}}` is replaced by the value of `name`, escaped in the mode given to the rendering. Spaces around the
+ *   name are ignored.
+ * - `{{name|raw}}`, `{{name|html}}`, `{{name|json}}` and `{{name|url}}` use the given mode instead.
+ * - `\{{` is written as `{{`.
+ *
+ * Compiling splits the template into a list of segments, each one either a piece of the template written as is or
+ * a placeholder. The names of the placeholders are collected once, so that a name used several times is looked up
+ * a single time per rendering. Rendering first looks up all names and computes the exact length of the output,
+ * then grows the destination strbuf at most once and writes every segment into it directly. Replacing each
+ * placeholder with @ref strbuf_replace_all_str would instead scan and rebuild the whole string once per name.
+ *
+ * Values are given either by a callback, or by a @ref dynarray of strbufs holding names and values in turn.
+ * Placeholders without a value are rendered as empty.
+ *
+ * Example:
+ *
+ * @code
+ *     text_template t;
+ *     if (!template_compile(&t, "<p>Hello, {{ user }}!</p><a href=\"/u?n={{user|url}}\">", 0)) return false;
+ *     dynarray vars;
+ *     dynarray_init(&vars);
+ *     dynarray_append(&vars, strbuf_new_str("user"));
+ *     dynarray_append(&vars, strbuf_new_str("Tom & Jerry"));
+ *     template_render_dynarray(&t, &page, TEMPLATE_HTML, &vars);
+ *     template_free(&t);
+ * @endcode
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_TEMPLATE_IMPL` is defined beforehand. It requires the
+ * implementation of @ref strbuf.h and @ref dynarray.h.
+ *
+ * @file template.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a compiled text template engine
+ *
+ */
+
+#ifndef _CLZ_TEMPLATE_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_TEMPLATE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "clz.h"
+#include "strbuf.h"
+#include "dynarray.h"
+
+/**
+ * @brief Definition of enum representing how values are escaped
+ *
+ *  - `TEMPLATE_RAW` writes values as they are
+ *  - `TEMPLATE_HTML` escapes `&`, `<`, `>`, `"` and `'` as HTML entities, for text and quoted attributes
+ *  - `TEMPLATE_JSON` escapes values for the inside of a JSON string, leaving UTF-8 sequences as they are
+ *  - `TEMPLATE_URL` percent-encodes all bytes except the unreserved characters of RFC 3986
+ */
+enum template_escape {
+    TEMPLATE_RAW, TEMPLATE_HTML, TEMPLATE_JSON, TEMPLATE_URL
+};
+
+/**
+ * @brief Definition of a compiled template
+ *
+ * **Do not, under any circumstances, modify and values or pointers belonging to member fiends of this struct**.
+ */
+typedef struct text_template {
+    /**
+     * @brief A copy of the template
+     */
+    char *text;
+    /**
+     * @brief The segments, in order
+     */
+    struct _template_seg *segs;
+    /**
+     * @brief The number of segments
+     */
+    size_t nsegs;
+    /**
+     * @brief The distinct names of the placeholders, pointing into `text`
+     */
+    clz_view *names;
+    /**
+     * @brief The number of distinct names
+     */
+    size_t nnames;
+} text_template;
+
+/**
+ * @brief Compiles a template.
+ *
+ * The template is copied and need not stay valid after this call.
+ *
+ * On failure, `false` is returned and `errno` is set to `EINVAL` if a placeholder is not closed, has an empty name
+ * or an unknown mode, or to `ENOMEM` if heap allocation failed.
+ *
+ * @param t The template to initialize
+ * @param src The template, which may contain null bytes
+ * @param len The length of the template, or `0` if it is null-terminated
+ * @return `true` if successful
+ *
+ * @see template_free, template_render
+ */
+bool template_compile(text_template *t, const char *src, size_t len);
+/**
+ * @brief Frees the memory held by a compiled template.
+ *
+ * @param t The template
+ */
+void template_free(text_template *t);
+/**
+ * @brief Appends a rendered template to a strbuf, looking up values with a callback.
+ *
+ * The callback is called once per distinct name, in the order of their first use, with `arg`, the name, and where to
+ * store its value. It returns `false` if the name has no value. Values must stay valid until the rendering returns.
+ *
+ * The buffer is `realloc`'d at most once. Since heap allocation is used, failure is possible. In this case, `false`
+ * is returned, `errno` is set to `ENOMEM` and the buffer is left unchanged.
+ *
+ * @param t The template
+ * @param destbuf The destination buffer
+ * @param escape How values are escaped, unless a placeholder gives its own mode
+ * @param lookup The callback
+ * @param arg The first argument of the callback
+ * @return `true` if successful
+ */
+bool template_render(text_template *t, char **destbuf, enum template_escape escape,
+                     bool (*lookup)(void *, clz_view, clz_view *), void *arg);
+/**
+ * @brief Appends a rendered template to a strbuf, taking values from a @ref dynarray.
+ *
+ * The array holds strbufs, a name followed by its value. If a name appears several times, its first value is used.
+ *
+ * The buffer is `realloc`'d at most once. Since heap allocation is used, failure is possible. In this case, `false`
+ * is returned, `errno` is set to `ENOMEM` and the buffer is left unchanged.
+ *
+ * @param t The template
+ * @param destbuf The destination buffer
+ * @param escape How values are escaped, unless a placeholder gives its own mode
+ * @param vars The names and values
+ * @return `true` if successful
+ */
+bool template_render_dynarray(text_template *t, char **destbuf, enum template_escape escape, dynarray *vars);
+
+#endif
+
+#ifdef CLZ_TEMPLATE_IMPL
+#undef CLZ_TEMPLATE_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+// a placeholder has a name index and a mode, -1 standing for the mode of the rendering
+struct _template_seg {
+    size_t off;
+    size_t len;
+    size_t name;
+    int escape;
+    bool var;
+};
+
+static bool _template_push(text_template *t, size_t *cap, struct _template_seg seg) {
+    if (t->nsegs == *cap) {
+        size_t ncap = *cap ? 2 * *cap : 16;
+        struct _template_seg *segs = realloc(t->segs, ncap * sizeof(struct _template_seg));
+        if (!segs) return false;
+        t->segs = segs;
+        *cap = ncap;
+    }
+    t->segs[t->nsegs++] = seg;
+    return true;
+}
+
+static bool _template_name(text_template *t, size_t *cap, clz_view name, size_t *index) {
+    for (size_t i = 0; i < t->nnames; ++i) {
+        if (t->names[i].len == name.len && !memcmp(t->names[i].ptr, name.ptr, name.len)) {
+            *index = i;
+            return true;
+        }
+    }
+    if (t->nnames == *cap) {
+        size_t ncap = *cap ? 2 * *cap : 8;
+        clz_view *names = realloc(t->names, ncap * sizeof(clz_view));
+        if (!names) return false;
+        t->names = names;
+        *cap = ncap;
+    }
+    *index = t->nnames;
+    t->names[t->nnames++] = name;
+    return true;
+}
+
+static inline clz_view _template_trim(const char *s, size_t len) {
+    while (len && (*s == ' ' || *s == '\t')) ++s, --len;
+    while (len && (s[len - 1] == ' ' || s[len - 1] == '\t')) --len;
+    return (clz_view) {s, len};
+}
+
+static int _template_mode(clz_view v) {
+    static const char *modes[] = {"raw", "html", "json", "url"};
+    for (int i = 0; i < 4; ++i) {
+        if (strlen(modes[i]) == v.len && !memcmp(modes[i], v.ptr, v.len)) return i;
+    }
+    return -1;
+}
+
+bool template_compile(text_template *t, const char *src, size_t len) {
+    if (!len) len = strlen(src);
+    t->segs = NULL;
+    t->names = NULL;
+    t->nsegs = t->nnames = 0;
+    t->text = malloc(len + 1);
+    if (!t->text) {
+        errno = ENOMEM;
+        return false;
+    }
+    memcpy(t->text, src, len);
+    t->text[len] = '\0';
+
+    const char *s = t->text;
+    size_t segcap = 0, namecap = 0, lit = 0, i = 0;
+    int err = 0;
+    while (!err && i < len) {
+        const char *p = memchr(s + i, '{', len - i);
+        if (!p) break;
+        i = p - s;
+        if (i + 1 >= len || s[i + 1] != '{') {
+            ++i;
+            continue;
+        }
+        bool escaped = i > lit && s[i - 1] == '\\';
+        size_t end = escaped ? i - 1 : i;
+        if (end > lit && !_template_push(t, &segcap, (struct _template_seg) {lit, end - lit, 0, 0, false})) {
+            err = ENOMEM;
+            break;
+        }
+        if (escaped) {
+            lit = i;
+            i += 2;
+            continue;
+        }
+
+        size_t close = i + 2;
+        while (close + 1 < len && !(s[close] == '}' && s[close + 1] == '}')) ++close;
+        if (close + 1 >= len) {
+            err = EINVAL;
+            break;
+        }
+        clz_view body = {s + i + 2, close - i - 2}, mode = {NULL, 0};
+        const char *bar = memchr(body.ptr, '|', body.len);
+        if (bar) {
+            mode = _template_trim(bar + 1, body.ptr + body.len - bar - 1);
+            body.len = bar - body.ptr;
+        }
+        body = _template_trim(body.ptr, body.len);
+        int escape = bar ? _template_mode(mode) : -1;
+        size_t name;
+        if (!body.len || (bar && escape < 0)) {
+            err = EINVAL;
+        } else if (!_template_name(t, &namecap, body, &name)
+                   || !_template_push(t, &segcap, (struct _template_seg) {0, 0, name, escape, true})) {
+            err = ENOMEM;
+        }
+        i = lit = close + 2;
+    }
+    if (!err && lit < len && !_template_push(t, &segcap, (struct _template_seg) {lit, len - lit, 0, 0, false})) {
+        err = ENOMEM;
+    }
+
+    if (err) {
+        template_free(t);
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+void template_free(text_template *t) {
+    free(t->text);
+    free(t->segs);
+    free(t->names);
+    t->text = NULL;
+    t->segs = NULL;
+    t->names = NULL;
+    t->nsegs = t->nnames = 0;
+}
+
+static inline bool _template_url_safe(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+           || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+// the length of a byte once escaped, 1 if it is written as is
+static inline size_t _template_escaped_len(int escape, unsigned char c) {
+    switch (escape) {
+        case TEMPLATE_HTML:
+            return c == '&' || c == '\'' ? 5 : c == '<' || c == '>' ? 4 : c == '"' ? 6 : 1;
+        case TEMPLATE_JSON:
+            if (c == '"' || c == '\\' || c == '\b' || c == '\f' || c == '\n' || c == '\r' || c == '\t') return 2;
+            return c < 0x20 ? 6 : 1;
+        case TEMPLATE_URL:
+            return _template_url_safe(c) ? 1 : 3;
+        default:
+            return 1;
+    }
+}
+
+static size_t _template_measure(clz_view v, int escape) {
+    if (escape == TEMPLATE_RAW) return v.len;
+    size_t n = 0;
+    for (size_t i = 0; i < v.len; ++i) n += _template_escaped_len(escape, (unsigned char) v.ptr[i]);
+    return n;
+}
+
+static char *_template_write(char *p, clz_view v, int escape) {
+    static const char hex[] = "0123456789ABCDEF";
+    if (!v.len) return p;
+    if (escape == TEMPLATE_RAW) {
+        memcpy(p, v.ptr, v.len);
+        return p + v.len;
+    }
+    size_t run = 0;
+    for (size_t i = 0; i < v.len; ++i) {
+        unsigned char c = (unsigned char) v.ptr[i];
+        if (_template_escaped_len(escape, c) == 1) continue;
+        memcpy(p, v.ptr + run, i - run);
+        p += i - run;
+        run = i + 1;
+
+        const char *e = NULL;
+        if (escape == TEMPLATE_HTML) {
+            e = c == '&' ? "&amp;" : c == '<' ? "&lt;" : c == '>' ? "&gt;" : c == '"' ? "&quot;" : "&#39;";
+        } else if (escape == TEMPLATE_JSON) {
+            e = c == '"' ? "\\\"" : c == '\\' ? "\\\\" : c == '\b' ? "\\b" : c == '\f' ? "\\f"
+                : c == '\n' ? "\\n" : c == '\r' ? "\\r" : c == '\t' ? "\\t" : NULL;
+        }
+        if (e) {
+            size_t n = strlen(e);
+            memcpy(p, e, n);
+            p += n;
+        } else if (escape == TEMPLATE_JSON) {
+            memcpy(p, "\\u00", 4);
+            p[4] = hex[c >> 4];
+            p[5] = hex[c & 0xF];
+            p += 6;
+        } else {
+            p[0] = '%';
+            p[1] = hex[c >> 4];
+            p[2] = hex[c & 0xF];
+            p += 3;
+        }
+    }
+    memcpy(p, v.ptr + run, v.len - run);
+    return p + v.len - run;
+}
+
+bool template_render(text_template *t, char **destbuf, enum template_escape escape,
+                     bool (*lookup)(void *, clz_view, clz_view *), void *arg) {
+    clz_view *values = t->nnames ? malloc(t->nnames * sizeof(clz_view)) : NULL;
+    if (t->nnames && !values) {
+        errno = ENOMEM;
+        return false;
+    }
+    for (size_t i = 0; i < t->nnames; ++i) {
+        if (!lookup(arg, t->names[i], values + i)) values[i] = (clz_view) {NULL, 0};
+    }
+
+    // first pass: the exact size of the output
+    size_t n = 0;
+    for (size_t i = 0; i < t->nsegs; ++i) {
+        struct _template_seg *seg = t->segs + i;
+        n += seg->var ? _template_measure(values[seg->name], seg->escape < 0 ? (int) escape : seg->escape) : seg->len;
+    }
+
+    size_t dlen = strbuf_length(*destbuf);
+    if (strbuf_alloc_size(*destbuf) < dlen + n + 1 && !strbuf_resize(destbuf, dlen + n + 1)) {
+        free(values);
+        errno = ENOMEM;
+        return false;
+    }
+
+    // second pass: the segments
+    char *p = *destbuf + dlen;
+    for (size_t i = 0; i < t->nsegs; ++i) {
+        struct _template_seg *seg = t->segs + i;
+        if (seg->var) {
+            p = _template_write(p, values[seg->name], seg->escape < 0 ? (int) escape : seg->escape);
+        } else {
+            memcpy(p, t->text + seg->off, seg->len);
+            p += seg->len;
+        }
+    }
+    *p = '\0';
+    free(values);
+    return strbuf_set_length(destbuf, dlen + n);
+}
+
+static bool _template_dynarray_lookup(void *arg, clz_view name, clz_view *value) {
+    dynarray *vars = arg;
+    for (size_t i = 0; i + 1 < dynarray_length(vars); i += 2) {
+        char *key = dynarray_at(vars, i);
+        if (strbuf_length(key) == name.len && !memcmp(key, name.ptr, name.len)) {
+            char *v = dynarray_at(vars, i + 1);
+            *value = (clz_view) {v, strbuf_length(v)};
+            return true;
+        }
+    }
+    return false;
+}
+
+bool template_render_dynarray(text_template *t, char **destbuf, enum template_escape escape, dynarray *vars) {
+    return template_render(t, destbuf, escape, _template_dynarray_lookup, vars);
+}
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains a lightweight timeline tracer. Spans (a begin and an end event) and counters are
+ * recorded into a buffer owned by the calling thread, without locks or system calls, and time-stamped with the
+ * CPU time stamp counter where available (`rdtsc` on x86, `clock_gettime` elsewhere). At the end of the run,
+ * @ref trace_export renders all recorded events into a strbuf in the Chrome trace event format, which can be
+ * loaded by `chrome://tracing` and by Perfetto (`ui.perfetto.dev`).
+ *
+ * The intended interface are the macros @ref CLZ_TRACE_BEGIN, @ref CLZ_TRACE_END, @ref CLZ_TRACE_SCOPE and
+ * @ref CLZ_TRACE_COUNTER, which record events only if the macro `CLZ_TRACE` is defined, and expand to nothing
+ * (not evaluating their arguments) otherwise:
+ *
+ * @code
+ *     void handle(request *req) {
+ *         CLZ_TRACE_SCOPE("handle");       // ends when the function returns
+ *         CLZ_TRACE_BEGIN("parse");
+ *         parse(req);
+ *         CLZ_TRACE_END("parse");
+ *         CLZ_TRACE_COUNTER("queue", queue_length());
+ *     }
+ *
+ *     // at exit
+ *     char *json = strbuf_new();
+ *     trace_export(&json);
+ * @endcode
+ *
+ * Event names are stored by pointer, so they must outlive the export; string literals are the norm.
+ *
+ * Every thread gets a buffer of @ref CLZ_TRACE_BUFFER_EVENTS events the first time it records one. When it is full,
+ * further events of that thread are dropped and counted (see @ref trace_dropped). Buffers are kept until the
+ * end of the program, so that threads that have already exited still show up in the export.
+ *
+ * **Implementation**
+ *
+ * The implementation can be included if the macro `CLZ_TRACE_IMPL` is defined beforehand. It requires POSIX
+ * threads. @ref trace_export requires the implementation of @ref strbuf.h to be included as well.
+ *
+ * @file trace.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the declarations for a span tracer exporting Chrome trace JSON
+ *
+ */
+
+#ifndef _CLZ_TRACE_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_TRACE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clz.h"
+#include "strbuf.h"
+
+/**
+ * @brief Records the beginning of the span `name` on the calling thread.
+ *
+ * Spans of a thread must be properly nested, i.e. ended in the reverse order they were begun.
+ *
+ * @param name The name of the span
+ *
+ * @see trace_end, CLZ_TRACE_BEGIN
+ */
+void trace_begin(const char *name);
+/**
+ * @brief Records the end of the span `name` on the calling thread.
+ *
+ * @param name The name of the span
+ *
+ * @see trace_begin, CLZ_TRACE_END
+ */
+void trace_end(const char *name);
+/**
+ * @brief Records the value of the counter `name`.
+ *
+ * Counters are shown as a graph over time by the trace viewers.
+ *
+ * @param name The name of the counter
+ * @param value The current value
+ *
+ * @see CLZ_TRACE_COUNTER
+ */
+void trace_counter(const char *name, int64_t value);
+/**
+ * @brief Appends all recorded events to a strbuf as Chrome trace event JSON.
+ *
+ * The events of every thread are exported in the order they were recorded, timestamps being in microseconds
+ * since the first event of the program. Threads are numbered in the order they recorded their first event.
+ *
+ * The export should happen while no thread is recording, typically at the end of the program: events recorded
+ * concurrently may or may not be part of the export, but never show up half-written.
+ *
+ * Since heap allocation is used, failure is possible. In this case, `false` is returned.
+ *
+ * @param destbuf The destination buffer
+ * @return `true` if successful
+ */
+bool trace_export(char **destbuf);
+/**
+ * @brief Discards all recorded events.
+ *
+ * The buffers are kept for reuse. This function must not be called while other threads are recording.
+ */
+void trace_reset();
+/**
+ * @brief Returns the number of events dropped because a thread buffer was full.
+ *
+ * @return The number of dropped events
+ */
+size_t trace_dropped();
+
+/**
+ * @brief The number of events each thread can record.
+ *
+ * Can be overridden by defining it before including this header. Every event takes 25 bytes.
+ */
+#ifndef CLZ_TRACE_BUFFER_EVENTS
+#define CLZ_TRACE_BUFFER_EVENTS 65536
+#endif
+
+static inline void _trace_scope_end(const char **name) {
+    trace_end(*name);
+}
+
+#define _CLZ_TRACE_CAT2(a, b) a##b
+#define _CLZ_TRACE_CAT(a, b) _CLZ_TRACE_CAT2(a, b)
+
+#ifdef CLZ_TRACE
+
+/**
+ * @brief Begins the span `name` if `CLZ_TRACE` is defined, see @ref trace_begin
+ */
+#define CLZ_TRACE_BEGIN(name) trace_begin(name)
+/**
+ * @brief Ends the span `name` if `CLZ_TRACE` is defined, see @ref trace_end
+ */
+#define CLZ_TRACE_END(name) trace_end(name)
+/**
+ * @brief Records the counter `name` if `CLZ_TRACE` is defined, see @ref trace_counter
+ */
+#define CLZ_TRACE_COUNTER(name, value) trace_counter(name, value)
+/**
+ * @brief Begins the span `name`, which ends automatically when the enclosing block is left.
+ *
+ * Requires the `cleanup` attribute of GCC and Clang.
+ */
+#define CLZ_TRACE_SCOPE(name) \
+    const char *_CLZ_TRACE_CAT(_clz_trace_scope_, __LINE__) __attribute__((cleanup(_trace_scope_end))) = \
+        (trace_begin(name), (name))
+
+#else
+
+#define CLZ_TRACE_BEGIN(name) ((void) 0)
+#define CLZ_TRACE_END(name) ((void) 0)
+#define CLZ_TRACE_COUNTER(name, value) ((void) 0)
+#define CLZ_TRACE_SCOPE(name) ((void) 0)
+
+#endif
+
+#endif
+
+#ifdef CLZ_TRACE_IMPL
+#undef CLZ_TRACE_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef struct trace_event {
+    const char *name;
+    uint64_t ticks;
+    int64_t value;
+} trace_event;
+
+#define _TRACE_PH_BEGIN 0
+#define _TRACE_PH_END 1
+#define _TRACE_PH_COUNTER 2
+
+typedef struct trace_buffer {
+    struct trace_buffer *next;
+    unsigned tid;
+    _Atomic size_t count;
+    unsigned char phase[CLZ_TRACE_BUFFER_EVENTS];
+    trace_event events[CLZ_TRACE_BUFFER_EVENTS];
+} trace_buffer;
+
+static _Atomic(trace_buffer *) _trace_buffers = NULL;
+static atomic_uint _trace_threads = 0;
+static atomic_size_t _trace_dropped = 0;
+static atomic_bool _trace_started = false;
+static pthread_once_t _trace_once = PTHREAD_ONCE_INIT;
+// written once by _trace_start, before _trace_started is set
+static uint64_t _trace_base_ticks, _trace_base_ns;
+static _Thread_local trace_buffer *_trace_tls = NULL;
+
+static uint64_t _trace_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static inline uint64_t _trace_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return _trace_ns();
+#endif
+}
+
+static void _trace_start() {
+    _trace_base_ns = _trace_ns();
+    _trace_base_ticks = _trace_ticks();
+    atomic_store(&_trace_started, true);
+}
+
+static trace_buffer *_trace_thread_buffer() {
+    trace_buffer *buf = calloc(1, sizeof(trace_buffer));
+    if (buf == NULL) return NULL;
+
+    pthread_once(&_trace_once, _trace_start);
+
+    buf->tid = atomic_fetch_add(&_trace_threads, 1) + 1;
+    buf->next = atomic_load(&_trace_buffers);
+    while (!atomic_compare_exchange_weak(&_trace_buffers, &buf->next, buf));
+    _trace_tls = buf;
+    return buf;
+}
+
+static inline void _trace_record(const char *name, unsigned char phase, int64_t value) {
+    uint64_t ticks = _trace_ticks();
+    trace_buffer *buf = _trace_tls;
+    if (buf == NULL && (buf = _trace_thread_buffer()) == NULL) {
+        atomic_fetch_add_explicit(&_trace_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    // only the owning thread writes the buffer, the release store publishes the event to trace_export
+    size_t n = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    if (n == CLZ_TRACE_BUFFER_EVENTS) {
+        atomic_fetch_add_explicit(&_trace_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    buf->events[n].name = name;
+    buf->events[n].ticks = ticks;
+    buf->events[n].value = value;
+    buf->phase[n] = phase;
+    atomic_store_explicit(&buf->count, n + 1, memory_order_release);
+}
+
+void trace_begin(const char *name) {
+    _trace_record(name, _TRACE_PH_BEGIN, 0);
+}
+
+void trace_end(const char *name) {
+    _trace_record(name, _TRACE_PH_END, 0);
+}
+
+void trace_counter(const char *name, int64_t value) {
+    _trace_record(name, _TRACE_PH_COUNTER, value);
+}
+
+void trace_reset() {
+    for (trace_buffer *buf = atomic_load(&_trace_buffers); buf; buf = buf->next) {
+        atomic_store(&buf->count, 0);
+    }
+    atomic_store(&_trace_dropped, 0);
+}
+
+size_t trace_dropped() {
+    return atomic_load(&_trace_dropped);
+}
+
+static bool _trace_reserve(char **destbuf, size_t len, size_t extra) {
+    // the length has to be up to date before the buffer is copied
+    if (!strbuf_set_length(destbuf, len)) return false;
+    if (strbuf_alloc_size(*destbuf) >= len + extra + 1) return true;
+    return strbuf_resize(destbuf, 2 * (len + extra + 1));
+}
+
+static size_t _trace_escape(char *dest, const char *s, size_t max) {
+    size_t n = 0;
+    for (; *s && n + 2 < max; ++s) {
+        if (*s == '"' || *s == '\\') dest[n++] = '\\';
+        dest[n++] = (unsigned char) *s < 0x20 ? ' ' : *s;
+    }
+    dest[n] = '\0';
+    return n;
+}
+
+bool trace_export(char **destbuf) {
+    // ticks per microsecond, measured over at least a millisecond since the first event
+    double ticks_per_us = 1e3;
+#if defined(__x86_64__) || defined(__i386__)
+    if (atomic_load(&_trace_started)) {
+        uint64_t ns, ticks;
+        do {
+            ns = _trace_ns();
+            ticks = _trace_ticks();
+        } while (ns - _trace_base_ns < 1000000);
+        ticks_per_us = (double) (ticks - _trace_base_ticks) * 1e3 / (double) (ns - _trace_base_ns);
+    }
+#endif
+
+    size_t len = strbuf_length(*destbuf);
+    int pid = (int) getpid();
+    bool first = true;
+    char name[256];
+
+    if (!_trace_reserve(destbuf, len, 64)) return false;
+    len += sprintf(*destbuf + len, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (trace_buffer *buf = atomic_load(&_trace_buffers); buf; buf = buf->next) {
+        size_t count = atomic_load_explicit(&buf->count, memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            trace_event *ev = buf->events + i;
+            double ts = (double) (int64_t) (ev->ticks - _trace_base_ticks) / ticks_per_us;
+            _trace_escape(name, ev->name, sizeof(name));
+
+            if (!_trace_reserve(destbuf, len, strlen(name) + 128)) return false;
+            if (buf->phase[i] == _TRACE_PH_COUNTER) {
+                len += sprintf(*destbuf + len,
+                               "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{\"value\":%lld}}",
+                               first ? "" : ",", name, ts, pid, buf->tid, (long long) ev->value);
+            } else {
+                len += sprintf(*destbuf + len, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u}",
+                               first ? "" : ",", name, buf->phase[i] == _TRACE_PH_BEGIN ? 'B' : 'E', ts, pid,
+                               buf->tid);
+            }
+            first = false;
+        }
+    }
+
+    if (!_trace_reserve(destbuf, len, 2)) return false;
+    strcpy(*destbuf + len, "]}");
+    return strbuf_set_length(destbuf, len + 2);
+}
+
+#endif
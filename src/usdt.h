@@ -0,0 +1,112 @@
+/*
+ *     libclz - compact single header file utility library
+ *     Copyright (C) 2020  Lorenzo Calza
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *
+ * This header file contains the macros that place USDT (user-level statically defined tracing) probes on the
+ * hot paths of the library, so that `bpftrace`, `perf` or SystemTap can attribute time and memory traffic to
+ * them even though most of the code ends up inlined into the program.
+ *
+ * The probes are compiled in if the macro `CLZ_USDT` is defined and `<sys/sdt.h>` (from SystemTap, usually
+ * packaged as `systemtap-sdt-dev`) is available. Otherwise every macro expands to nothing and its arguments are
+ * not evaluated. A probe that is compiled in costs a single `nop` plus its argument setup while no tracer is
+ * attached. Latencies are measured with `clock_gettime(CLOCK_MONOTONIC)` and only if the probes are compiled in.
+ *
+ * All probes belong to the provider `libclz`:
+ *
+ * | Probe                      | Arguments                                                   |
+ * |----------------------------|-------------------------------------------------------------|
+ * | `strbuf_resize`            | old allocation size, new allocation size, latency (ns)      |
+ * | `strbuf_remove_realloc`    | old length, new length, latency (ns)                        |
+ * | `dynarray_grow`            | old allocation size, new allocation size, latency (ns)      |
+ * | `dynarray_remove_realloc`  | old length, new length, latency (ns)                        |
+ * | `logger_log_entry`         | logger, severity level, message                             |
+ * | `logger_log_return`        | logger, severity level, latency (ns)                        |
+ * | `logger_queue_full`        | asynchronous queue, severity level, capacity                |
+ *
+ * Sizes of a @ref dynarray are in units of `sizeof(void *)`. The logger probes are fired by both `logger_log` and
+ * `logger_logf`, the message being the format string in the latter case.
+ * `logger_queue_full` fires whenever a line is rejected or has to wait because a @ref logger_async is full.
+ * Example:
+ *
+ *     bpftrace -e 'usdt:./prog:libclz:strbuf_resize { @lat = hist(arg2); @bytes = sum(arg1 - arg0); }'
+ *
+ * **Implementation**
+ *
+ * There is no implementation section, as this header file contains only macros.
+ *
+ * @file usdt.h
+ * @author Lorenzo Calza
+ * @date 19 Oct 2026
+ * @brief Header file containing the optional USDT tracepoints of the library
+ *
+ */
+
+#ifndef _CLZ_USDT_H
+/**
+ * @brief Include guard for this file.
+ */
+#define _CLZ_USDT_H
+
+#if defined(CLZ_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#include <stdint.h>
+#include <time.h>
+/**
+ * @brief Defined if the probes are compiled in.
+ */
+#define CLZ_USDT_ENABLED
+#endif
+#endif
+
+#ifdef CLZ_USDT_ENABLED
+
+static inline uint64_t _clz_usdt_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * @brief Declares the variable `var` holding the current time, for use with @ref CLZ_USDT_ELAPSED
+ */
+#define CLZ_USDT_TIMER(var) uint64_t var = _clz_usdt_now()
+/**
+ * @brief Nanoseconds elapsed since @ref CLZ_USDT_TIMER declared `var`
+ */
+#define CLZ_USDT_ELAPSED(var) (_clz_usdt_now() - (var))
+/**
+ * @brief Probe `libclz:name` with two arguments
+ */
+#define CLZ_PROBE2(name, a, b) DTRACE_PROBE2(libclz, name, a, b)
+/**
+ * @brief Probe `libclz:name` with three arguments
+ */
+#define CLZ_PROBE3(name, a, b, c) DTRACE_PROBE3(libclz, name, a, b, c)
+
+#else
+
+#define CLZ_USDT_TIMER(var) ((void) 0)
+#define CLZ_USDT_ELAPSED(var) 0
+#define CLZ_PROBE2(name, a, b) ((void) 0)
+#define CLZ_PROBE3(name, a, b, c) ((void) 0)
+
+#endif
+
+#endif
@@ -1,8 +1,19 @@
 #define CLZ_STRBUF_IMPL
+#define CLZ_REGEX_IMPL
+#define CLZ_STRBUF_PARALLEL_IMPL
+// one byte per thread, so that even short buffers are split into chunks
+#define CLZ_STRBUF_PARALLEL_MIN 1
+#define CLZ_LZ_IMPL
+// a block per thread for inputs of a few blocks
+#define CLZ_LZ_PARALLEL_MIN (1 << 16)
 #define B_PASS_SILENTLY
 
 #include <test-beam/beam.h>
 #include "../src/strbuf.h"
+#include "../src/regex.h"
+#include "../src/strbuf_parallel.h"
+#include "../src/lz.h"
+#include "../src/color.h"
 #include <stdbool.h>
 #include <string.h>
 
@@ -329,6 +340,574 @@ void test_append_llong() {
     B_SKIP();
 }
 
+void test_strip_ansi() {
+    bool succ = true;
+    char *buf = strbuf_new_str(COL_RED "Hello" COL_RESET ", " COL_BOLD_GREEN "World" COL_RESET "!");
+
+    if (strbuf_strip_ansi(&buf) != strlen(COL_RED COL_BOLD_GREEN COL_RESET COL_RESET)) succ = false;
+    if (strcmp(buf, "Hello, World!")) succ = false;
+    if (strbuf_strip_ansi(&buf) != 0) succ = false;
+    if (strcmp(buf, "Hello, World!")) succ = false;
+    strbuf_free(buf);
+
+    buf = strbuf_new_str("\033]0;title\007text\033[1");
+    strbuf_strip_ansi(&buf);
+    if (strcmp(buf, "text")) succ = false;
+    strbuf_free(buf);
+
+    PASS_IF(succ);
+}
+
+void test_display_width() {
+    bool succ = true;
+    char *buf = strbuf_new_str(COL_BOLD_CYAN "Hello, World!" COL_RESET);
+
+    if (strbuf_display_width(&buf) != 13) succ = false;
+    strbuf_free(buf);
+
+    buf = strbuf_new_str("caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac"); // "café 日本"
+    if (strbuf_display_width(&buf) != 9) succ = false;
+    if (!strbuf_padding_tail_display(&buf, '.', 12)) succ = false;
+    if (strbuf_display_width(&buf) != 12) succ = false;
+    if (strcmp(buf, "caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac...")) succ = false;
+    if (strbuf_padding_head_display(&buf, ' ', 11)) succ = false;
+    strbuf_free(buf);
+
+    buf = strbuf_new_str(COL_RED "42" COL_RESET);
+    if (!strbuf_padding_head_display(&buf, ' ', 5)) succ = false;
+    if (strcmp(buf, "   " COL_RED "42" COL_RESET)) succ = false;
+    strbuf_free(buf);
+
+    // truncated escape sequences at the end of bytes without a null-terminator
+    char *bytes = malloc(4);
+    memcpy(bytes, "a\033[1", 4);
+    if (strbuf_display_width_bytes(bytes, 3) != 1 || strbuf_display_width_bytes(bytes, 4) != 1) succ = false;
+    memcpy(bytes, "a\033]\033", 4);
+    if (strbuf_display_width_bytes(bytes, 4) != 1) succ = false;
+    free(bytes);
+
+    PASS_IF(succ);
+}
+
+void test_bytes() {
+    bool succ = true;
+    char *buf = strbuf_new_str("ab");
+    const char payload[] = {'c', 0, 'd', 0};
+
+    if (strbuf_is_binary(buf)) succ = false;
+    if (!strbuf_append_bytes(&buf, payload, sizeof(payload))) succ = false;
+    if (!strbuf_is_binary(buf) || strbuf_length(buf) != 6) succ = false;
+    if (memcmp(buf, "ab" "c\0d\0", 7)) succ = false;
+
+    for (size_t i = 0; i < CLZ_STRBUF_ALLOC; ++i) strbuf_append_char(&buf, 0);
+    if (strbuf_length(buf) != 6 + CLZ_STRBUF_ALLOC || strbuf_alloc_size(buf) != 2 * CLZ_STRBUF_ALLOC) succ = false;
+    if (strbuf_find_bytes(&buf, "d\0", 2, 0) != 4) succ = false;
+    if (strbuf_find_bytes(&buf, "\0\0", 2, 0) != 5) succ = false;
+    if (strbuf_find_bytes(&buf, "x", 1, 0) != CLZ_NOT_FOUND) succ = false;
+
+    strbuf_trim_length(&buf, 6);
+    if (!strbuf_insert_bytes(&buf, "\0", 0, 1) || strbuf_length(buf) != 7) succ = false;
+    if (strbuf_insert_bytes(&buf, "x", 8, 1)) succ = false;
+
+    char *cpy = strbuf_clone(buf, false);
+    if (!strbuf_is_binary(cpy) || strbuf_length(cpy) != 7 || memcmp(cpy, buf, 8)) succ = false;
+    if (strbuf_replace_all_str(&cpy, "d", "xyz") != 1 || memcmp(cpy, "\0abc\0xyz\0", 10)) succ = false;
+    strbuf_free(cpy);
+    strbuf_free(buf);
+
+    PASS_IF(succ);
+}
+
+void test_literal() {
+    bool succ = true;
+    char *lit = STRBUF_LITERAL("Hello"), *buf = lit;
+
+    if (strcmp(buf, "Hello") || strbuf_length(buf) != 5 || strbuf_alloc_size(buf) != 0) succ = false;
+    if (strbuf_is_binary(buf) || strbuf_footprint(buf).reserved != 0) succ = false;
+    if (strbuf_find_first_char(&buf, 'l') != 2 || buf != lit) succ = false;
+    char *cpy = strbuf_clone(buf, true);
+    if (strcmp(cpy, "Hello") || strbuf_alloc_size(cpy) != CLZ_STRBUF_ALLOC) succ = false;
+    strbuf_free(cpy);
+
+    strbuf_to_uppercase(&buf);
+    if (buf == lit || strcmp(buf, "HELLO") || strcmp(lit, "Hello")) succ = false;
+    strbuf_free(buf);
+
+    buf = lit;
+    if (!strbuf_append_str(&buf, ", World!") || buf == lit || strcmp(buf, "Hello, World!")) succ = false;
+    strbuf_free(buf);
+
+    buf = lit;
+    strbuf_trim_length(&buf, 2);
+    if (buf == lit || strcmp(buf, "He") || strcmp(lit, "Hello")) succ = false;
+    strbuf_free(buf);
+    strbuf_free(lit);
+
+    PASS_IF(succ);
+}
+
+void test_varint() {
+    bool succ = true;
+    char *buf = strbuf_new();
+    const uint64_t values[] = {0, 1, 127, 128, 16383, 16384, UINT32_MAX, (uint64_t) 1 << 63, UINT64_MAX};
+    const size_t lengths[] = {1, 1, 1, 2, 2, 3, 5, 10, 10};
+    size_t n = sizeof(values) / sizeof(*values), pos = 0, end;
+    uint64_t u;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t len = strbuf_length(buf);
+        if (!strbuf_append_varint(&buf, values[i]) || strbuf_length(buf) - len != lengths[i]) succ = false;
+    }
+    if (!strbuf_is_binary(buf)) succ = false;
+    for (size_t i = 0; i < n; ++i) {
+        if (!strbuf_read_varint(&buf, &pos, &u) || u != values[i]) succ = false;
+    }
+    if (pos != strbuf_length(buf) || strbuf_read_varint(&buf, &pos, &u)) succ = false;
+
+    // truncated, 11 bytes long, and a 10th byte beyond 64 bits
+    strbuf_trim_length(&buf, strbuf_length(buf) - 1);
+    pos = end = strbuf_length(buf) - 9;
+    if (strbuf_read_varint(&buf, &pos, &u) || pos != end) succ = false;
+    strbuf_trim_length(&buf, 0);
+    for (int i = 0; i < 10; ++i) strbuf_append_char(&buf, (char) 0x80);
+    strbuf_append_char(&buf, 0);
+    pos = 0;
+    if (strbuf_read_varint(&buf, &pos, &u) || pos != 0) succ = false;
+    strbuf_trim_length(&buf, 9);
+    strbuf_append_char(&buf, 2);
+    if (strbuf_read_varint(&buf, &pos, &u) || pos != 0) succ = false;
+
+    const int64_t signed_values[] = {0, -1, 1, -64, 63, -65, 64, INT64_MIN, INT64_MAX};
+    const size_t signed_lengths[] = {1, 1, 1, 1, 1, 2, 2, 10, 10};
+    int64_t v;
+    strbuf_trim_length(&buf, 0);
+    for (size_t i = 0; i < n; ++i) {
+        size_t len = strbuf_length(buf);
+        if (!strbuf_append_zigzag(&buf, signed_values[i]) || strbuf_length(buf) - len != signed_lengths[i]) succ = false;
+        if (strbuf_zigzag_decode(strbuf_zigzag_encode(signed_values[i])) != signed_values[i]) succ = false;
+    }
+    pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!strbuf_read_zigzag(&buf, &pos, &v) || v != signed_values[i]) succ = false;
+    }
+
+    strbuf_free(buf);
+    PASS_IF(succ);
+}
+
+void test_fixed_width() {
+    bool succ = true;
+    char *buf = strbuf_new();
+    const uint64_t value = 0x0102030405060708;
+    size_t pos = 0;
+    uint64_t u;
+
+    for (size_t width = 1; width <= 8; ++width) {
+        uint64_t masked = width == 8 ? value : value & (((uint64_t) 1 << (8 * width)) - 1);
+        strbuf_trim_length(&buf, 0);
+        if (!strbuf_append_le(&buf, value, width) || !strbuf_append_be(&buf, value, width)) succ = false;
+        if (strbuf_length(buf) != 2 * width) succ = false;
+        for (size_t i = 0; i < width; ++i) {
+            if ((unsigned char) buf[i] != 8 - i || (unsigned char) buf[width + i] != 9 - width + i) succ = false;
+        }
+        pos = 0;
+        if (!strbuf_read_le(&buf, &pos, width, &u) || u != masked || pos != width) succ = false;
+        if (!strbuf_read_be(&buf, &pos, width, &u) || u != masked || pos != 2 * width) succ = false;
+        // truncated
+        pos = width + 1;
+        if (strbuf_read_be(&buf, &pos, width, &u) || pos != width + 1) succ = false;
+    }
+
+    pos = 0;
+    if (strbuf_append_le(&buf, value, 0) || strbuf_append_be(&buf, value, 9)) succ = false;
+    if (strbuf_read_le(&buf, &pos, 0, &u) || strbuf_read_be(&buf, &pos, 9, &u) || pos != 0) succ = false;
+    pos = strbuf_length(buf) + 1;
+    if (strbuf_read_le(&buf, &pos, 1, &u)) succ = false;
+
+    strbuf_free(buf);
+    PASS_IF(succ);
+}
+
+void test_svb() {
+    bool succ = true;
+    uint32_t values[1000], decoded[1000], scalar[1000];
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < 1000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        // every byte length, including the boundaries between them
+        const uint32_t bounds[] = {0, 0xff, 0x100, 0xffff, 0x10000, 0xffffff, 0x1000000, UINT32_MAX};
+        values[i] = i % 3 ? seed >> (8 * (seed % 4)) : bounds[i / 3 % 8];
+    }
+
+    const size_t counts[] = {0, 1, 3, 4, 5, 17, 64, 1000};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(*counts); ++c) {
+        size_t n = counts[c], pos = 2;
+        char *buf = strbuf_new_str("xy");
+        if (!strbuf_append_svb(&buf, values, n)) succ = false;
+        size_t len = strbuf_length(buf);
+        if (!strbuf_read_svb(&buf, &pos, decoded, n) || pos != len || memcmp(decoded, values, n * sizeof(*values))) {
+            succ = false;
+        }
+
+        // the SSSE3 kernel, where available, against the scalar decoder
+        const unsigned char *ctrl = (const unsigned char *) buf + 2;
+        if (_strbuf_svb_scalar(ctrl, ctrl + (n + 3) / 4, scalar, 0, n) != len - 2 - (n + 3) / 4) succ = false;
+        if (memcmp(decoded, scalar, n * sizeof(*values))) succ = false;
+
+        // truncated
+        if (n) {
+            strbuf_trim_length(&buf, len - 1);
+            pos = 2;
+            if (strbuf_read_svb(&buf, &pos, decoded, n) || pos != 2) succ = false;
+        }
+        strbuf_free(buf);
+    }
+
+    PASS_IF(succ);
+}
+
+void test_memmem() {
+    bool succ = true;
+    const char *abc = "abc", *bytes = "a\0b\0c";
+    char hay[100], needle[8];
+
+    if (strbuf_memmem(abc, 3, "", 0) != abc || strbuf_memmem(abc, 0, "", 0) != abc) succ = false;
+    if (strbuf_memmem(abc, 0, "a", 1) != NULL || strbuf_memmem(abc, 2, "abc", 3) != NULL) succ = false;
+    if (strbuf_memmem(bytes, 5, "\0c", 2) != bytes + 3) succ = false;
+    // a match cut off by the length
+    if (strbuf_memmem("xxabc", 4, "abc", 3) != NULL) succ = false;
+
+    // the only match at the very end, for every haystack length around the 16-byte blocks of the SSE2 search
+    for (size_t hlen = 1; hlen <= sizeof(hay); ++hlen) {
+        for (size_t n = 1; n <= sizeof(needle) && n <= hlen; ++n) {
+            // the first byte of the needle everywhere
+            memset(hay, 'a', hlen);
+            memset(needle, 'a', n - 1);
+            needle[n - 1] = 'b';
+            memcpy(hay + hlen - n, needle, n);
+            if (strbuf_memmem(hay, hlen, needle, n) != hay + hlen - n) succ = false;
+            if (strbuf_memmem(hay, hlen - 1, needle, n) != NULL) succ = false;
+
+            // the first and the last byte everywhere, the middle ones only at the end
+            if (n < 3) continue;
+            memset(hay, 'b', hlen);
+            memset(needle + 1, 'm', n - 2);
+            needle[0] = 'b';
+            memcpy(hay + hlen - n, needle, n);
+            if (strbuf_memmem(hay, hlen, needle, n) != hay + hlen - n) succ = false;
+        }
+    }
+
+    PASS_IF(succ);
+}
+
+void test_regex() {
+    bool succ = true;
+    const char *s = "mail bob@example.com or amy@test.com";
+    clz_view caps[4];
+    regex re;
+
+    if (!regex_compile(&re, "(\\w+)@(\\w+)\\.com")) succ = false;
+    if (!regex_search(&re, s, strlen(s), 0, caps, 4)) succ = false;
+    if (caps[0].ptr != s + 5 || caps[0].len != 15) succ = false;
+    if (caps[1].ptr != s + 5 || caps[1].len != 3 || caps[2].ptr != s + 9 || caps[2].len != 7) succ = false;
+    // groups that do not exist
+    if (caps[3].ptr != NULL || caps[3].len != 0) succ = false;
+    if (!regex_search(&re, s, strlen(s), 6, caps, 2) || caps[0].ptr != s + 6 || caps[1].len != 2) succ = false;
+    if (!regex_search(&re, s, strlen(s), 21, caps, 3) || caps[1].ptr != s + 24 || caps[2].len != 4) succ = false;
+    if (regex_search(&re, s, strlen(s), 25, caps, 1) && caps[0].ptr != s + 25) succ = false;
+    if (regex_search(&re, s, strlen(s), strlen(s) + 1, caps, 1)) succ = false;
+    regex_free(&re);
+
+    // a group that does not take part in the match, and `^` only at the start of the string
+    if (!regex_compile(&re, "(a)|(b)")) succ = false;
+    if (!regex_search(&re, "xb", 2, 0, caps, 3) || caps[1].ptr != NULL || caps[2].len != 1) succ = false;
+    regex_free(&re);
+    if (!regex_compile(&re, "^b")) succ = false;
+    if (regex_search(&re, "ab", 2, 1, caps, 1) || !regex_test(&re, "ba", 2)) succ = false;
+    regex_free(&re);
+
+    char *buf = strbuf_new_str((char *) s);
+    if (!regex_compile(&re, "(\\w+)@(\\w+)\\.com")) succ = false;
+    if (strbuf_regex_replace_all(&buf, &re, "$2:$1$$$9") != 2) succ = false;
+    if (strcmp(buf, "mail example:bob$ or test:amy$")) succ = false;
+    if (strbuf_regex_replace_all(&buf, &re, "x") != 0 || strcmp(buf, "mail example:bob$ or test:amy$")) succ = false;
+    regex_free(&re);
+    strbuf_free(buf);
+
+    // an empty match right after the previous match is skipped, as in Perl
+    if (!regex_compile(&re, "x*")) succ = false;
+    buf = strbuf_new_str("axxb");
+    if (strbuf_regex_replace_all(&buf, &re, "-") != 3 || strcmp(buf, "-a-b-")) succ = false;
+    strbuf_free(buf);
+    buf = strbuf_new_str("");
+    if (strbuf_regex_replace_all(&buf, &re, "-") != 1 || strcmp(buf, "-")) succ = false;
+    strbuf_free(buf);
+    regex_free(&re);
+
+    // binary buffers stay binary
+    if (!regex_compile(&re, "\\x00")) succ = false;
+    buf = strbuf_new();
+    strbuf_append_bytes(&buf, "a\0b\0", 4);
+    if (strbuf_regex_replace_all(&buf, &re, "\\0") != 2 || !strbuf_is_binary(buf)) succ = false;
+    if (strbuf_length(buf) != 6 || memcmp(buf, "a\\0b\\0", 7)) succ = false;
+    strbuf_free(buf);
+    regex_free(&re);
+
+    PASS_IF(succ);
+}
+
+// compares the parallel search and replacement to the serial ones on the same buffer
+static bool _test_parallel_case(const char *hay, size_t len, char *s, size_t threads) {
+    bool succ = true;
+    size_t n = strlen(s), *offsets;
+    char *serial = strbuf_new(), *par = strbuf_new();
+    strbuf_append_bytes(&serial, hay, len);
+    strbuf_append_bytes(&par, hay, len);
+
+    if (strbuf_find_first_str_parallel(&par, s, threads) != strbuf_find_first_str(&serial, s)) succ = false;
+    size_t count = strbuf_find_all_str_parallel(&par, s, &offsets, threads);
+    // the matches do not overlap and are the ones of a greedy scan from the start
+    const char *p = hay;
+    for (size_t i = 0; i < count; ++i) {
+        p = strbuf_memmem(p, hay + len - p, s, n);
+        if (!p || offsets[i] != (size_t) (p - hay)) succ = false;
+        if (!p) break;
+        p += n;
+    }
+    if (p && strbuf_memmem(p, hay + len - p, s, n)) succ = false;
+    free(offsets);
+
+    size_t replaced = strbuf_replace_all_str(&serial, s, "<>");
+    if (strbuf_replace_all_str_parallel(&par, s, "<>", threads) != replaced || replaced != count) succ = false;
+    if (strbuf_length(par) != strbuf_length(serial) || memcmp(par, serial, strbuf_length(par) + 1)) succ = false;
+    strbuf_free(serial);
+    strbuf_free(par);
+    return succ;
+}
+
+void test_parallel() {
+    bool succ = true;
+    // the match at 4 is cut in two by the chunk boundary at 5
+    if (!_test_parallel_case("xxxxabxxxx", 10, "ab", 2)) succ = false;
+    // overlapping instances: each chunk starts in the middle of the previous chunk's last match
+    if (!_test_parallel_case("aaaaaaaaa", 9, "aa", 4)) succ = false;
+    if (!_test_parallel_case("aaaaaaaaa", 9, "aaa", 3)) succ = false;
+    if (!_test_parallel_case("abababa", 7, "aba", 3)) succ = false;
+    // no match, a needle longer than a chunk and one longer than the buffer
+    if (!_test_parallel_case("aaaaaaaa", 8, "b", 4)) succ = false;
+    if (!_test_parallel_case("aaaaaaaab", 9, "aaab", 4)) succ = false;
+    if (!_test_parallel_case("ab", 2, "abc", 4)) succ = false;
+
+    char *needles[] = {"a", "aa", "ab", "aba", "aab", "aaaa"};
+    char hay[256];
+    unsigned seed = 1;
+    for (size_t len = 0; len <= sizeof(hay); len += 7) {
+        for (size_t i = 0; i < len; ++i) {
+            seed = seed * 1103515245 + 12345;
+            // mostly a, so that instances overlap often
+            hay[i] = (seed >> 16) % 4 ? 'a' : 'b';
+        }
+        for (size_t j = 0; j < sizeof(needles) / sizeof(needles[0]); ++j) {
+            for (size_t threads = 1; threads <= 9; threads += 2) {
+                if (!_test_parallel_case(hay, len, needles[j], threads)) succ = false;
+            }
+        }
+    }
+    PASS_IF(succ);
+}
+
+// words with some random bytes in between, or only random bytes, which do not compress
+static void _test_lz_fill(char *p, size_t n, unsigned seed, bool random) {
+    const char *words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "\n"};
+    for (size_t i = 0; i < n;) {
+        seed = seed * 1103515245 + 12345;
+        if (random || !((seed >> 16) % 8)) {
+            p[i++] = (char) (seed >> 16);
+            continue;
+        }
+        for (const char *w = words[(seed >> 20) % 6]; *w && i < n; ++w) p[i++] = *w;
+    }
+}
+
+// decompresses to a buffer holding a byte already, which has to be left alone
+static bool _test_lz_check(const char *packed, size_t len, const char *data, size_t n, size_t threads) {
+    char *out = strbuf_new_str("x");
+    bool succ = lz_decompress(&out, packed, len, threads) && strbuf_is_binary(out);
+    if (strbuf_length(out) != n + 1 || out[0] != 'x' || memcmp(out + 1, data, n)) succ = false;
+    strbuf_free(out);
+    return succ;
+}
+
+// the decompression of a malformed input has to fail without touching the buffer
+static bool _test_lz_reject(const char *packed, size_t len) {
+    char *out = strbuf_new_str("x");
+    errno = 0;
+    bool succ = !lz_decompress(&out, packed, len, 4) && errno == EINVAL && strbuf_length(out) == 1;
+    strbuf_free(out);
+    return succ;
+}
+
+void test_lz() {
+    bool succ = true;
+    size_t sizes[] = {0, 1, 4, 13, 100, 4096, CLZ_LZ_BLOCK - 1, CLZ_LZ_BLOCK, 3 * CLZ_LZ_BLOCK + 7};
+    size_t max = 3 * CLZ_LZ_BLOCK + 7;
+    char *data = malloc(max);
+
+    // round trips, with identical frames for any number of threads
+    for (int random = 0; random < 2; ++random) {
+        _test_lz_fill(data, max, 7, random);
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            char *serial = strbuf_new(), *par = strbuf_new();
+            if (!lz_compress(&serial, data, sizes[i], 1) || !lz_compress(&par, data, sizes[i], 4)) succ = false;
+            if (!strbuf_is_binary(serial) || strbuf_length(serial) > lz_bound(sizes[i]) + 32) succ = false;
+            if (strbuf_length(par) != strbuf_length(serial) || memcmp(par, serial, strbuf_length(par))) succ = false;
+            if (!_test_lz_check(serial, strbuf_length(serial), data, sizes[i], 1)) succ = false;
+            if (!_test_lz_check(serial, strbuf_length(serial), data, sizes[i], 4)) succ = false;
+            strbuf_free(serial);
+            strbuf_free(par);
+        }
+    }
+
+    // single blocks
+    _test_lz_fill(data, max, 7, false);
+    char block[lz_bound(4096)], out[4096];
+    size_t size = lz_compress_block(data, 4096, block, sizeof(block)), outlen;
+    if (!size || size >= 4096 || lz_compress_block(data, 4096, block, 16)) succ = false;
+    size = lz_compress_block(data, 4096, block, sizeof(block));
+    if (!lz_decompress_block(block, size, out, 4096, &outlen) || outlen != 4096 || memcmp(out, data, 4096)) succ = false;
+    errno = 0;
+    if (lz_decompress_block(block, size, out, 4095, &outlen) || errno != EINVAL) succ = false;
+    // a match running past the end of the output
+    memset(out, 'a', 100);
+    size = lz_compress_block(out, 100, block, sizeof(block));
+    errno = 0;
+    if (!size || lz_decompress_block(block, size, out, 50, &outlen) || errno != EINVAL) succ = false;
+
+    // streaming compression of two frames, with the input cut at arbitrary points
+    lz_encoder e;
+    char *packed = strbuf_new();
+    unsigned seed = 3;
+    if (!lz_encoder_init(&e)) succ = false;
+    for (int frame = 0; frame < 2; ++frame) {
+        for (size_t i = 0; i < max;) {
+            seed = seed * 1103515245 + 12345;
+            size_t k = (seed >> 16) % 4 ? (seed >> 16) % 300 : (seed >> 8) % (2 * CLZ_LZ_BLOCK);
+            if (k > max - i) k = max - i;
+            if (!lz_encoder_write(&e, &packed, data + i, k)) succ = false;
+            i += k;
+        }
+        if (!lz_encoder_finish(&e, &packed)) succ = false;
+    }
+    lz_encoder_free(&e);
+    char *twice = strbuf_new();
+    strbuf_append_bytes(&twice, data, max);
+    strbuf_append_bytes(&twice, data, max);
+    if (!_test_lz_check(packed, strbuf_length(packed), twice, 2 * max, 4)) succ = false;
+
+    // streaming decompression of the same frames, cut at arbitrary points and sometimes after every byte
+    lz_decoder d;
+    lz_decoder_init(&d);
+    char *dec = strbuf_new();
+    size_t len = strbuf_length(packed);
+    for (size_t i = 0; i < len;) {
+        seed = seed * 1103515245 + 12345;
+        size_t k = (seed >> 16) % 4 ? (seed >> 16) % 20 : (seed >> 8) % (2 * CLZ_LZ_BLOCK);
+        if (k > len - i) k = len - i;
+        if (!lz_decoder_write(&d, &dec, packed + i, k)) succ = false;
+        i += k;
+    }
+    if (!lz_decoder_done(&d) || strbuf_length(dec) != 2 * max || memcmp(dec, twice, 2 * max)) succ = false;
+    lz_decoder_free(&d);
+    strbuf_free(dec);
+    strbuf_free(twice);
+    strbuf_free(packed);
+
+    // truncated frames, at every length for a single block and around the blocks of a larger frame
+    packed = strbuf_new();
+    lz_compress(&packed, data, 4096, 1);
+    len = strbuf_length(packed);
+    for (size_t cut = 1; cut < len; ++cut) {
+        if (!_test_lz_reject(packed, cut)) succ = false;
+        lz_decoder_init(&d);
+        dec = strbuf_new();
+        if (!lz_decoder_write(&d, &dec, packed, cut) || lz_decoder_done(&d)) succ = false;
+        lz_decoder_free(&d);
+        strbuf_free(dec);
+    }
+    // random bytes are stored in uncompressed blocks of CLZ_LZ_BLOCK bytes
+    char *large = strbuf_new();
+    _test_lz_fill(data, max, 7, true);
+    lz_compress(&large, data, max, 1);
+    _test_lz_fill(data, max, 7, false);
+    size_t cuts[] = {7, 15, 19, strbuf_length(large) / 2, strbuf_length(large) - 4, strbuf_length(large) - 1};
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); ++i) {
+        if (!_test_lz_reject(large, cuts[i])) succ = false;
+    }
+    // blocks larger than the maximum of the descriptor, here 64 KiB
+    unsigned char *p = (unsigned char *) large;
+    p[5] = 4 << 4;
+    p[14] = (unsigned char) (_lz_xxh(p + 4, 10) >> 8);
+    if (!_test_lz_reject(large, strbuf_length(large))) succ = false;
+    strbuf_free(large);
+
+    // skippable frames are ignored, but not when truncated
+    char *skip = strbuf_new();
+    strbuf_append_bytes(&skip, "\x5A\x2A\x4D\x18\x03\0\0\0abc", 11);
+    strbuf_append_bytes(&skip, packed, len);
+    if (!_test_lz_check(skip, strbuf_length(skip), data, 4096, 1)) succ = false;
+    if (!_test_lz_reject(skip, 10)) succ = false;
+    strbuf_free(skip);
+
+    // a wrong magic number, version, descriptor checksum or block size, the header having a content size
+    p = (unsigned char *) packed;
+    size_t offsets[] = {0, 4, 14};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+        p[offsets[i]] ^= 0x80;
+        if (!_test_lz_reject(packed, len)) succ = false;
+        lz_decoder_init(&d);
+        dec = strbuf_new();
+        errno = 0;
+        if (lz_decoder_write(&d, &dec, packed, len) || errno != EINVAL) succ = false;
+        lz_decoder_free(&d);
+        strbuf_free(dec);
+        p[offsets[i]] ^= 0x80;
+    }
+    uint32_t v = _lz_read32(p + 15);
+    _lz_write32(p + 15, 0x7FFFFFFFU);
+    if (!_test_lz_reject(packed, len)) succ = false;
+    _lz_write32(p + 15, v);
+
+    // with a content checksum, a corrupted literal is rejected
+    p[4] |= _LZ_FLG_CONTENT_CHECKSUM;
+    p[14] = (unsigned char) (_lz_xxh(p + 4, 10) >> 8);
+    strbuf_append_bytes(&packed, "\0\0\0\0", 4);
+    p = (unsigned char *) packed;
+    _lz_write32(p + len, _lz_xxh((unsigned char *) data, 4096));
+    if (!_test_lz_check(packed, len + 4, data, 4096, 1)) succ = false;
+    // the last bytes of a block are literals, before the end mark
+    p[len - 5] ^= 1;
+    if (!_test_lz_reject(packed, len + 4)) succ = false;
+    p[len - 5] ^= 1;
+
+    // random corruption is either rejected or decoded within bounds
+    for (int i = 0; i < 500; ++i) {
+        char *copy = strbuf_clone(packed, false);
+        seed = seed * 1103515245 + 12345;
+        copy[(seed >> 8) % (len + 4)] ^= (char) (1 << (seed >> 28) % 8);
+        char *dest = strbuf_new();
+        errno = 0;
+        if (!lz_decompress(&dest, copy, len + 4, 1) && errno != EINVAL) succ = false;
+        strbuf_free(dest);
+        strbuf_free(copy);
+    }
+    strbuf_free(packed);
+    free(data);
+
+    PASS_IF(succ);
+}
+
 int main(void) {
     test_create_free();
     test_new_size();
@@ -341,6 +920,17 @@ int main(void) {
     test_append_int();
     test_append_long();
     test_append_llong();
+    test_strip_ansi();
+    test_display_width();
+    test_bytes();
+    test_literal();
+    test_varint();
+    test_fixed_width();
+    test_svb();
+    test_memmem();
+    test_regex();
+    test_parallel();
+    test_lz();
 
     B_SUMMARY();
     return 0;